@@ -53,11 +53,9 @@ if ! [[ $? -eq 0 ]]; then
 	exit 1
 fi
 
-# Copy executable and kernels to dist directory
+# Copy executable to dist directory (the kernel files are embedded into it)
 mkdir -p ../dist
-mkdir -p ../dist/kernels
 cp main ../dist/main
-cp -a kernels/. ../dist/kernels
 
 # Run it with
 # cd ../dist
@@ -0,0 +1,60 @@
+# Create a C++ source file that contains all kernel files as constexpr string tables (and their
+# precompiled SPIR-V if it exists) so that the executable does not read them at runtime
+#
+# Usage: cmake -DKERNEL_DIR=<dir> -DSPIRV_DIR=<dir> -DOUTPUT_FILE=<file> -P EmbedKernels.cmake
+
+file(GLOB KERNEL_FILES "${KERNEL_DIR}/*.cl")
+list(SORT KERNEL_FILES)
+
+# Write the bytes of a file as string literals ("\xHH" escapes, 32 bytes per line)
+function(append_file_literal INPUT_FILE VARIABLE)
+	file(READ ${INPUT_FILE} HEX_CONTENT HEX)
+	string(LENGTH "${HEX_CONTENT}" HEX_LENGTH)
+	set(LITERAL "")
+	if (HEX_LENGTH EQUAL 0)
+		set(LITERAL "    \"\"\n")
+	else ()
+		math(EXPR LAST_OFFSET "${HEX_LENGTH} - 1")
+		foreach (OFFSET RANGE 0 ${LAST_OFFSET} 64)
+			string(SUBSTRING "${HEX_CONTENT}" ${OFFSET} 64 LINE)
+			string(REGEX REPLACE "([0-9a-f][0-9a-f])" "\\\\x\\1" LINE "${LINE}")
+			string(APPEND LITERAL "    \"${LINE}\"\n")
+		endforeach ()
+	endif ()
+	set(${VARIABLE} "${LITERAL}" PARENT_SCOPE)
+endfunction()
+
+set(CONTENT "// Generated by cmake/EmbedKernels.cmake from the kernel files, do not edit\n\n")
+string(APPEND CONTENT "#include \"embedded_kernels.hpp\"\n\nnamespace {\n\n")
+set(TABLE "")
+set(INDEX 0)
+foreach (KERNEL_FILE ${KERNEL_FILES})
+	get_filename_component(KERNEL_NAME ${KERNEL_FILE} NAME)
+	append_file_literal(${KERNEL_FILE} SOURCE_LITERAL)
+	string(APPEND CONTENT "// ${KERNEL_NAME}\nconstexpr char source${INDEX}[] =\n${SOURCE_LITERAL};\n")
+	set(IL_ENTRY "nullptr, 0")
+	if (SPIRV_DIR AND EXISTS "${SPIRV_DIR}/${KERNEL_NAME}.spv")
+		append_file_literal("${SPIRV_DIR}/${KERNEL_NAME}.spv" IL_LITERAL)
+		string(APPEND CONTENT "constexpr char il${INDEX}[] =\n${IL_LITERAL};\n")
+		set(IL_ENTRY "il${INDEX}, sizeof(il${INDEX}) - 1")
+	endif ()
+	string(APPEND CONTENT "\n")
+	string(APPEND TABLE "    { \"${KERNEL_NAME}\", source${INDEX}, sizeof(source${INDEX}) - 1, ${IL_ENTRY} },\n")
+	math(EXPR INDEX "${INDEX} + 1")
+endforeach ()
+string(APPEND CONTENT "}\n\n")
+
+if (INDEX EQUAL 0)
+	# Arrays must not be empty
+	set(TABLE "    { \"\", \"\", 0, nullptr, 0 },\n")
+endif ()
+string(APPEND CONTENT "const clrt::EmbeddedKernelFile embeddedKernelFiles[] = {\n${TABLE}};\n")
+string(APPEND CONTENT "const std::size_t embeddedKernelFileCount = ${INDEX};\n")
+
+# Only touch the file if the content changed (avoids recompiling it)
+if (EXISTS ${OUTPUT_FILE})
+	file(READ ${OUTPUT_FILE} OLD_CONTENT)
+endif ()
+if (NOT "${OLD_CONTENT}" STREQUAL "${CONTENT}")
+	file(WRITE ${OUTPUT_FILE} "${CONTENT}")
+endif ()
@@ -0,0 +1,12 @@
+#pragma once
+
+// Include project headers
+#include "runtime.hpp"
+
+// Include stl libraries
+#include <cstddef>
+
+// All files of src/kernels that CMake embeds into the executable (the source file that defines
+// them is generated by cmake/EmbedKernels.cmake in the build directory)
+extern const clrt::EmbeddedKernelFile embeddedKernelFiles[];
+extern const std::size_t embeddedKernelFileCount;
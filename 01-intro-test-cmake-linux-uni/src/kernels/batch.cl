@@ -0,0 +1,21 @@
+// Helpers of batched kernels that process many small jobs with one NDRange
+//
+// The jobs are packed behind each other into one buffer, the offsets table has job count + 1
+// entries and the elements of job i are offsets[i] <= index < offsets[i + 1]
+
+// Find the job of a packed element (binary search for the last job that starts before or at the
+// element, empty jobs are skipped)
+uint batch_find_job(global const uint* offsets, const uint jobCount, const uint index)
+{
+    uint first = 0;
+    uint last = jobCount;
+    while (last - first > 1) {
+        const uint middle = first + (last - first) / 2;
+        if (offsets[middle] <= index) {
+            first = middle;
+        } else {
+            last = middle;
+        }
+    }
+    return first;
+}
@@ -1,10 +1,96 @@
 uint externalMethodCall(const uint test);
+uint mixBits(uint value);
+uint batch_find_job(global const uint* offsets, const uint jobCount, const uint index);
+uint storage_store_block(global uint* output, const ulong block, const int* values);
+
+// Names and lane indices of the int vectors with VECTOR_WIDTH (1, 4, 8 or 16) elements
+#ifndef VECTOR_WIDTH
+#define VECTOR_WIDTH 1
+#endif
+#define CONCAT_NAME(a, b) a ## b
+#define VECTOR_NAME(a, b) CONCAT_NAME(a, b)
+#if VECTOR_WIDTH == 4
+#define VECTOR_LANES (int4)(0, 1, 2, 3)
+#elif VECTOR_WIDTH == 8
+#define VECTOR_LANES (int8)(0, 1, 2, 3, 4, 5, 6, 7)
+#elif VECTOR_WIDTH == 16
+#define VECTOR_LANES (int16)(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15)
+#endif
+
+// Block size of the storage format (same default as storage.cl, which is linked with this file)
+#ifndef STORAGE_BLOCK
+#define STORAGE_BLOCK 32
+#endif
 
 void kernel simple(global int* output) {
-    const uint countX = get_global_id(0);
-    output[countX] = countX;
+    const size_t countX = get_global_id(0);
+    // The buffer can also be a chunk of the whole array that starts at the global offset
+    output[countX - get_global_offset(0)] = countX;
 	// Uncomment the following line to check if methods defined in another cl file can be used
 	// output[countX] = externalMethodCall(countX + 1);
 	// Uncomment the following line to check if external definitions can be read
 	// output[countX] = MAX_WG_SIZE;
 }
+
+// Batched version of simple: Many small arrays are packed into one buffer (see batch.cl) and
+// every array is filled with its own indices
+void kernel simpleBatched(global int* output, global const uint* offsets, const uint jobCount) {
+    const uint index = get_global_id(0);
+    const uint job = batch_find_job(offsets, jobCount, index);
+    output[index] = index - offsets[job];
+}
+
+// Vectorized version of simple: Every work item writes VECTOR_WIDTH elements with one vector
+// store (less work items to schedule and full SIMD width on CPU devices), the last work item
+// writes the rest one by one if the count is not a multiple of the width
+void kernel simpleVector(global int* output, const ulong count) {
+    const ulong first = get_global_id(0) * VECTOR_WIDTH;
+#if VECTOR_WIDTH == 1
+    if (first < count) {
+        output[first] = first;
+    }
+#else
+    if (first + VECTOR_WIDTH <= count) {
+        VECTOR_NAME(vstore, VECTOR_WIDTH)(VECTOR_LANES + (int)first, get_global_id(0), output);
+    } else {
+        for (ulong i = first; i < count; i++) {
+            output[i] = i;
+        }
+    }
+#endif
+}
+
+// Compact version of simple: Every work item packs a block of STORAGE_BLOCK elements in the
+// storage format of storage.cl (the last block repeats the last index) and counts the blocks
+// that did not fit into the format
+void kernel simplePacked(global uint* output, const ulong count, global uint* overflowCount) {
+    const ulong block = get_global_id(0);
+    int values[STORAGE_BLOCK];
+    for (uint i = 0; i < STORAGE_BLOCK; i++) {
+        values[i] = min(block * STORAGE_BLOCK + i, count - 1);
+    }
+    if (storage_store_block(output, block, values)) {
+        atomic_inc(overflowCount);
+    }
+}
+
+// Element-wise stages of a clrt::Pipeline: Every map kernel applies its function to one element,
+// the pipeline can replace consecutive maps with one generated kernel that calls their functions
+// one after the other without storing the intermediate values
+#define MAP_KERNEL(name, function) \
+void kernel name(global const uint* input, global uint* output, const ulong count) { \
+    const ulong index = get_global_id(0); \
+    if (index < count) { \
+        output[index] = function(input[index]); \
+    } \
+}
+
+MAP_KERNEL(mapExternal, externalMethodCall)
+MAP_KERNEL(mapMix, mixBits)
+
+// In-place version of mapMix for the file streaming: The buffer is a chunk of the file that
+// starts at the global offset
+void kernel mixInPlace(global uint* data) {
+    const size_t index = get_global_id(0) - get_global_offset(0);
+    data[index] = mixBits(data[index]);
+}
@@ -1,4 +1,14 @@
 uint externalMethodCall(const uint test)
 {
 	return test - 1;
-}
\ No newline at end of file
+}
+
+// Scramble the bits of a value (finalizer of MurmurHash3)
+uint mixBits(uint value)
+{
+	value ^= value >> 16;
+	value *= 0x85EBCA6BU;
+	value ^= value >> 13;
+	value *= 0xC2B2AE35U;
+	return value ^ (value >> 16);
+}
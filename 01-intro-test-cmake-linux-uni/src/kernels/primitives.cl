@@ -0,0 +1,130 @@
+// Device primitives of 32 bit integer arrays: prefix sums (scan), stream compaction and
+// histograms
+//
+// Scans of arrays of any size run on multiple levels: scan_blocks scans blocks of
+// 2 * local size elements and writes the sum of every block, the block sums are scanned the same
+// way (until a single block is left) and scan_add_offsets adds the scanned block sums to the
+// elements of their blocks
+// The compaction flags the elements that fulfill the predicate, scans the flags into the output
+// positions and scatters the elements (and their count) without reading anything back
+
+uint scan_exclusive_local(local uint* data);
+
+// Predicates of the compaction (same values as clrt::CompactPredicate)
+#define COMPACT_LESS 0
+#define COMPACT_LESS_EQUAL 1
+#define COMPACT_GREATER 2
+#define COMPACT_GREATER_EQUAL 3
+#define COMPACT_EQUAL 4
+#define COMPACT_NOT_EQUAL 5
+
+// The scanned output can be the input buffer (every work item only reads its own elements
+// before it writes them)
+void kernel scan_blocks(global const uint* input, global uint* output, global uint* blockSums,
+                        const ulong count, const uint inclusive, local uint* scratch)
+{
+    const uint localId = get_local_id(0);
+    const uint localSize = get_local_size(0);
+    // Both halves of the block are read and written coalesced
+    const ulong first = get_group_id(0) * 2 * (ulong) localSize + localId;
+    const ulong second = first + localSize;
+    const uint firstValue = first < count ? input[first] : 0;
+    const uint secondValue = second < count ? input[second] : 0;
+    scratch[localId] = firstValue;
+    scratch[localId + localSize] = secondValue;
+    const uint total = scan_exclusive_local(scratch);
+    if (first < count) {
+        output[first] = scratch[localId] + (inclusive ? firstValue : 0);
+    }
+    if (second < count) {
+        output[second] = scratch[localId + localSize] + (inclusive ? secondValue : 0);
+    }
+    if (localId == 0) {
+        blockSums[get_group_id(0)] = total;
+    }
+}
+
+// Launched with the same work groups as scan_blocks, blockOffsets are the scanned block sums
+void kernel scan_add_offsets(global uint* output, global const uint* blockOffsets,
+                             const ulong count)
+{
+    const uint offset = blockOffsets[get_group_id(0)];
+    const ulong first = get_group_id(0) * 2 * (ulong) get_local_size(0) + get_local_id(0);
+    const ulong second = first + get_local_size(0);
+    if (first < count) {
+        output[first] += offset;
+    }
+    if (second < count) {
+        output[second] += offset;
+    }
+}
+
+uint compact_matches(const int value, const int predicate, const int operand)
+{
+    switch (predicate) {
+    case COMPACT_LESS:
+        return value < operand;
+    case COMPACT_LESS_EQUAL:
+        return value <= operand;
+    case COMPACT_GREATER:
+        return value > operand;
+    case COMPACT_GREATER_EQUAL:
+        return value >= operand;
+    case COMPACT_EQUAL:
+        return value == operand;
+    default:
+        return value != operand;
+    }
+}
+
+void kernel compact_flags(global const int* input, global uint* flags, const ulong count,
+                          const int predicate, const int operand)
+{
+    for (size_t i = get_global_id(0); i < count; i += get_global_size(0)) {
+        flags[i] = compact_matches(input[i], predicate, operand);
+    }
+}
+
+// The positions are the exclusive scan of the flags, the predicate is evaluated again instead of
+// reading the flags that were replaced by the scan
+void kernel compact_scatter(global const int* input, global const uint* positions,
+                            global int* output, global uint* outputCount, const ulong count,
+                            const int predicate, const int operand)
+{
+    for (size_t i = get_global_id(0); i < count; i += get_global_size(0)) {
+        const uint matches = compact_matches(input[i], predicate, operand);
+        if (matches) {
+            output[positions[i]] = input[i];
+        }
+        if (i == count - 1) {
+            *outputCount = positions[i] + matches;
+        }
+    }
+}
+
+// Histogram of binCount bins of the same width over [minValue, maxValue) (other values are not
+// counted): Every work group counts its elements in local memory and adds its bins to the
+// global bins (that have to be zero) at the end, so the global atomics do not depend on the
+// number of elements
+void kernel histogram_int(global const int* input, const ulong count, global uint* bins,
+                          const uint binCount, const int minValue, const int maxValue,
+                          local uint* localBins)
+{
+    for (uint i = get_local_id(0); i < binCount; i += get_local_size(0)) {
+        localBins[i] = 0;
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+    const ulong range = (ulong) ((long) maxValue - minValue);
+    for (size_t i = get_global_id(0); i < count; i += get_global_size(0)) {
+        const long offset = (long) input[i] - minValue;
+        if (offset >= 0 && (ulong) offset < range) {
+            atomic_inc(&localBins[(ulong) offset * binCount / range]);
+        }
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+    for (uint i = get_local_id(0); i < binCount; i += get_local_size(0)) {
+        if (localBins[i] > 0) {
+            atomic_add(&bins[i], localBins[i]);
+        }
+    }
+}
@@ -0,0 +1,131 @@
+// Least significant digit radix sort of 32 or 64 bit keys (KEY_BITS) with optional uint values
+//
+// Every pass sorts the keys stably by the RADIX_BITS digit at the bit position shift:
+// - radix_histogram counts the digits of the block of every work group
+// - the histograms (digit major: all work groups of digit 0, all of digit 1, ...) are scanned
+//   exclusively on the device, which gives every work group the first output position of each
+//   of its digits
+// - radix_scatter/radix_scatter_pairs read the block again in chunks of 2 * local size keys,
+//   rank the keys of a chunk with work group scans of the digit flags and write them to their
+//   output positions
+// Signed keys (SIGNED_KEYS) are sorted as unsigned keys with a flipped sign bit
+// The work group size has to be a power of two of at least RADIX_SIZE and at most 16384 (the
+// count of a digit in a chunk of 2 * local size keys has to fit into 16 bits)
+
+uint scan_exclusive_local(local uint* data);
+
+#ifndef KEY_BITS
+#define KEY_BITS 32
+#endif
+#ifndef SIGNED_KEYS
+#define SIGNED_KEYS 0
+#endif
+
+#define RADIX_BITS 4
+#define RADIX_SIZE (1 << RADIX_BITS)
+// The flags of two digits are scanned at once in the low and the high 16 bits
+#define RADIX_HALF (RADIX_SIZE / 2)
+
+#if KEY_BITS == 64
+typedef ulong radix_key;
+#define SIGN_BIT (1UL << 63)
+#else
+typedef uint radix_key;
+#define SIGN_BIT (1U << 31)
+#endif
+
+#if SIGNED_KEYS
+#define KEY_DIGIT(key, shift) ((uint) ((((key) ^ SIGN_BIT) >> (shift)) & (RADIX_SIZE - 1)))
+#else
+#define KEY_DIGIT(key, shift) ((uint) (((key) >> (shift)) & (RADIX_SIZE - 1)))
+#endif
+
+void kernel radix_histogram(global const radix_key* keys, global uint* histograms,
+                            const ulong count, const ulong blockSize, const uint shift)
+{
+    local uint digitCounts[RADIX_SIZE];
+    const uint localId = get_local_id(0);
+    if (localId < RADIX_SIZE) {
+        digitCounts[localId] = 0;
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+    const ulong begin = get_group_id(0) * blockSize;
+    const ulong end = min(count, begin + blockSize);
+    for (ulong i = begin + localId; i < end; i += get_local_size(0)) {
+        atomic_inc(&digitCounts[KEY_DIGIT(keys[i], shift)]);
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+    if (localId < RADIX_SIZE) {
+        histograms[localId * get_num_groups(0) + get_group_id(0)] = digitCounts[localId];
+    }
+}
+
+// Position of a key in the output: The offset of its digit plus the number of keys with the same
+// digit before it in the chunk (keys outside of the block have the digit RADIX_SIZE)
+#define RADIX_RANK(digit, flags, digitOffsets, pass, position) \
+    do { \
+        if ((digit) == (pass)) { \
+            position = digitOffsets[pass] + ((flags) & 0xFFFF); \
+        } else if ((digit) == (pass) + RADIX_HALF) { \
+            position = digitOffsets[(pass) + RADIX_HALF] + ((flags) >> 16); \
+        } \
+    } while (0)
+
+#define RADIX_FLAGS(digit, pass) \
+    ((uint) ((digit) == (pass)) | ((uint) ((digit) == (pass) + RADIX_HALF) << 16))
+
+// The offsets are the scanned histograms
+#define RADIX_SCATTER_KERNEL(NAME, VALUE_ARGUMENTS, COPY_VALUE) \
+    void kernel NAME(global const radix_key* keys, global radix_key* outputKeys, \
+                     VALUE_ARGUMENTS global const uint* offsets, const ulong count, \
+                     const ulong blockSize, const uint shift, local uint* scratch) \
+    { \
+        local uint digitOffsets[RADIX_SIZE]; \
+        const uint localId = get_local_id(0); \
+        const uint localSize = get_local_size(0); \
+        if (localId < RADIX_SIZE) { \
+            digitOffsets[localId] = offsets[localId * get_num_groups(0) + get_group_id(0)]; \
+        } \
+        const ulong begin = get_group_id(0) * blockSize; \
+        const ulong end = min(count, begin + blockSize); \
+        for (ulong chunk = begin; chunk < end; chunk += 2 * localSize) { \
+            const ulong first = chunk + localId; \
+            const ulong second = first + localSize; \
+            const radix_key firstKey = first < end ? keys[first] : 0; \
+            const radix_key secondKey = second < end ? keys[second] : 0; \
+            const uint firstDigit = first < end ? KEY_DIGIT(firstKey, shift) : RADIX_SIZE; \
+            const uint secondDigit = second < end ? KEY_DIGIT(secondKey, shift) : RADIX_SIZE; \
+            uint firstPosition = 0; \
+            uint secondPosition = 0; \
+            for (uint pass = 0; pass < RADIX_HALF; pass++) { \
+                scratch[localId] = RADIX_FLAGS(firstDigit, pass); \
+                scratch[localId + localSize] = RADIX_FLAGS(secondDigit, pass); \
+                const uint total = scan_exclusive_local(scratch); \
+                RADIX_RANK(firstDigit, scratch[localId], digitOffsets, pass, firstPosition); \
+                RADIX_RANK(secondDigit, scratch[localId + localSize], digitOffsets, pass, \
+                           secondPosition); \
+                /* All work items have to read the offsets before they are moved on */ \
+                barrier(CLK_LOCAL_MEM_FENCE); \
+                if (localId == 0) { \
+                    digitOffsets[pass] += total & 0xFFFF; \
+                    digitOffsets[pass + RADIX_HALF] += total >> 16; \
+                } \
+            } \
+            if (first < end) { \
+                outputKeys[firstPosition] = firstKey; \
+                COPY_VALUE(first, firstPosition); \
+            } \
+            if (second < end) { \
+                outputKeys[secondPosition] = secondKey; \
+                COPY_VALUE(second, secondPosition); \
+            } \
+        } \
+    }
+
+#define NO_VALUES
+#define NO_VALUE_COPY(index, position)
+#define VALUES global const uint* values, global uint* outputValues,
+#define VALUE_COPY(index, position) outputValues[position] = values[index]
+
+RADIX_SCATTER_KERNEL(radix_scatter, NO_VALUES, NO_VALUE_COPY)
+RADIX_SCATTER_KERNEL(radix_scatter_pairs, VALUES, VALUE_COPY)
@@ -0,0 +1,162 @@
+// Work group reductions (sum, min, max, count of mismatches and argmin) of int arrays
+//
+// Every reduction runs in two stages: The first stage is launched with multiple work groups
+// that accumulate the elements with a grid stride loop in private memory, reduce the private
+// values of the work group (with subgroup functions if USE_SUBGROUPS is defined, otherwise with
+// a tree in local memory) and write one partial result per work group, the second stage reduces
+// the partial results with a single work group
+//
+// The work group size has to be a power of two and the local scratch memory has to hold one
+// value per work item
+
+#if defined(USE_SUBGROUPS) && defined(cl_khr_subgroups)
+#pragma OPENCL EXTENSION cl_khr_subgroups : enable
+#endif
+
+#define SUM(a, b) ((a) + (b))
+#define MIN(a, b) min(a, b)
+#define MAX(a, b) max(a, b)
+
+#ifdef USE_SUBGROUPS
+// Reduce the subgroups with the subgroup function and the subgroup results in local memory
+#define REDUCE_WORK_GROUP(TYPE, OP, SUB_GROUP_OP, IDENTITY, value, scratch) \
+    do { \
+        value = SUB_GROUP_OP(value); \
+        if (get_sub_group_local_id() == 0) { \
+            scratch[get_sub_group_id()] = value; \
+        } \
+        barrier(CLK_LOCAL_MEM_FENCE); \
+        if (get_sub_group_id() == 0) { \
+            TYPE subGroupValue = IDENTITY; \
+            for (uint i = get_sub_group_local_id(); i < get_num_sub_groups(); \
+                 i += get_sub_group_size()) { \
+                subGroupValue = OP(subGroupValue, scratch[i]); \
+            } \
+            value = SUB_GROUP_OP(subGroupValue); \
+        } \
+    } while (0)
+#else
+// Tree reduction in local memory
+#define REDUCE_WORK_GROUP(TYPE, OP, SUB_GROUP_OP, IDENTITY, value, scratch) \
+    do { \
+        const size_t localId = get_local_id(0); \
+        scratch[localId] = value; \
+        barrier(CLK_LOCAL_MEM_FENCE); \
+        for (size_t stride = get_local_size(0) / 2; stride > 0; stride /= 2) { \
+            if (localId < stride) { \
+                scratch[localId] = OP(scratch[localId], scratch[localId + stride]); \
+            } \
+            barrier(CLK_LOCAL_MEM_FENCE); \
+        } \
+        value = scratch[0]; \
+    } while (0)
+#endif
+
+// Reduction of the elements of an array of IN_TYPE into one OUT_TYPE per work group
+#define REDUCE_KERNEL(NAME, IN_TYPE, OUT_TYPE, OP, SUB_GROUP_OP, IDENTITY) \
+    void kernel NAME(global const IN_TYPE* input, const ulong count, global OUT_TYPE* output, \
+                     local OUT_TYPE* scratch) \
+    { \
+        OUT_TYPE value = IDENTITY; \
+        for (size_t i = get_global_id(0); i < count; i += get_global_size(0)) { \
+            value = OP(value, (OUT_TYPE) input[i]); \
+        } \
+        REDUCE_WORK_GROUP(OUT_TYPE, OP, SUB_GROUP_OP, IDENTITY, value, scratch); \
+        if (get_local_id(0) == 0) { \
+            output[get_group_id(0)] = value; \
+        } \
+    }
+
+REDUCE_KERNEL(reduce_sum_int, int, long, SUM, sub_group_reduce_add, 0)
+REDUCE_KERNEL(reduce_sum_long, long, long, SUM, sub_group_reduce_add, 0)
+REDUCE_KERNEL(reduce_min_int, int, int, MIN, sub_group_reduce_min, INT_MAX)
+REDUCE_KERNEL(reduce_max_int, int, int, MAX, sub_group_reduce_max, INT_MIN)
+
+// Count the elements that are not equal to the reference array (the second stage is
+// reduce_sum_long)
+void kernel count_mismatches_int(global const int* input, global const int* reference,
+                                 const ulong count, global long* output, local long* scratch)
+{
+    long value = 0;
+    for (size_t i = get_global_id(0); i < count; i += get_global_size(0)) {
+        value += input[i] != reference[i];
+    }
+    REDUCE_WORK_GROUP(long, SUM, sub_group_reduce_add, 0, value, scratch);
+    if (get_local_id(0) == 0) {
+        output[get_group_id(0)] = value;
+    }
+}
+
+// Count the elements that are not equal to first + index (e.g. to validate index sequences
+// without a reference array, the second stage is reduce_sum_long)
+void kernel count_index_mismatches_int(global const int* input, const ulong count,
+                                       const int first, global long* output, local long* scratch)
+{
+    long value = 0;
+    for (size_t i = get_global_id(0); i < count; i += get_global_size(0)) {
+        // Wrap around like the host (the unsigned addition has no undefined overflow)
+        value += input[i] != (int) ((uint) first + (uint) i);
+    }
+    REDUCE_WORK_GROUP(long, SUM, sub_group_reduce_add, 0, value, scratch);
+    if (get_local_id(0) == 0) {
+        output[get_group_id(0)] = value;
+    }
+}
+
+// Smallest value and its (first) index, the first stage uses the array positions as indices and
+// the second stage the indices of the first stage
+void argmin(int value, long index, global int* outputValues, global long* outputIndices,
+            local int* scratchValues, local long* scratchIndices)
+{
+    int minValue = value;
+    REDUCE_WORK_GROUP(int, MIN, sub_group_reduce_min, INT_MAX, minValue, scratchValues);
+#ifdef USE_SUBGROUPS
+    // Only the first subgroup has the minimum so it is shared with the whole work group
+    barrier(CLK_LOCAL_MEM_FENCE);
+    if (get_local_id(0) == 0) {
+        scratchValues[0] = minValue;
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+    minValue = scratchValues[0];
+#endif
+    // The index of the smallest value is the smallest index of all work items that have it
+    if (value != minValue) {
+        index = LONG_MAX;
+    }
+    REDUCE_WORK_GROUP(long, MIN, sub_group_reduce_min, LONG_MAX, index, scratchIndices);
+    if (get_local_id(0) == 0) {
+        outputValues[get_group_id(0)] = minValue;
+        outputIndices[get_group_id(0)] = index;
+    }
+}
+
+void kernel argmin_int(global const int* input, const ulong count, global int* outputValues,
+                       global long* outputIndices, local int* scratchValues,
+                       local long* scratchIndices)
+{
+    int value = INT_MAX;
+    long index = LONG_MAX;
+    for (size_t i = get_global_id(0); i < count; i += get_global_size(0)) {
+        if (input[i] < value || index == LONG_MAX) {
+            value = input[i];
+            index = i;
+        }
+    }
+    argmin(value, index, outputValues, outputIndices, scratchValues, scratchIndices);
+}
+
+void kernel argmin_indexed_int(global const int* inputValues, global const long* inputIndices,
+                               const ulong count, global int* outputValues,
+                               global long* outputIndices, local int* scratchValues,
+                               local long* scratchIndices)
+{
+    int value = INT_MAX;
+    long index = LONG_MAX;
+    for (size_t i = get_global_id(0); i < count; i += get_global_size(0)) {
+        if (inputValues[i] < value || (inputValues[i] == value && inputIndices[i] < index)) {
+            value = inputValues[i];
+            index = inputIndices[i];
+        }
+    }
+    argmin(value, index, outputValues, outputIndices, scratchValues, scratchIndices);
+}
@@ -0,0 +1,40 @@
+// Work group scan that is linked into the programs of the primitives (see primitives.cl)
+
+// Work efficient (Blelloch) exclusive scan of the 2 * local size values in local memory: The
+// up-sweep builds a tree of partial sums in place and the down-sweep distributes them, both
+// only need n - 1 additions
+// The local size has to be a power of two and all work items of the group have to call it,
+// the result is the sum of all values
+uint scan_exclusive_local(local uint* data)
+{
+    const uint localId = get_local_id(0);
+    const uint n = 2 * get_local_size(0);
+    uint offset = 1;
+    for (uint d = n / 2; d > 0; d /= 2) {
+        barrier(CLK_LOCAL_MEM_FENCE);
+        if (localId < d) {
+            data[offset * (2 * localId + 2) - 1] += data[offset * (2 * localId + 1) - 1];
+        }
+        offset *= 2;
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+    const uint total = data[n - 1];
+    // Every work item has to read the total before it is replaced
+    barrier(CLK_LOCAL_MEM_FENCE);
+    if (localId == 0) {
+        data[n - 1] = 0;
+    }
+    for (uint d = 1; d < n; d *= 2) {
+        offset /= 2;
+        barrier(CLK_LOCAL_MEM_FENCE);
+        if (localId < d) {
+            const uint left = offset * (2 * localId + 1) - 1;
+            const uint right = offset * (2 * localId + 2) - 1;
+            const uint value = data[left];
+            data[left] = data[right];
+            data[right] += value;
+        }
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+    return total;
+}
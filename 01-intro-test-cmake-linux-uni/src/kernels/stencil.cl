@@ -0,0 +1,116 @@
+// 2D stencils of single channel float images: Every pixel becomes the weighted sum of the
+// (2 * STENCIL_RADIUS + 1)^2 pixels around it (convolution), pixels outside of the image are
+// clamped to the nearest edge pixel
+//
+// All versions compute the same values and only differ in where they read the neighbourhood:
+// - stencil_naive reads every pixel of the neighbourhood from global memory
+// - stencil_tiled stages the tile of its work group and the halo around it in local memory
+//   (with async_work_group_copy) so every pixel is read only once from global memory, it has to
+//   be launched with work groups of TILE_WIDTH x TILE_HEIGHT work items
+// - stencil_image reads the neighbourhood from an image (the texture cache keeps the
+//   neighbourhood of close pixels), it only exists if the device supports images
+// The global range can be rounded up to whole tiles, work items outside of the image only help
+// to load the tile
+
+#ifndef STENCIL_RADIUS
+#define STENCIL_RADIUS 1
+#endif
+#ifndef TILE_WIDTH
+#define TILE_WIDTH 16
+#endif
+#ifndef TILE_HEIGHT
+#define TILE_HEIGHT 16
+#endif
+
+// The offsets and halo coordinates are signed, so the constants are used as ints even if they
+// are defined as unsigned literals
+#define RADIUS ((int) STENCIL_RADIUS)
+#define STENCIL_SIZE (2 * RADIUS + 1)
+#define HALO_WIDTH ((int) TILE_WIDTH + 2 * RADIUS)
+#define HALO_HEIGHT ((int) TILE_HEIGHT + 2 * RADIUS)
+
+// Template of all versions: LOAD(dx, dy) reads the pixel at the offset (dx, dy) of the center
+#define STENCIL_APPLY(LOAD, weights, result) \
+    do { \
+        result = 0.0f; \
+        for (int dy = -RADIUS; dy <= RADIUS; dy++) { \
+            for (int dx = -RADIUS; dx <= RADIUS; dx++) { \
+                result += weights[(dy + RADIUS) * STENCIL_SIZE + dx + RADIUS] \
+                          * LOAD(dx, dy); \
+            } \
+        } \
+    } while (0)
+
+void kernel stencil_naive(global const float* input, global float* output,
+                          constant float* weights, const int width, const int height) {
+    const int x = get_global_id(0);
+    const int y = get_global_id(1);
+    if (x >= width || y >= height) {
+        return;
+    }
+#define LOAD_GLOBAL(dx, dy) \
+    input[clamp(y + (dy), 0, height - 1) * width + clamp(x + (dx), 0, width - 1)]
+    float result;
+    STENCIL_APPLY(LOAD_GLOBAL, weights, result);
+    output[y * width + x] = result;
+}
+
+void kernel __attribute__((reqd_work_group_size(TILE_WIDTH, TILE_HEIGHT, 1)))
+stencil_tiled(global const float* input, global float* output, constant float* weights,
+              const int width, const int height) {
+    local float tile[HALO_HEIGHT][HALO_WIDTH];
+    // Image coordinates of the first pixel of the halo
+    const int tileX = (int) get_group_id(0) * (int) TILE_WIDTH - RADIUS;
+    const int tileY = (int) get_group_id(1) * (int) TILE_HEIGHT - RADIUS;
+    const int localX = get_local_id(0);
+    const int localY = get_local_id(1);
+
+    if (tileX >= 0 && tileY >= 0 && tileX + HALO_WIDTH <= width
+        && tileY + HALO_HEIGHT <= height) {
+        // The halo is inside of the image: The work group copies every row with one
+        // asynchronous copy (all copies share one event)
+        event_t event = 0;
+        for (int row = 0; row < HALO_HEIGHT; row++) {
+            event = async_work_group_copy(tile[row], input + (tileY + row) * width + tileX,
+                                          HALO_WIDTH, event);
+        }
+        wait_group_events(1, &event);
+    } else {
+        // Border tiles need clamped coordinates that copies cannot apply
+        for (int row = localY; row < HALO_HEIGHT; row += (int) TILE_HEIGHT) {
+            for (int column = localX; column < HALO_WIDTH; column += (int) TILE_WIDTH) {
+                tile[row][column] = input[clamp(tileY + row, 0, height - 1) * width
+                                          + clamp(tileX + column, 0, width - 1)];
+            }
+        }
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    const int x = get_global_id(0);
+    const int y = get_global_id(1);
+    if (x >= width || y >= height) {
+        return;
+    }
+#define LOAD_LOCAL(dx, dy) tile[localY + RADIUS + (dy)][localX + RADIUS + (dx)]
+    float result;
+    STENCIL_APPLY(LOAD_LOCAL, weights, result);
+    output[y * width + x] = result;
+}
+
+#ifdef __IMAGE_SUPPORT__
+constant sampler_t stencilSampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP_TO_EDGE
+                                    | CLK_FILTER_NEAREST;
+
+void kernel stencil_image(read_only image2d_t input, global float* output,
+                          constant float* weights, const int width, const int height) {
+    const int x = get_global_id(0);
+    const int y = get_global_id(1);
+    if (x >= width || y >= height) {
+        return;
+    }
+#define LOAD_IMAGE(dx, dy) read_imagef(input, stencilSampler, (int2)(x + (dx), y + (dy))).x
+    float result;
+    STENCIL_APPLY(LOAD_IMAGE, weights, result);
+    output[y * width + x] = result;
+}
+#endif
@@ -0,0 +1,149 @@
+// Compact storage of int arrays in blocks of STORAGE_BLOCK elements that kernels pack and unpack
+// themselves, so that less bytes are transferred (the format is the same as the one of
+// clrt::StorageCodec on the host)
+//
+// STORAGE_MODE selects the format of a block (a block is always a whole number of uints):
+// - STORAGE_INT32: The values (4 bytes per element)
+// - STORAGE_INT16: The lower 16 bits of the values (2 bytes, values outside of the short range
+//   are truncated)
+// - STORAGE_HALF: The values as half floats with vstore_half (2 bytes, exact up to 2048 and
+//   rounded to the nearest half above)
+// - STORAGE_PACKED: The smallest value of the block followed by the offsets of all values to it
+//   with PACK_BITS bits each (frame of reference)
+// - STORAGE_DELTA: The first value of the block followed by the differences to the previous
+//   values with PACK_BITS bits each (zigzag encoded, so small negative differences stay small)
+// Offsets and differences that do not fit into PACK_BITS bits are truncated, storing a block
+// returns 1 if that happened
+
+#define STORAGE_INT32 0
+#define STORAGE_INT16 1
+#define STORAGE_HALF 2
+#define STORAGE_PACKED 3
+#define STORAGE_DELTA 4
+
+#ifndef STORAGE_MODE
+#define STORAGE_MODE STORAGE_INT32
+#endif
+#ifndef STORAGE_BLOCK
+#define STORAGE_BLOCK 32
+#endif
+#ifndef PACK_BITS
+#define PACK_BITS 8
+#endif
+
+#if STORAGE_MODE == STORAGE_INT32
+#define STORAGE_BLOCK_WORDS STORAGE_BLOCK
+#elif STORAGE_MODE == STORAGE_INT16 || STORAGE_MODE == STORAGE_HALF
+#define STORAGE_BLOCK_WORDS (STORAGE_BLOCK / 2)
+#else
+#define STORAGE_BLOCK_WORDS (1 + STORAGE_BLOCK * PACK_BITS / 32)
+#define PACK_MASK ((1U << PACK_BITS) - 1)
+#endif
+
+uint storage_store_block(global uint* output, const ulong block, const int* values)
+{
+    global uint* words = output + block * STORAGE_BLOCK_WORDS;
+#if STORAGE_MODE == STORAGE_INT32
+    for (uint i = 0; i < STORAGE_BLOCK; i++) {
+        words[i] = values[i];
+    }
+    return 0;
+#elif STORAGE_MODE == STORAGE_INT16
+    global short* shorts = (global short*) words;
+    for (uint i = 0; i < STORAGE_BLOCK; i++) {
+        shorts[i] = (short) values[i];
+    }
+    return 0;
+#elif STORAGE_MODE == STORAGE_HALF
+    global half* halves = (global half*) words;
+    for (uint i = 0; i < STORAGE_BLOCK; i++) {
+        vstore_half((float) values[i], i, halves);
+    }
+    return 0;
+#else
+    // The unsigned arithmetic wraps around like the host
+    uint offsets[STORAGE_BLOCK];
+    int base = values[0];
+#if STORAGE_MODE == STORAGE_PACKED
+    for (uint i = 1; i < STORAGE_BLOCK; i++) {
+        base = min(base, values[i]);
+    }
+    for (uint i = 0; i < STORAGE_BLOCK; i++) {
+        offsets[i] = (uint) values[i] - (uint) base;
+    }
+#else
+    offsets[0] = 0;
+    for (uint i = 1; i < STORAGE_BLOCK; i++) {
+        const int delta = (int) ((uint) values[i] - (uint) values[i - 1]);
+        offsets[i] = ((uint) delta << 1) ^ (uint) (delta >> 31);
+    }
+#endif
+    uint packed[STORAGE_BLOCK_WORDS - 1];
+    for (uint word = 0; word < STORAGE_BLOCK_WORDS - 1; word++) {
+        packed[word] = 0;
+    }
+    uint overflow = 0;
+    for (uint i = 0; i < STORAGE_BLOCK; i++) {
+        overflow |= offsets[i] > PACK_MASK;
+        const uint value = offsets[i] & PACK_MASK;
+        const uint bit = i * PACK_BITS;
+        packed[bit / 32] |= value << (bit % 32);
+        // Values can continue in the next word
+        if (bit % 32 + PACK_BITS > 32) {
+            packed[bit / 32 + 1] |= value >> (32 - bit % 32);
+        }
+    }
+    words[0] = (uint) base;
+    for (uint word = 0; word < STORAGE_BLOCK_WORDS - 1; word++) {
+        words[1 + word] = packed[word];
+    }
+    return overflow;
+#endif
+}
+
+void storage_load_block(global const uint* input, const ulong block, int* values)
+{
+    global const uint* words = input + block * STORAGE_BLOCK_WORDS;
+#if STORAGE_MODE == STORAGE_INT32
+    for (uint i = 0; i < STORAGE_BLOCK; i++) {
+        values[i] = words[i];
+    }
+#elif STORAGE_MODE == STORAGE_INT16
+    global const short* shorts = (global const short*) words;
+    for (uint i = 0; i < STORAGE_BLOCK; i++) {
+        values[i] = shorts[i];
+    }
+#elif STORAGE_MODE == STORAGE_HALF
+    global const half* halves = (global const half*) words;
+    for (uint i = 0; i < STORAGE_BLOCK; i++) {
+        values[i] = convert_int_sat_rte(vload_half(i, halves));
+    }
+#else
+    uint previous = words[0];
+    for (uint i = 0; i < STORAGE_BLOCK; i++) {
+        const uint bit = i * PACK_BITS;
+        uint value = words[1 + bit / 32] >> (bit % 32);
+        if (bit % 32 + PACK_BITS > 32) {
+            value |= words[2 + bit / 32] << (32 - bit % 32);
+        }
+        value &= PACK_MASK;
+#if STORAGE_MODE == STORAGE_PACKED
+        values[i] = (int) (words[0] + value);
+#else
+        previous += i == 0 ? 0 : (value >> 1) ^ (0U - (value & 1));
+        values[i] = (int) previous;
+#endif
+    }
+#endif
+}
+
+// Unpack count elements into an int array (one block per work item)
+void kernel storage_unpack(global const uint* input, global int* output, const ulong count)
+{
+    const ulong block = get_global_id(0);
+    int values[STORAGE_BLOCK];
+    storage_load_block(input, block, values);
+    for (uint i = 0; i < STORAGE_BLOCK && block * STORAGE_BLOCK + i < count; i++) {
+        output[block * STORAGE_BLOCK + i] = values[i];
+    }
+}
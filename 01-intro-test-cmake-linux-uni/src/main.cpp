@@ -2,32 +2,200 @@
 #define CL_HPP_TARGET_OPENCL_VERSION 200
 #include <CL/cl2.hpp>
 
+// Include project headers
+#include "batch.hpp"
+#include "benchmark.hpp"
+#include "device_registry.hpp"
+#include "embedded_kernels.hpp"
+#include "host_buffer.hpp"
+#include "host_engine.hpp"
+#include "job_server.hpp"
+#include "mapped_file.hpp"
+#include "pipeline.hpp"
+#include "primitives.hpp"
+#include "radix_sort.hpp"
+#include "reduction.hpp"
+#include "runtime.hpp"
+#include "scheduler.hpp"
+#include "stencil.hpp"
+#include "storage.hpp"
+#include "streaming.hpp"
+#include "task_graph.hpp"
+#include "trace.hpp"
+#include "tuner.hpp"
+
 // Include stl libraries
+#include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cmath>
-#include <fstream>
+#include <cstdlib>
+#include <functional>
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <random>
 #include <string>
+#include <thread>
 #include <sstream>
 #include <vector>
 
+// Command line options
+struct Options {
+    // Number of elements of the array
+    std::size_t size = 100000000;
+    // Process the array in chunks (is always done if it does not fit into a single buffer)
+    bool streaming = false;
+    // Number of elements per chunk (0 = biggest chunk that fits into the device memory)
+    std::size_t chunkSize = 0;
+    // Search the fastest work group size again even if one is stored in the tuning database
+    bool tune = false;
+    // Elements per work item of the vectorized kernel (0 = the fastest tuned width or the
+    // preferred int vector width of the device)
+    unsigned int vectorWidth = 0;
+    // Untimed runs before the timed repetitions of every benchmark
+    unsigned int warmUpCount = 2;
+    unsigned int repetitionCount = 10;
+    // Files to which the benchmark results are written (empty = none)
+    std::string jsonFile;
+    std::string csvFile;
+    // Additionally split the array across all devices that process it at the same time
+    bool allDevices = false;
+    // Process the array in independent slices with an asynchronous task graph (0 = off)
+    std::size_t graphSliceCount = 0;
+    // File to which a Chrome trace of all commands and host spans is written (empty = off)
+    std::string traceFile;
+    // Number of small arrays that are processed with batched and single launches (0 = off)
+    std::size_t batchJobCount = 0;
+    // Binary int file that is processed in chunks into the output file (empty = off)
+    std::string inputFile;
+    std::string outputFile;
+    // Maximum number of producer threads that submit jobs to a job server (0 = off)
+    unsigned int serveThreadCount = 0;
+    // Width/height of the image that is filtered with the 2D stencil versions (0 = off)
+    std::size_t stencilSize = 0;
+    unsigned int stencilRadius = 2;
+    // Work group/tile of the tiled stencil
+    std::size_t tileWidth = 16;
+    std::size_t tileHeight = 16;
+    // Number of elements that are scanned, compacted and counted in a histogram (0 = off)
+    std::size_t primitivesSize = 0;
+    // Maximum number of keys of the sort benchmark that sorts 1M, 10M, 100M and 1B keys (0 = off)
+    std::size_t sortSize = 0;
+    // Additionally transfer the array in a compact storage format that kernels pack and unpack
+    bool compactStorage = false;
+    clrt::StorageCodec storage;
+    // Number of elements of the pipeline of simple and element-wise maps (0 = off)
+    std::size_t pipelineSize = 0;
+};
+
+// Page aligned vector whose data can be used by devices without copying it
+typedef std::vector<int, clrt::AlignedAllocator<int>> HostVector;
+
+// Kernel that is equivalent to the host code
+const char *exampleKernelName = "simple";
+// Source files of the example kernels and the functions they call
+const std::vector<std::string> exampleSourceFiles = {
+    "kernel.cl",
+    "kernel_helper.cl",
+    "batch.cl",
+    "storage.cl"
+};
+// Kernel that processes many small arrays that are packed into one buffer with one launch
+const char *exampleBatchedKernelName = "simpleBatched";
+// Kernel that writes VECTOR_WIDTH elements per work item and the widths it is built with
+const char *exampleVectorKernelName = "simpleVector";
+const unsigned int exampleVectorWidths[] = { 1, 4, 8, 16 };
+// Kernel that writes the values of simple in a compact storage format
+const char *examplePackedKernelName = "simplePacked";
+// Element-wise kernels of the pipeline and the functions that they apply
+const char *examplePipelineMaps[][2] = {
+    { "mapExternal", "externalMethodCall" },
+    { "mapMix", "mixBits" }
+};
+// Kernel that transforms the chunks of the input file in place
+const char *exampleFileKernelName = "mixInPlace";
+// Biggest array of the batch mode (the sizes of the arrays vary up to it)
+constexpr std::size_t maxBatchJobElementCount = 4096;
+
 // Define functions that will be used in main but declared below it
-void runHostCode(std::vector<int> &outputVector);
-const bool runKernelOnOpenClDevice(cl::Device &device, std::vector<int> &outputVector,
-                                   const uint64_t &cpuTimeNs);
+const bool parseOptions(int argc, char **argv, Options &options);
+void runHostCode(clrt::HostEngine &hostEngine, HostVector &outputVector);
+const bool runKernelOnOpenClDevice(clrt::Runtime &runtime, clrt::WorkGroupTuner &tuner,
+                                   clrt::Benchmark &benchmark, cl::Device &device,
+                                   HostVector &outputVector, const uint64_t &cpuTimeNs,
+                                   const Options &options);
+const bool runBatchedKernelOnOpenClDevice(clrt::Runtime &runtime, clrt::Benchmark &benchmark,
+                                          cl::Device &device, const Options &options);
+const bool runKernelOnFile(clrt::Runtime &runtime, clrt::Benchmark &benchmark,
+                           cl::Device &device, const Options &options);
+const bool runStencilOnOpenClDevice(clrt::Runtime &runtime, clrt::Benchmark &benchmark,
+                                    cl::Device &device, const Options &options);
+const bool runPrimitivesOnOpenClDevice(clrt::Runtime &runtime, clrt::Benchmark &benchmark,
+                                       cl::Device &device, const Options &options);
+const bool runPackedKernelOnOpenClDevice(clrt::Runtime &runtime, clrt::Benchmark &benchmark,
+                                         cl::Device &device, const Options &options);
+const bool runPipelineOnOpenClDevice(clrt::Runtime &runtime, clrt::Benchmark &benchmark,
+                                     cl::Device &device, const Options &options);
+const bool runJobServerLoad(clrt::Runtime &runtime, const Options &options);
+const bool runSortBenchmark(clrt::Runtime &runtime, clrt::Benchmark &benchmark,
+                            clrt::HostEngine &hostEngine, const std::vector<cl::Device> &devices,
+                            const Options &options);
+template <typename Key>
+const bool runTypedSortBenchmark(clrt::Runtime &runtime, clrt::Benchmark &benchmark,
+                                 const std::vector<cl::Device> &devices,
+                                 const clrt::RadixKeyType &keyType, const std::string &typeName,
+                                 const std::size_t &count, std::mt19937 &generator);
+template <typename Key>
+const bool runRadixSortOnOpenClDevice(clrt::Runtime &runtime, clrt::Benchmark &benchmark,
+                                      const cl::Device &device, const clrt::RadixKeyType &keyType,
+                                      const std::string &typeName, const std::vector<Key> &keys,
+                                      const std::vector<Key> &sortedKeys,
+                                      const uint64_t &stdSortNs);
+const bool runKernelOnAllOpenClDevices(clrt::Runtime &runtime,
+                                       clrt::MultiDeviceScheduler &scheduler,
+                                       clrt::Benchmark &benchmark, HostVector &outputVector,
+                                       const uint64_t &cpuTimeNs);
+const clrt::Specialization createExampleConstants(const cl::Device &device,
+                                                  const unsigned int &vectorWidth,
+                                                  const clrt::StorageCodec &storage);
+const bool buildExampleProgram(clrt::Runtime &runtime, const cl::Device &device,
+                               clrt::Program &program, const unsigned int &vectorWidth = 1,
+                               const clrt::StorageCodec &storage = clrt::StorageCodec());
+const bool createVectorKernel(clrt::Runtime &runtime, clrt::WorkGroupTuner &tuner,
+                              const cl::Device &device, const cl::Buffer &buffer,
+                              const std::size_t &count, const Options &options,
+                              unsigned int &vectorWidth, std::string &widthSource,
+                              clrt::Kernel &kernel);
+const bool checkResults(const HostVector &outputVector);
+// Host version of mixBits of kernel_helper.cl
+const cl_uint mixBits(cl_uint value);
 inline const uint64_t getTimeInNs(cl::Event &openClEvent);
 inline const std::string displayTimeAndSpeedup(const uint64_t &timeNs,
                                                const bool &cpuComparison = false, const uint64_t &cpuTimeNs = 0);
 
 // Main method
-int main()
+int main(int argc, char **argv)
 {
     // Display hello world and date and time of compilation
     std::cout << "Hello World! (Compiled on " << __DATE__  << " at " << __TIME__  << ")" << std::endl;
 
-    // List all devices that support OpenCL on this system
-    std::vector<cl::Platform> platforms;
-    cl::Platform::get(&platforms);
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        return EXIT_FAILURE;
+    }
+    if (!options.traceFile.empty()) {
+        clrt::Tracer::getInstance().enable();
+    }
+
+    // List all devices that support OpenCL on this system (the runtime caches the platforms,
+    // device contexts, queues and built programs for the whole process)
+    clrt::Runtime runtime("kernels", "cache");
+    // Use the kernel files that CMake embedded into the executable
+    runtime.setEmbeddedKernelFiles(embeddedKernelFiles, embeddedKernelFileCount);
+    // The fastest work group sizes of previous runs are stored next to the program binaries
+    clrt::WorkGroupTuner tuner("cache");
+    const std::vector<cl::Platform> &platforms = runtime.getPlatforms();
 
     if (platforms.size() <= 0) {
         std::cerr << "No supported plaforms found!";
@@ -36,75 +204,281 @@ int main()
     std::cout << platforms.size() << " platform(s) found" << std::endl;
 
     // Set the size of the array
-    constexpr unsigned int size = 100000000;
-
-    // Run the host code
-    std::vector<int> vec(size);
-    memset(vec.data(), -1, size);
-    std::cout << "Run the host code" << std::endl;
-    const std::chrono::steady_clock::time_point cpu_calculation_begin =
-        std::chrono::steady_clock::now();
-    runHostCode(vec);
-    const std::chrono::steady_clock::time_point cpu_calculation_end = std::chrono::steady_clock::now();
-    const auto cpuTimeNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>
-                                                 (cpu_calculation_end - cpu_calculation_begin).count());
-    std::cout << "\tTime: " << displayTimeAndSpeedup(cpuTimeNs) << std::endl;
+    const std::size_t size = options.size;
+
+    // Every time is the median of multiple repetitions that follow untimed warm up runs
+    clrt::Benchmark benchmark(options.warmUpCount, options.repetitionCount);
+    std::cout << "Benchmark: " << options.warmUpCount << " warm up run(s), "
+              << options.repetitionCount << " timed repetition(s)" << std::endl;
+
+    // Run the host code (multithreaded and vectorized to get a realistic CPU baseline)
+    clrt::HostEngine hostEngine;
+    HostVector vec(size);
+    memset(vec.data(), -1, size * sizeof(int));
+    std::cout << "Run the host code (" << hostEngine.getThreadCount() << " threads, "
+              << clrt::HostEngine::getSimdName() << ")" << std::endl;
+    clrt::BenchmarkStatistics hostStatistics;
+    benchmark.setHost();
+    benchmark.run({ "host", size * sizeof(int), size }, [&hostEngine, &vec](uint64_t &timeNs) {
+        const std::chrono::steady_clock::time_point cpu_calculation_begin =
+            std::chrono::steady_clock::now();
+        runHostCode(hostEngine, vec);
+        const std::chrono::steady_clock::time_point cpu_calculation_end =
+            std::chrono::steady_clock::now();
+        timeNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>
+                                       (cpu_calculation_end - cpu_calculation_begin).count());
+        return true;
+    }, hostStatistics);
+    const uint64_t cpuTimeNs = hostStatistics.medianNs;
+    std::cout << "\tTime: " << clrt::displayStatistics(hostStatistics) << std::endl;
+
+    // Take one snapshot of the capabilities of all devices (it is stored per platform, device and
+    // driver version so later runs only have to read the names and versions)
+    clrt::DeviceRegistry registry(runtime, "cache");
+    if (!registry.discover()) {
+        return EXIT_FAILURE;
+    }
+    std::cout << "Device discovery: " << registry.getDevices().size() << " device(s) in "
+              << displayTimeAndSpeedup(registry.getDiscoveryNs()) << ", "
+              << registry.getSnapshotHitCount() << " from the snapshot file" << std::endl;
 
     std::cout << "\033[1;34mAll OpenCL platforms:\033[0m" << std::endl;
     int platformCounter = 0;
-    for (auto &platform : platforms) {
-        // List all platform attributes
-        std::cout << platformCounter++
-                  << "\tName: " << platform.getInfo<CL_PLATFORM_NAME>()
-                  << "\n\tVendor: " << platform.getInfo<CL_PLATFORM_VENDOR>()
-                  << "\n\tVersion: " << platform.getInfo<CL_PLATFORM_VERSION>()
-                  << "\n\tProfile: " << platform.getInfo<CL_PLATFORM_PROFILE>()
-                  << "\n\tICD suffix KHR: " << platform.getInfo<CL_PLATFORM_ICD_SUFFIX_KHR>()
-                  << "\n\tExtensions: " << platform.getInfo<CL_PLATFORM_EXTENSIONS>() << std::endl;
-
-        // List all devices of this platform
-        std::vector<cl::Device> devices;
-        platform.getDevices(CL_DEVICE_TYPE_GPU | CL_DEVICE_TYPE_CPU, &devices);
-
-        std::cout << "\t\033[1;34mAll OpenCL devices of this platform:\033[0m" << std::endl;
-        int deviceCounter = 0;
-        for (auto &device : devices) {
-            // List all device attributes
-            std::cout << "\t" << deviceCounter++
-                      << "\tName: " << device.getInfo<CL_DEVICE_NAME>()
-                      << "\n\t\tType: " << ((device.getInfo<CL_DEVICE_TYPE>() == CL_DEVICE_TYPE_GPU)
-                                            ? "\033[1;32mGPU\033[0m" : "\033[1;31mCPU\033[0m")
-                      << "\n\t\tVendor: " << device.getInfo<CL_DEVICE_VENDOR>()
-                      << "\n\t\tVersion: " << device.getInfo<CL_DEVICE_VERSION>()
-                      << "\n\t\tAvailable: " << (device.getInfo<CL_DEVICE_AVAILABLE>() ? "True" : "False")
-                      << "\n\t\tMax work group size: " << device.getInfo<CL_DEVICE_MAX_WORK_GROUP_SIZE>()
-                      << "\n\t\tMax clock frequency: " << device.getInfo<CL_DEVICE_MAX_CLOCK_FREQUENCY>()
-                      << "\n\t\tGlobal memory size: "
-                      << device.getInfo<CL_DEVICE_GLOBAL_MEM_SIZE>() / pow(1024.0, 3) << "GB"
-                      << "\n\t\tLocal memory size: "
-                      << device.getInfo<CL_DEVICE_LOCAL_MEM_SIZE>() / pow(1024.0, 1) << "KB"
-                      << "\n\t\tMaximum allocatable memory: "
-                      << device.getInfo<CL_DEVICE_MAX_MEM_ALLOC_SIZE>() / pow(1024.0, 3) << "GB" << std::endl;
-
-            // Run on device an example kernel
-            if (!runKernelOnOpenClDevice(device, vec, cpuTimeNs)) {
-                std::cout << "\t\t\033[1;31mError running the kernel!\033[0m" << std::endl;
-            }
-        }
-    }
-}
-
-void runHostCode(std::vector<int> &vec)
-{
-    for (unsigned int i = 0; i < vec.size(); i++) {
-        if (static_cast<int>(i) != vec[i]) {
-            vec[i] = static_cast<int>(i);
+    int deviceCounter = 0;
+    std::string platformKey;
+    for (std::size_t i = 0; i < registry.getDevices().size(); i++) {
+        cl::Device device = registry.getDevices()[i];
+        const clrt::DeviceCapabilities &capabilities = registry.getCapabilities()[i];
+
+        // List all platform attributes before the first device of every platform
+        if (capabilities.platformName + "|" + capabilities.platformVersion != platformKey) {
+            platformKey = capabilities.platformName + "|" + capabilities.platformVersion;
+            std::cout << platformCounter++
+                      << "\tName: " << capabilities.platformName
+                      << "\n\tVendor: " << capabilities.platformVendor
+                      << "\n\tVersion: " << capabilities.platformVersion
+                      << "\n\tProfile: " << capabilities.platformProfile
+                      << "\n\tICD suffix KHR: " << capabilities.icdSuffix
+                      << "\n\tExtensions: " << capabilities.platformExtensions << std::endl;
+            std::cout << "\t\033[1;34mAll OpenCL devices of this platform:\033[0m" << std::endl;
+            deviceCounter = 0;
+        }
+
+        // List all device attributes
+        std::cout << "\t" << deviceCounter++
+                  << "\tName: " << capabilities.name
+                  << "\n\t\tType: " << ((capabilities.type == CL_DEVICE_TYPE_GPU)
+                                        ? "\033[1;32mGPU\033[0m" : "\033[1;31mCPU\033[0m")
+                  << "\n\t\tVendor: " << capabilities.vendor
+                  << "\n\t\tVersion: " << capabilities.version
+                  << "\n\t\tAvailable: " << (capabilities.available ? "True" : "False")
+                  << "\n\t\tCompute units: " << capabilities.computeUnitCount
+                  << "\n\t\tMax work group size: " << capabilities.maxWorkGroupSize
+                  << "\n\t\tMax clock frequency: " << capabilities.maxClockFrequency
+                  << "\n\t\tGlobal memory size: "
+                  << capabilities.globalMemorySize / pow(1024.0, 3) << "GB"
+                  << "\n\t\tLocal memory size: "
+                  << capabilities.localMemorySize / pow(1024.0, 1) << "KB"
+                  << "\n\t\tMaximum allocatable memory: "
+                  << capabilities.maxAllocationSize / pow(1024.0, 3) << "GB"
+                  << "\n\t\tPreferred int vector width: " << capabilities.preferredVectorWidthInt
+                  << "\n\t\tUnified memory: " << (capabilities.unifiedMemory ? "True" : "False")
+                  << std::endl;
+
+        // Run on device an example kernel
+        if (!runKernelOnOpenClDevice(runtime, tuner, benchmark, device, vec, cpuTimeNs,
+                                     options)) {
+            std::cout << "\t\t\033[1;31mError running the kernel!\033[0m" << std::endl;
+        }
+        if (options.batchJobCount > 0
+            && !runBatchedKernelOnOpenClDevice(runtime, benchmark, device, options)) {
+            std::cout << "\t\t\033[1;31mError running the batched kernel!\033[0m"
+                      << std::endl;
+        }
+        if (!options.inputFile.empty()
+            && !runKernelOnFile(runtime, benchmark, device, options)) {
+            std::cout << "\t\t\033[1;31mError running the kernel on the file!\033[0m"
+                      << std::endl;
+        }
+        if (options.stencilSize > 0
+            && !runStencilOnOpenClDevice(runtime, benchmark, device, options)) {
+            std::cout << "\t\t\033[1;31mError running the stencil!\033[0m" << std::endl;
+        }
+        if (options.primitivesSize > 0
+            && !runPrimitivesOnOpenClDevice(runtime, benchmark, device, options)) {
+            std::cout << "\t\t\033[1;31mError running the primitives!\033[0m" << std::endl;
         }
+        if (options.compactStorage
+            && !runPackedKernelOnOpenClDevice(runtime, benchmark, device, options)) {
+            std::cout << "\t\t\033[1;31mError running the packed kernel!\033[0m" << std::endl;
+        }
+        if (options.pipelineSize > 0
+            && !runPipelineOnOpenClDevice(runtime, benchmark, device, options)) {
+            std::cout << "\t\t\033[1;31mError running the pipeline!\033[0m" << std::endl;
+        }
+        if (capabilities.available) {
+            const clrt::BufferPoolStatistics poolStatistics =
+                runtime.getBufferPool(device).getStatistics();
+            std::cout << "\t\tBuffer pool: " << poolStatistics.requestCount
+                      << " request(s), hit rate " << 100.0 * poolStatistics.hitRate
+                      << "%, fragmentation " << 100.0 * poolStatistics.fragmentation
+                      << "%, " << poolStatistics.slabCount << " slab(s), reserved "
+                      << poolStatistics.reservedBytes / pow(1024.0, 2) << "MB (high water "
+                      << poolStatistics.highWaterBytes / pow(1024.0, 2) << "MB)" << std::endl;
+        }
+    }
+
+    // Split the array across all devices (the throughputs that the scheduler measures in the
+    // warm up runs are used to weight the split of the timed repetitions)
+    if (options.allDevices) {
+        clrt::MultiDeviceScheduler scheduler;
+        if (!runKernelOnAllOpenClDevices(runtime, scheduler, benchmark, vec, cpuTimeNs)) {
+            std::cout << "\t\033[1;31mError running the kernel on all devices!\033[0m"
+                      << std::endl;
+        }
+    }
+
+    // Submit small jobs from many producer threads at the same time to all devices
+    if (options.serveThreadCount > 0 && !runJobServerLoad(runtime, options)) {
+        std::cout << "\t\033[1;31mError running the jobs with the job server!\033[0m"
+                  << std::endl;
+    }
+
+    // Compare the radix sort of every device with std::sort and the multithreaded host sort
+    if (options.sortSize > 0
+        && !runSortBenchmark(runtime, benchmark, hostEngine, registry.getDevices(), options)) {
+        std::cout << "\t\033[1;31mError running the sort benchmark!\033[0m" << std::endl;
+    }
+
+    // Display how much program build time the binary cache saved
+    const clrt::ProgramBinaryCache &binaryCache = runtime.getBinaryCache();
+    std::cout << "Program binary cache: " << binaryCache.getHitCount() << " hit(s), "
+              << binaryCache.getMissCount() << " miss(es) (" << binaryCache.getInvalidCount()
+              << " stale/corrupt), saved build time: "
+              << displayTimeAndSpeedup(binaryCache.getSavedBuildTimeNs()) << std::endl;
+
+    // Export the benchmark results (e.g. to track performance regressions across drivers)
+    if (!options.jsonFile.empty() && !benchmark.writeJson(options.jsonFile)) {
+        return EXIT_FAILURE;
+    }
+    if (!options.csvFile.empty() && !benchmark.writeCsv(options.csvFile)) {
+        return EXIT_FAILURE;
+    }
+
+    // Export the timeline (open it with chrome://tracing or https://ui.perfetto.dev)
+    if (!options.traceFile.empty()) {
+        const clrt::Tracer &tracer = clrt::Tracer::getInstance();
+        if (!tracer.writeChromeTrace(options.traceFile)) {
+            return EXIT_FAILURE;
+        }
+        std::cout << "Trace: " << options.traceFile << " (" << tracer.getDroppedCount()
+                  << " dropped record(s))" << std::endl;
     }
 }
 
-const bool runKernelOnOpenClDevice(cl::Device &device, std::vector<int> &vec,
-                                   const uint64_t &cpuTimeNs)
+const bool parseOptions(int argc, char **argv, Options &options)
+{
+    for (int i = 1; i < argc; i++) {
+        const std::string argument = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (argument == "--size" && hasValue) {
+            options.size = std::strtoull(argv[++i], nullptr, 10);
+        } else if (argument == "--stream") {
+            options.streaming = true;
+        } else if (argument == "--chunk-size" && hasValue) {
+            options.chunkSize = std::strtoull(argv[++i], nullptr, 10);
+        } else if (argument == "--tune") {
+            options.tune = true;
+        } else if (argument == "--vector-width" && hasValue) {
+            options.vectorWidth = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+            const auto widthsEnd = std::end(exampleVectorWidths);
+            if (options.vectorWidth != 0
+                && std::find(std::begin(exampleVectorWidths), widthsEnd,
+                             options.vectorWidth) == widthsEnd) {
+                std::cerr << "The vector width has to be 1, 4, 8 or 16" << std::endl;
+                return false;
+            }
+        } else if (argument == "--warm-up" && hasValue) {
+            options.warmUpCount = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (argument == "--repetitions" && hasValue) {
+            options.repetitionCount = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr,
+                                                                             10));
+        } else if (argument == "--json" && hasValue) {
+            options.jsonFile = argv[++i];
+        } else if (argument == "--csv" && hasValue) {
+            options.csvFile = argv[++i];
+        } else if (argument == "--all-devices") {
+            options.allDevices = true;
+        } else if (argument == "--graph" && hasValue) {
+            options.graphSliceCount = std::strtoull(argv[++i], nullptr, 10);
+        } else if (argument == "--trace" && hasValue) {
+            options.traceFile = argv[++i];
+        } else if (argument == "--batch" && hasValue) {
+            options.batchJobCount = std::strtoull(argv[++i], nullptr, 10);
+        } else if (argument == "--input" && hasValue) {
+            options.inputFile = argv[++i];
+        } else if (argument == "--output" && hasValue) {
+            options.outputFile = argv[++i];
+        } else if (argument == "--serve" && hasValue) {
+            options.serveThreadCount = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr,
+                                                                              10));
+        } else if (argument == "--stencil" && hasValue) {
+            options.stencilSize = std::strtoull(argv[++i], nullptr, 10);
+        } else if (argument == "--stencil-radius" && hasValue) {
+            options.stencilRadius = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (argument == "--tile" && hasValue) {
+            // WIDTHxHEIGHT
+            char *end = nullptr;
+            options.tileWidth = std::strtoull(argv[++i], &end, 10);
+            options.tileHeight = *end == 'x' ? std::strtoull(end + 1, nullptr, 10) : 0;
+            if (options.tileWidth == 0 || options.tileHeight == 0) {
+                std::cerr << "The tile has to be WIDTHxHEIGHT (e.g. 16x16)" << std::endl;
+                return false;
+            }
+        } else if (argument == "--primitives" && hasValue) {
+            options.primitivesSize = std::strtoull(argv[++i], nullptr, 10);
+        } else if (argument == "--sort" && hasValue) {
+            options.sortSize = std::strtoull(argv[++i], nullptr, 10);
+        } else if (argument == "--storage" && hasValue) {
+            if (!clrt::StorageCodec::parse(argv[++i], options.storage)) {
+                std::cerr << "The storage format has to be int32, int16, half, packed:BITS or "
+                          << "delta:BITS (BITS = 1 - 31)" << std::endl;
+                return false;
+            }
+            options.compactStorage = true;
+        } else if (argument == "--pipeline" && hasValue) {
+            options.pipelineSize = std::strtoull(argv[++i], nullptr, 10);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--size ELEMENTS] [--stream]"
+                      << " [--chunk-size ELEMENTS] [--tune] [--vector-width WIDTH]"
+                      << " [--warm-up COUNT]"
+                      << " [--repetitions COUNT] [--json FILE] [--csv FILE] [--all-devices]"
+                      << " [--graph SLICES] [--trace FILE] [--batch JOBS]"
+                      << " [--input FILE --output FILE] [--serve THREADS]"
+                      << " [--stencil SIZE] [--stencil-radius RADIUS] [--tile WIDTHxHEIGHT]"
+                      << " [--primitives ELEMENTS] [--sort KEYS] [--storage FORMAT]"
+                      << " [--pipeline ELEMENTS]"
+                      << std::endl;
+            return false;
+        }
+    }
+    if (options.inputFile.empty() != options.outputFile.empty()) {
+        std::cerr << "The options --input and --output have to be used together" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void runHostCode(clrt::HostEngine &hostEngine, HostVector &vec)
+{
+    clrt::TraceSpan span("host reference");
+    hostEngine.fillIndices(vec.data(), vec.size());
+}
+
+const bool runKernelOnOpenClDevice(clrt::Runtime &runtime, clrt::WorkGroupTuner &tuner,
+                                   clrt::Benchmark &benchmark, cl::Device &device,
+                                   HostVector &vec, const uint64_t &cpuTimeNs,
+                                   const Options &options)
 {
     if (!device.getInfo<CL_DEVICE_AVAILABLE>()) {
         std::cout << "\t\tDevice is not available" << std::endl;
@@ -113,94 +487,1412 @@ const bool runKernelOnOpenClDevice(cl::Device &device, std::vector<int> &vec,
     std::cout << "\t\t>> Run example kernel on OpenCL device \""
               << device.getInfo<CL_DEVICE_NAME>() << "\"" << std::endl;
 
-    // Create link between the device and platform;
-    cl::Context context({device});
+    // Get the (cached) link between the device and platform and its command queue
+    clrt::DeviceContext &deviceContext = runtime.getDeviceContext(device);
+    // Device buffers are recycled across the runs instead of being created for every run
+    clrt::BufferPool &bufferPool = runtime.getBufferPool(device);
 
-    // Create the program that should be executed that is equivalent to the host code
-    cl::Program::Sources sources;
-    std::vector<const char *> sourceFiles = {
-        "kernels/kernel.cl",
-        "kernels/kernel_helper.cl"
+    // Build the program (or load it from the binary cache) and check if it was successful
+    const char *kernelName = exampleKernelName;
+    clrt::Program program;
+    const clrt::ProgramBinaryCache &binaryCache = runtime.getBinaryCache();
+    const unsigned int cacheHitsBefore = binaryCache.getHitCount();
+    const auto buildBegin = std::chrono::steady_clock::now();
+    if (!buildExampleProgram(runtime, device, program)) {
+        return false;
+    }
+    const auto buildNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>
+                                               (std::chrono::steady_clock::now() - buildBegin).count());
+    std::cout << "\t\t\tBuild: " << displayTimeAndSpeedup(buildNs)
+              << (binaryCache.getHitCount() > cacheHitsBefore ? " [binary cache hit]"
+                  : " [binary cache miss]") << std::endl;
+
+    // Create the kernel/program that will run on the OpenCL device
+    clrt::Kernel kernel_simple;
+    if (!program.createKernel(kernelName, kernel_simple)) {
+        return false;
+    }
+    benchmark.setDevice(device);
+
+    // Check if the buffer size is OK, if not process the vector in chunks
+    const uint64_t bufferSize = sizeof(cl_int) * static_cast<uint64_t>(vec.size());
+    const uint64_t maxBufferSize = device.getInfo< CL_DEVICE_MAX_MEM_ALLOC_SIZE>();
+    if (options.streaming || bufferSize > maxBufferSize) {
+        if (bufferSize > maxBufferSize) {
+            std::cout << "\t\t\tThe buffer size (" << bufferSize
+                      << ") is bigger than the device max mem alloc size (" << maxBufferSize
+                      << "), process it in chunks" << std::endl;
+        }
+        clrt::StreamingPipeline pipeline(runtime, device);
+        clrt::StreamingStatistics statistics;
+        std::vector<clrt::BenchmarkStatistics> phaseStatistics;
+        const bool success = benchmark.run({
+            { "streaming write", bufferSize, 0 },
+            { "streaming kernel", bufferSize, vec.size() },
+            { "streaming read", bufferSize, 0 },
+            { "streaming sum", bufferSize, vec.size() },
+            { "streaming wall", bufferSize, vec.size() }
+        }, [&](std::vector<uint64_t> &phaseNs) {
+            // Reset the vector so that every repetition has to write all values again
+            memset(vec.data(), -1, vec.size() * sizeof(int));
+            if (!pipeline.run(kernel_simple, vec.data(), sizeof(cl_int), vec.size(),
+                              options.chunkSize, statistics)) {
+                return false;
+            }
+            phaseNs = { statistics.writeNs, statistics.kernelNs, statistics.readNs,
+                        statistics.writeNs + statistics.kernelNs + statistics.readNs,
+                        statistics.wallNs
+                      };
+            return true;
+        }, phaseStatistics);
+        if (!success) {
+            return false;
+        }
+        std::cout << "\t\t\tStreaming: " << statistics.chunkCount << " chunk(s) of "
+                  << statistics.chunkElementCount << " elements"
+                  << "\n\t\t\tTime (median):"
+                  << "\n\t\t\t\tWrite to buffer:  " << clrt::displayStatistics(phaseStatistics[0])
+                  << "\n\t\t\t\tKernel execution: " << clrt::displayStatistics(phaseStatistics[1])
+                  << "\n\t\t\t\tRead from buffer: " << clrt::displayStatistics(phaseStatistics[2])
+                  << "\n\t\t\t\t\t=> Sum:   "
+                  << displayTimeAndSpeedup(phaseStatistics[3].medianNs, true, cpuTimeNs)
+                  << "\n\t\t\t\t\t=> Wall:  "
+                  << displayTimeAndSpeedup(phaseStatistics[4].medianNs, true, cpuTimeNs)
+                  << "\n\t\t\t\t\t   " << clrt::displayStatistics(phaseStatistics[4]) << std::endl;
+    } else if (options.graphSliceCount > 0) {
+        // Every slice is an independent write -> kernel -> read chain so the transfers of one
+        // slice overlap with the kernels of the others and the host is not blocked until it
+        // waits for the results
+        clrt::TaskGraph graph(deviceContext);
+        const std::size_t sliceCount = std::min(options.graphSliceCount, vec.size());
+        const std::size_t sliceElementCount = (vec.size() + sliceCount - 1) / sliceCount;
+        std::vector<clrt::PooledBuffer> buffers(sliceCount);
+        std::vector<clrt::Kernel> kernels(sliceCount);
+        for (std::size_t slice = 0; slice < sliceCount; slice++) {
+            const std::size_t count = std::min(sliceElementCount,
+                                               vec.size() - slice * sliceElementCount);
+            if (!bufferPool.acquire(count * sizeof(cl_int), buffers[slice])
+                || !program.createKernel(kernelName, kernels[slice])
+                || !kernels[slice].setArg(0, buffers[slice].get())) {
+                return false;
+            }
+        }
+
+        std::vector<clrt::BenchmarkStatistics> phaseStatistics;
+        const bool success = benchmark.run({
+            { "graph enqueue", 0, 0 },
+            { "graph wall", bufferSize, vec.size() }
+        }, [&](std::vector<uint64_t> &phaseNs) {
+            // Reset the vector so that every repetition has to write all values again
+            memset(vec.data(), -1, vec.size() * sizeof(int));
+            const auto begin = std::chrono::steady_clock::now();
+            for (std::size_t slice = 0; slice < sliceCount; slice++) {
+                const std::size_t offset = slice * sliceElementCount;
+                const std::size_t count = std::min(sliceElementCount, vec.size() - offset);
+                int *sliceData = vec.data() + offset;
+                clrt::TaskId write, kernel, read;
+                if (!graph.addWrite(buffers[slice].get(), sliceData, count * sizeof(cl_int), {},
+                                    write)
+                    || !graph.addKernel(kernels[slice], cl::NDRange(count), cl::NullRange,
+                                        { write }, kernel, cl::NDRange(offset))
+                    || !graph.addRead(buffers[slice].get(), sliceData, count * sizeof(cl_int),
+                                      { kernel }, read)) {
+                    graph.clear();
+                    return false;
+                }
+            }
+            // Everything is enqueued: The host could do other work now until it needs the results
+            phaseNs[0] = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>
+                                               (std::chrono::steady_clock::now() - begin).count());
+            const bool graphSuccess = graph.clear();
+            phaseNs[1] = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>
+                                               (std::chrono::steady_clock::now() - begin).count());
+            return graphSuccess;
+        }, phaseStatistics);
+        if (!success) {
+            return false;
+        }
+        std::cout << "\t\t\tTask graph: " << sliceCount << " slice(s) of " << sliceElementCount
+                  << " elements (" << (graph.isOutOfOrder() ? "out of order queue"
+                                       : "multiple in order queues") << ")"
+                  << "\n\t\t\tTime (median):"
+                  << "\n\t\t\t\tEnqueue (host):   " << clrt::displayStatistics(phaseStatistics[0])
+                  << "\n\t\t\t\t\t=> Wall:  "
+                  << displayTimeAndSpeedup(phaseStatistics[1].medianNs, true, cpuTimeNs)
+                  << "\n\t\t\t\t\t   " << clrt::displayStatistics(phaseStatistics[1]) << std::endl;
+    } else {
+        // Create a buffer on the OpenCL device for the vector data (devices that share their
+        // memory with the host use the page aligned vector data directly without copying it)
+        clrt::HostBuffer buffer_output(deviceContext, vec.data(), bufferSize, CL_MEM_READ_WRITE,
+                                       &bufferPool);
+        if (!buffer_output.isValid()) {
+            return false;
+        }
+
+        // Write 1, 4, 8 or 16 elements per work item (vector stores use the SIMD width of CPU
+        // devices and need less work items)
+        unsigned int vectorWidth = 1;
+        std::string widthSource;
+        clrt::Kernel kernel_vector;
+        if (!createVectorKernel(runtime, tuner, device, buffer_output.get(), vec.size(), options,
+                                vectorWidth, widthSource, kernel_vector)) {
+            return false;
+        }
+        const std::string vectorKernelName = exampleVectorKernelName + std::to_string(vectorWidth);
+        std::cout << "\t\t\tVector width: " << vectorWidth << " [" << widthSource << "]"
+                  << std::endl;
+
+        // Use the fastest work group size of a previous run (or search it if requested, all
+        // widths were already tuned if the width was not set)
+        const cl::NDRange global((vec.size() + vectorWidth - 1) / vectorWidth);
+        cl::NDRange local = cl::NullRange;
+        if (options.tune && options.vectorWidth > 0) {
+            if (!tuner.tune(kernel_vector, vectorKernelName, global, local)) {
+                return false;
+            }
+            std::cout << "\t\t\tLocal range: " << clrt::displayRange(local) << " [tuned]"
+                      << std::endl;
+        } else if (tuner.lookup(kernel_vector, vectorKernelName, global, local)) {
+            std::cout << "\t\t\tLocal range: " << clrt::displayRange(local)
+                      << (options.tune ? " [tuned]" : " [stored]") << std::endl;
+        }
+
+        std::vector<clrt::BenchmarkStatistics> phaseStatistics;
+        const bool success = benchmark.run({
+            { "write", bufferSize, 0 },
+            { "kernel", bufferSize, vec.size() },
+            { "read", bufferSize, 0 },
+            { "sum", bufferSize, vec.size() }
+        }, [&](std::vector<uint64_t> &phaseNs) {
+            // Reset the vector so that every repetition has to write all values again
+            memset(vec.data(), -1, vec.size() * sizeof(int));
+
+            // Write current vector data to the OpenCL buffer
+            cl::Event eventWriteToBuffer;
+            if (!buffer_output.toDevice(NULL, &eventWriteToBuffer)) {
+                return false;
+            }
+
+            // Run the kernel/program on the OpenCL device
+            cl::Event eventKernelExecution;
+            if (!kernel_vector.enqueue(global, local, NULL, &eventKernelExecution)) {
+                return false;
+            }
+
+            // Read the new values in the OpenCL device back into to the host into out vector
+            cl::Event eventReadFromBuffer;
+            if (!buffer_output.toHost(NULL, &eventReadFromBuffer)) {
+                return false;
+            }
+
+            // Calculate all times
+            phaseNs[0] = getTimeInNs(eventWriteToBuffer);
+            phaseNs[1] = getTimeInNs(eventKernelExecution);
+            phaseNs[2] = getTimeInNs(eventReadFromBuffer);
+            phaseNs[3] = phaseNs[0] + phaseNs[1] + phaseNs[2];
+            return true;
+        }, phaseStatistics);
+        if (!success) {
+            return false;
+        }
+        std::cout << "\t\t\tTime (median):"
+                  << "\n\t\t\t\tWrite to buffer:  " << clrt::displayStatistics(phaseStatistics[0])
+                  << "\n\t\t\t\tKernel execution: " << clrt::displayStatistics(phaseStatistics[1])
+                  << "\n\t\t\t\tRead from buffer: " << clrt::displayStatistics(phaseStatistics[2])
+                  << "\n\t\t\t\t\t=> Sum:   "
+                  << displayTimeAndSpeedup(phaseStatistics[3].medianNs, true, cpuTimeNs)
+                  << "\n\t\t\tZero copy: " << (buffer_output.isZeroCopy() ? "Yes" : "No")
+                  << " (copied " << buffer_output.getCopiedBytes() << " bytes, avoided copying "
+                  << buffer_output.getAvoidedCopyBytes() << " bytes)" << std::endl;
+
+        // Check the results on the device where they already are (only the error count is read
+        // back), a zero copy buffer has to be handed back to the device for this
+        clrt::TraceSpan validationSpan("validate on device");
+        clrt::Reduction reduction(runtime, device);
+        uint64_t errorCount = 0;
+        if (!reduction.isValid() || (buffer_output.isZeroCopy() && !buffer_output.toDevice())
+            || !reduction.countIndexMismatches(buffer_output.get(), vec.size(), 0, errorCount)
+            || (buffer_output.isZeroCopy() && !buffer_output.toHost())) {
+            return false;
+        }
+        std::cout << "\t\t\tDevice validation: " << errorCount << " error(s) in "
+                  << displayTimeAndSpeedup(reduction.getLastDurationNs())
+                  << (reduction.usesSubgroups() ? " (subgroups)" : " (local memory)") << std::endl;
+        if (errorCount == 0) {
+            return true;
+        }
+    }
+
+    // Check if the "calculation" was successful
+    return checkResults(vec);
+}
+
+const bool runBatchedKernelOnOpenClDevice(clrt::Runtime &runtime, clrt::Benchmark &benchmark,
+                                          cl::Device &device, const Options &options)
+{
+    if (!device.getInfo<CL_DEVICE_AVAILABLE>()) {
+        return true;
+    }
+    std::cout << "\t\t>> Run " << options.batchJobCount
+              << " small arrays with one batched launch and with single launches" << std::endl;
+
+    clrt::Program program;
+    clrt::Kernel singleKernel;
+    clrt::Kernel batchedKernel;
+    if (!buildExampleProgram(runtime, device, program)
+        || !program.createKernel(exampleKernelName, singleKernel)
+        || !program.createKernel(exampleBatchedKernelName, batchedKernel)) {
+        return false;
+    }
+
+    // Arrays of different sizes (the same sizes in every run of the program)
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<std::size_t> sizeDistribution(1, maxBatchJobElementCount);
+    std::vector<std::vector<int>> arrays(options.batchJobCount);
+    std::vector<clrt::BatchJob> jobs(arrays.size());
+    std::size_t elementCount = 0;
+    for (std::size_t i = 0; i < arrays.size(); i++) {
+        arrays[i].resize(sizeDistribution(generator));
+        jobs[i].data = arrays[i].data();
+        jobs[i].elementCount = arrays[i].size();
+        elementCount += arrays[i].size();
+    }
+    const auto resetArrays = [&arrays]() {
+        for (auto &array : arrays) {
+            std::fill(array.begin(), array.end(), -1);
+        }
     };
-    const char *kernelName = "simple";
-    for (auto const &sourceFilePath : sourceFiles) {
-        const std::ifstream file(sourceFilePath);
-        std::stringstream buffer;
-        buffer << file.rdbuf();
-        const std::string kernel_code = buffer.str();
-        //std::cout << "add kernel code: \"" << sourceFilePath << "\" =>\n" << kernel_code << std::endl;
-        sources.push_back({ kernel_code.c_str(), kernel_code.length() });
-    }
-    const std::string maxWgSize = std::to_string(device.getInfo<CL_DEVICE_MAX_WORK_GROUP_SIZE>());
-    std::vector<std::tuple<const char *, const char *>> variables = {
-        { "MAX_WG_SIZE", maxWgSize.c_str() }
+
+    // Compare the wall times (including packing, transfers and scattering) of both modes
+    clrt::BatchLauncher launcher(runtime, device);
+    clrt::BatchStatistics singleStatistics;
+    clrt::BatchStatistics batchedStatistics;
+    std::vector<clrt::BenchmarkStatistics> phaseStatistics;
+    const uint64_t bytes = sizeof(cl_int) * static_cast<uint64_t>(elementCount);
+    benchmark.setDevice(device);
+    const bool success = benchmark.run({
+        { "single launches", bytes, elementCount },
+        { "batched launch", bytes, elementCount }
+    }, [&](std::vector<uint64_t> &phaseNs) {
+        if (!launcher.runSingle(singleKernel, jobs, sizeof(cl_int), singleStatistics)) {
+            return false;
+        }
+        // Reset the arrays so that the batched launch has to write all values again
+        resetArrays();
+        if (!launcher.run(batchedKernel, jobs, sizeof(cl_int), batchedStatistics)) {
+            return false;
+        }
+        phaseNs = { singleStatistics.wallNs, batchedStatistics.wallNs };
+        return true;
+    }, phaseStatistics);
+    if (!success) {
+        return false;
+    }
+    std::cout << "\t\t\tBatch: " << jobs.size() << " arrays with " << elementCount
+              << " elements, " << singleStatistics.launchCount << " launches vs "
+              << batchedStatistics.launchCount << " launch"
+              << "\n\t\t\tTime (median):"
+              << "\n\t\t\t\tSingle launches: " << clrt::displayStatistics(phaseStatistics[0])
+              << "\n\t\t\t\tBatched launch:  " << clrt::displayStatistics(phaseStatistics[1])
+              << "\n\t\t\t\t\t=> Pack: " << displayTimeAndSpeedup(batchedStatistics.packNs)
+              << ", write: " << displayTimeAndSpeedup(batchedStatistics.writeNs)
+              << ", kernel: " << displayTimeAndSpeedup(batchedStatistics.kernelNs)
+              << ", read: " << displayTimeAndSpeedup(batchedStatistics.readNs)
+              << ", scatter: " << displayTimeAndSpeedup(batchedStatistics.scatterNs)
+              << "\n\t\t\t\t\t=> Speedup: "
+              << static_cast<double>(phaseStatistics[0].medianNs)
+              / std::max<uint64_t>(1, phaseStatistics[1].medianNs) << std::endl;
+
+    // Every array has to contain its own indices
+    std::size_t errorCount = 0;
+    for (auto const &array : arrays) {
+        for (std::size_t i = 0; i < array.size(); i++) {
+            if (array[i] != static_cast<int>(i)) {
+                errorCount++;
+            }
+        }
+    }
+    if (errorCount > 0) {
+        std::cout << "\t\t\033[1;31mCalculation errors in the batched kernel execution: "
+                  << errorCount << "\033[0m" << std::endl;
+        return false;
+    }
+
+    // Find the number of arrays from which on batching is faster on this device
+    clrt::BatchBreakEven breakEven;
+    if (!launcher.findBreakEven(singleKernel, batchedKernel, jobs, sizeof(cl_int),
+                                options.repetitionCount, breakEven)) {
+        return false;
+    }
+    std::cout << "\t\t\tBreak-even (arrays: single launches / batched launch):";
+    for (std::size_t i = 0; i < breakEven.jobCounts.size(); i++) {
+        std::cout << "\n\t\t\t\t" << breakEven.jobCounts[i] << ": "
+                  << displayTimeAndSpeedup(breakEven.singleNs[i]) << " / "
+                  << displayTimeAndSpeedup(breakEven.batchedNs[i]);
+    }
+    if (breakEven.breakEvenJobCount > 0) {
+        std::cout << "\n\t\t\t\t=> Batching pays off from " << breakEven.breakEvenJobCount
+                  << " arrays on" << std::endl;
+    } else {
+        std::cout << "\n\t\t\t\t=> Batching did not pay off" << std::endl;
+    }
+    return true;
+}
+
+const bool runKernelOnFile(clrt::Runtime &runtime, clrt::Benchmark &benchmark,
+                           cl::Device &device, const Options &options)
+{
+    if (!device.getInfo<CL_DEVICE_AVAILABLE>()) {
+        return true;
+    }
+
+    // Map the files instead of reading them into host memory (the output file gets the size of
+    // the input file)
+    clrt::MappedFile input;
+    clrt::MappedFile output;
+    if (!input.openRead(options.inputFile)
+        || !output.create(options.outputFile, input.getSize())) {
+        return false;
+    }
+    const std::size_t elementCount = static_cast<std::size_t>(input.getSize() / sizeof(cl_int));
+    std::cout << "\t\t>> Process the file \"" << options.inputFile << "\" (" << elementCount
+              << " elements) into the file \"" << options.outputFile << "\"" << std::endl;
+
+    clrt::Program program;
+    clrt::Kernel kernel;
+    if (!buildExampleProgram(runtime, device, program)
+        || !program.createKernel(exampleFileKernelName, kernel)) {
+        return false;
+    }
+
+    clrt::StreamingPipeline pipeline(runtime, device);
+    clrt::StreamingStatistics statistics;
+    std::vector<clrt::BenchmarkStatistics> phaseStatistics;
+    const uint64_t bytes = sizeof(cl_int) * static_cast<uint64_t>(elementCount);
+    benchmark.setDevice(device);
+    const bool success = benchmark.run({
+        { "file write", bytes, 0 },
+        { "file kernel", bytes, elementCount },
+        { "file read", bytes, 0 },
+        { "file wall", bytes, elementCount }
+    }, [&](std::vector<uint64_t> &phaseNs) {
+        if (!pipeline.runFile(kernel, input, output, sizeof(cl_int), options.chunkSize,
+                              statistics)) {
+            return false;
+        }
+        phaseNs = { statistics.writeNs, statistics.kernelNs, statistics.readNs,
+                    statistics.wallNs
+                  };
+        return true;
+    }, phaseStatistics);
+    if (!success) {
+        return false;
+    }
+    std::cout << "\t\t\tFile streaming: " << statistics.chunkCount << " chunk(s) of "
+              << statistics.chunkElementCount << " elements (" << statistics.zeroCopyChunkCount
+              << " zero copy)"
+              << "\n\t\t\tTime (median):"
+              << "\n\t\t\t\tWrite from file:  " << clrt::displayStatistics(phaseStatistics[0])
+              << "\n\t\t\t\tKernel execution: " << clrt::displayStatistics(phaseStatistics[1])
+              << "\n\t\t\t\tRead into file:   " << clrt::displayStatistics(phaseStatistics[2])
+              << "\n\t\t\t\t\t=> Wall:  " << clrt::displayStatistics(phaseStatistics[3])
+              << std::endl;
+
+    // Check the output file chunk by chunk against the mixed elements of the input file
+    std::size_t errorCount = 0;
+    clrt::MappedRange inputRange;
+    clrt::MappedRange outputRange;
+    for (std::size_t offset = 0; offset < elementCount; offset += statistics.chunkElementCount) {
+        const std::size_t count = std::min(statistics.chunkElementCount, elementCount - offset);
+        const uint64_t fileOffset = static_cast<uint64_t>(offset) * sizeof(cl_uint);
+        if (!input.map(fileOffset, count * sizeof(cl_uint), inputRange)
+            || !output.map(fileOffset, count * sizeof(cl_uint), outputRange)) {
+            return false;
+        }
+        const cl_uint *inputData = static_cast<const cl_uint *>(inputRange.getData());
+        const cl_uint *outputData = static_cast<const cl_uint *>(outputRange.getData());
+        for (std::size_t i = 0; i < count; i++) {
+            if (outputData[i] != mixBits(inputData[i])) {
+                errorCount++;
+            }
+        }
+    }
+    if (errorCount > 0) {
+        std::cout << "\t\t\033[1;31mCalculation errors in the output file: " << errorCount
+                  << "\033[0m" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+const bool runStencilOnOpenClDevice(clrt::Runtime &runtime, clrt::Benchmark &benchmark,
+                                    cl::Device &device, const Options &options)
+{
+    if (!device.getInfo<CL_DEVICE_AVAILABLE>()) {
+        return true;
+    }
+    const std::size_t width = options.stencilSize;
+    const std::size_t height = options.stencilSize;
+    const int radius = static_cast<int>(options.stencilRadius);
+    std::cout << "\t\t>> Filter a " << width << "x" << height
+              << " image with a stencil of the radius " << radius << " (tiles of "
+              << options.tileWidth << "x" << options.tileHeight << ")" << std::endl;
+
+    clrt::Stencil2D stencil(runtime, device, options.stencilRadius, options.tileWidth,
+                            options.tileHeight);
+    if (!stencil.isValid()) {
+        return false;
+    }
+
+    // Normalized gaussian filter and a random image (the same in every run of the program)
+    const int size = 2 * radius + 1;
+    const double sigma = std::max(1.0, radius / 2.0);
+    std::vector<float> weights(size * size);
+    double weightSum = 0;
+    for (int dy = -radius; dy <= radius; dy++) {
+        for (int dx = -radius; dx <= radius; dx++) {
+            const double weight = std::exp(-(dx * dx + dy * dy) / (2 * sigma * sigma));
+            weights[(dy + radius) * size + dx + radius] = static_cast<float>(weight);
+            weightSum += weight;
+        }
+    }
+    for (auto &weight : weights) {
+        weight = static_cast<float>(weight / weightSum);
+    }
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<float> pixelDistribution(0.0f, 1.0f);
+    std::vector<float> pixels(width * height);
+    for (auto &pixel : pixels) {
+        pixel = pixelDistribution(generator);
+    }
+
+    // Host reference with the same clamping at the edges
+    std::vector<float> reference(pixels.size());
+    {
+        clrt::TraceSpan span("stencil reference");
+        const int lastX = static_cast<int>(width) - 1;
+        const int lastY = static_cast<int>(height) - 1;
+        for (int y = 0; y <= lastY; y++) {
+            for (int x = 0; x <= lastX; x++) {
+                float result = 0.0f;
+                for (int dy = -radius; dy <= radius; dy++) {
+                    const int row = std::min(std::max(y + dy, 0), lastY);
+                    for (int dx = -radius; dx <= radius; dx++) {
+                        const int column = std::min(std::max(x + dx, 0), lastX);
+                        result += weights[(dy + radius) * size + dx + radius]
+                                  * pixels[row * width + column];
+                    }
+                }
+                reference[y * width + x] = result;
+            }
+        }
+    }
+
+    clrt::BufferPool &bufferPool = runtime.getBufferPool(device);
+    clrt::PooledBuffer input;
+    clrt::PooledBuffer output;
+    const std::size_t bufferSize = pixels.size() * sizeof(cl_float);
+    if (!stencil.setWeights(weights) || !bufferPool.acquire(bufferSize, input)
+        || !bufferPool.acquire(bufferSize, output)) {
+        return false;
+    }
+    const cl::CommandQueue &queue = runtime.getDeviceContext(device).queue;
+    cl_int err = queue.enqueueWriteBuffer(input.get(), CL_TRUE, 0, bufferSize, pixels.data());
+    if (err != CL_SUCCESS) {
+        clrt::reportError("CommandQueue::enqueueWriteBuffer failed", err);
+        return false;
+    }
+
+    // Time the kernel of every version and compare its image with the reference
+    typedef std::function<bool(cl::Event *)> StencilRun;
+    std::vector<std::pair<std::string, StencilRun>> versions;
+    versions.emplace_back("stencil naive", [&](cl::Event *event) {
+        return stencil.runNaive(input.get(), output.get(), width, height, event);
+    });
+    versions.emplace_back("stencil tiled", [&](cl::Event *event) {
+        return stencil.runTiled(input.get(), output.get(), width, height, event);
+    });
+    if (stencil.supportsImages()) {
+        versions.emplace_back("stencil image", [&](cl::Event *event) {
+            return stencil.runImage(input.get(), output.get(), width, height, event);
+        });
+    }
+    benchmark.setDevice(device);
+    uint64_t naiveNs = 0;
+    std::vector<float> result(pixels.size());
+    for (auto const &version : versions) {
+        clrt::BenchmarkStatistics statistics;
+        const auto runVersion = [&version](uint64_t &timeNs) {
+            cl::Event event;
+            if (!version.second(&event) || event.wait() != CL_SUCCESS) {
+                return false;
+            }
+            timeNs = clrt::getEventDurationNs(event);
+            return true;
+        };
+        const bool success = benchmark.run({ version.first, 2 * bufferSize, pixels.size() },
+                                           runVersion, statistics);
+        if (!success) {
+            return false;
+        }
+        err = queue.enqueueReadBuffer(output.get(), CL_TRUE, 0, bufferSize, result.data());
+        if (err != CL_SUCCESS) {
+            clrt::reportError("CommandQueue::enqueueReadBuffer failed", err);
+            return false;
+        }
+        std::size_t errorCount = 0;
+        for (std::size_t i = 0; i < result.size(); i++) {
+            if (std::fabs(result[i] - reference[i]) > 1e-4f) {
+                errorCount++;
+            }
+        }
+        naiveNs = naiveNs == 0 ? statistics.medianNs : naiveNs;
+        std::cout << "\t\t\t" << version.first << ": " << clrt::displayStatistics(statistics)
+                  << "\n\t\t\t\t=> Speedup over naive: "
+                  << static_cast<double>(naiveNs) / std::max<uint64_t>(1, statistics.medianNs)
+                  << std::endl;
+        if (errorCount > 0) {
+            std::cout << "\t\t\033[1;31mCalculation errors in the " << version.first << ": "
+                      << errorCount << "\033[0m" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+const bool runPrimitivesOnOpenClDevice(clrt::Runtime &runtime, clrt::Benchmark &benchmark,
+                                       cl::Device &device, const Options &options)
+{
+    if (!device.getInfo<CL_DEVICE_AVAILABLE>()) {
+        return true;
+    }
+    const std::size_t count = options.primitivesSize;
+    std::cout << "\t\t>> Scan, compact and count " << count << " elements on the device"
+              << std::endl;
+
+    clrt::Primitives primitives(runtime, device);
+    if (!primitives.isValid()) {
+        return false;
+    }
+
+    // Random values (the same in every run of the program), the compaction keeps the values
+    // below the half of the range
+    const cl_int maxValue = 1000;
+    const cl_int threshold = maxValue / 2;
+    const std::size_t binCount = 16;
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<cl_int> valueDistribution(0, maxValue - 1);
+    std::vector<cl_int> values(count);
+    for (auto &value : values) {
+        value = valueDistribution(generator);
+    }
+
+    // Host references
+    std::vector<cl_uint> referenceScan(count);
+    std::vector<cl_int> referenceCompaction;
+    std::vector<cl_uint> referenceBins(binCount, 0);
+    {
+        clrt::TraceSpan span("primitives reference");
+        cl_uint sum = 0;
+        for (std::size_t i = 0; i < count; i++) {
+            referenceScan[i] = sum;
+            sum += static_cast<cl_uint>(values[i]);
+            if (values[i] < threshold) {
+                referenceCompaction.push_back(values[i]);
+            }
+            referenceBins[static_cast<std::size_t>(values[i]) * binCount / maxValue]++;
+        }
+    }
+
+    clrt::BufferPool &bufferPool = runtime.getBufferPool(device);
+    clrt::PooledBuffer input;
+    clrt::PooledBuffer output;
+    clrt::PooledBuffer outputCount;
+    clrt::PooledBuffer bins;
+    const std::size_t bufferSize = count * sizeof(cl_int);
+    if (!bufferPool.acquire(bufferSize, input) || !bufferPool.acquire(bufferSize, output)
+        || !bufferPool.acquire(sizeof(cl_uint), outputCount)
+        || !bufferPool.acquire(binCount * sizeof(cl_uint), bins)) {
+        return false;
+    }
+    const cl::CommandQueue &queue = runtime.getDeviceContext(device).queue;
+    cl_int err = queue.enqueueWriteBuffer(input.get(), CL_TRUE, 0, bufferSize, values.data());
+    if (err != CL_SUCCESS) {
+        clrt::reportError("CommandQueue::enqueueWriteBuffer failed", err);
+        return false;
+    }
+
+    // Time every primitive on the device and compare its result with the reference (only the
+    // validation reads the results)
+    typedef std::function<bool()> PrimitiveRun;
+    std::vector<std::pair<std::string, PrimitiveRun>> runs;
+    runs.emplace_back("exclusive scan", [&]() {
+        return primitives.exclusiveScan(input.get(), output.get(), count);
+    });
+    runs.emplace_back("compaction", [&]() {
+        return primitives.compact(input.get(), count, clrt::CompactPredicate::Less, threshold,
+                                  output.get(), outputCount.get());
+    });
+    runs.emplace_back("histogram", [&]() {
+        return primitives.histogram(input.get(), count, 0, maxValue, binCount, bins.get());
+    });
+    benchmark.setDevice(device);
+    for (std::size_t run = 0; run < runs.size(); run++) {
+        clrt::BenchmarkStatistics statistics;
+        const auto runPrimitive = [&](uint64_t &timeNs) {
+            if (!runs[run].second() || queue.finish() != CL_SUCCESS) {
+                return false;
+            }
+            timeNs = primitives.getLastDurationNs();
+            return true;
+        };
+        if (!benchmark.run({ runs[run].first, 2 * bufferSize, count }, runPrimitive, statistics)) {
+            return false;
+        }
+        std::cout << "\t\t\t" << runs[run].first << ": " << clrt::displayStatistics(statistics)
+                  << std::endl;
+    }
+
+    // The scan and the compaction share the output buffer, so both are run again before their
+    // results are read
+    std::vector<cl_uint> scanResult(count);
+    std::vector<cl_int> compactionResult(count);
+    cl_uint compactionCount = 0;
+    std::vector<cl_uint> binResult(binCount);
+    if (!primitives.compact(input.get(), count, clrt::CompactPredicate::Less, threshold,
+                            output.get(), outputCount.get())
+        || queue.enqueueReadBuffer(outputCount.get(), CL_TRUE, 0, sizeof(cl_uint),
+                                   &compactionCount) != CL_SUCCESS
+        || compactionCount > count
+        || queue.enqueueReadBuffer(output.get(), CL_TRUE, 0, compactionCount * sizeof(cl_int),
+                                   compactionResult.data()) != CL_SUCCESS
+        || !primitives.exclusiveScan(input.get(), output.get(), count)
+        || queue.enqueueReadBuffer(output.get(), CL_TRUE, 0, bufferSize,
+                                   scanResult.data()) != CL_SUCCESS
+        || queue.enqueueReadBuffer(bins.get(), CL_TRUE, 0, binCount * sizeof(cl_uint),
+                                   binResult.data()) != CL_SUCCESS) {
+        clrt::reportError("The results of the primitives could not be read");
+        return false;
+    }
+    compactionResult.resize(compactionCount);
+    bool success = true;
+    if (scanResult != referenceScan) {
+        std::cout << "\t\t\033[1;31mCalculation errors in the exclusive scan\033[0m"
+                  << std::endl;
+        success = false;
+    }
+    if (compactionResult != referenceCompaction) {
+        std::cout << "\t\t\033[1;31mCalculation errors in the compaction (" << compactionCount
+                  << " instead of " << referenceCompaction.size() << " elements)\033[0m"
+                  << std::endl;
+        success = false;
+    }
+    if (binResult != referenceBins) {
+        std::cout << "\t\t\033[1;31mCalculation errors in the histogram\033[0m" << std::endl;
+        success = false;
+    }
+    return success;
+}
+
+const bool runJobServerLoad(clrt::Runtime &runtime, const Options &options)
+{
+    std::cout << "\033[1;34mRun small jobs of many producer threads with a job server:\033[0m"
+              << std::endl;
+
+    // Every producer keeps a few jobs per device in flight, each with its own buffer
+    const std::size_t jobElementCount = 4096;
+    const std::size_t jobsPerProducer = 512;
+    const std::size_t jobsInFlight = 4;
+
+    std::vector<cl::Device> devices;
+    std::vector<clrt::Program> programs;
+    for (auto const &device : runtime.getDevices()) {
+        if (!device.getInfo<CL_DEVICE_AVAILABLE>()) {
+            continue;
+        }
+        programs.emplace_back();
+        if (!buildExampleProgram(runtime, device, programs.back())) {
+            return false;
+        }
+        devices.push_back(device);
+    }
+    if (devices.empty()) {
+        return true;
+    }
+    clrt::JobServer server(runtime, devices);
+    std::cout << "\t" << server.getWorkerCount() << " worker(s)/command queue(s) on "
+              << devices.size() << " device(s), " << jobsPerProducer << " jobs of "
+              << jobElementCount << " elements per producer" << std::endl;
+
+    // Producers that submit jobs round robin to all devices and wait for the previous job of a
+    // buffer before they reuse it
+    std::atomic<bool> failed(false);
+    const auto produce = [&]() {
+        std::vector<clrt::PooledBuffer> buffers(devices.size() * jobsInFlight);
+        std::vector<std::future<clrt::JobResult>> futures(buffers.size());
+        for (std::size_t slot = 0; slot < buffers.size(); slot++) {
+            if (!runtime.getBufferPool(devices[slot / jobsInFlight])
+                .acquire(jobElementCount * sizeof(cl_int), buffers[slot])) {
+                failed = true;
+                return;
+            }
+        }
+        for (std::size_t job = 0; job < jobsPerProducer && !failed; job++) {
+            const std::size_t slot = job % buffers.size();
+            if (futures[slot].valid() && !futures[slot].get().success) {
+                failed = true;
+            }
+            if (!server.submit(programs[slot / jobsInFlight], exampleKernelName,
+                               { buffers[slot].get() }, cl::NDRange(jobElementCount),
+                               futures[slot])) {
+                failed = true;
+            }
+        }
+        // The buffers are given back to the pool, wait for their jobs first
+        for (auto &future : futures) {
+            if (future.valid() && !future.get().success) {
+                failed = true;
+            }
+        }
     };
-    std::string variableString = "";
-    for (auto const &variable : variables) {
-        variableString += std::string(" -D") + std::get<0>(variable) + std::string("=") + std::get<1>
-                          (variable);
+
+    // Throughput for 1, 2, 4, ... producer threads
+    std::vector<unsigned int> threadCounts;
+    for (unsigned int threadCount = 1; threadCount < options.serveThreadCount; threadCount *= 2) {
+        threadCounts.push_back(threadCount);
     }
-    //std::cout << "variableString: \"" << variableString << "\"" << std::endl;
+    threadCounts.push_back(options.serveThreadCount);
+    for (auto const &threadCount : threadCounts) {
+        server.resetStatistics();
+        const auto begin = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for (unsigned int i = 0; i < threadCount; i++) {
+            threads.emplace_back(produce);
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        const uint64_t wallNs = std::chrono::duration_cast<std::chrono::nanoseconds>
+                                (std::chrono::steady_clock::now() - begin).count();
+        if (failed) {
+            return false;
+        }
+        const std::size_t jobCount = threadCount * jobsPerProducer;
+        std::cout << "\t" << threadCount << " producer thread(s): " << jobCount << " jobs in "
+                  << displayTimeAndSpeedup(wallNs) << " => " << 1e9 * jobCount / wallNs
+                  << " jobs/s" << std::endl;
+        for (auto const &queue : server.getStatistics()) {
+            std::cout << "\t\tQueue " << queue.workerIndex << " (" << queue.deviceName << "): "
+                      << queue.jobCount << " job(s) (" << queue.stolenJobCount << " stolen) in "
+                      << queue.flushCount << " flush(es), " << queue.jobsPerSecond
+                      << " jobs/s, latency median "
+                      << displayTimeAndSpeedup(queue.medianLatencyNs) << " p99 "
+                      << displayTimeAndSpeedup(queue.p99LatencyNs) << std::endl;
+        }
+    }
+    return true;
+}
+
+const bool runPackedKernelOnOpenClDevice(clrt::Runtime &runtime, clrt::Benchmark &benchmark,
+                                         cl::Device &device, const Options &options)
+{
+    if (!device.getInfo<CL_DEVICE_AVAILABLE>()) {
+        return true;
+    }
+    const clrt::StorageCodec &codec = options.storage;
+    const std::size_t count = options.size;
+    const std::size_t blockCount = codec.getBlockCount(count);
+    const std::size_t storageSize = codec.getStorageSize(count);
+    const std::size_t bufferSize = count * sizeof(cl_int);
+    std::cout << "\t\t>> Transfer the array in the storage format " << codec.getName() << " ("
+              << codec.getBytesPerElement() << " bytes per element instead of "
+              << sizeof(cl_int) << ")" << std::endl;
 
-    // Build the program and check if compilation was successful
-    cl::Program program(context, sources);
-    if (program.build({device}, variableString.c_str()) != CL_SUCCESS) {
-        std::cout << "\t\t\033[1;31mError building:\033[0m "
-                  << program.getBuildInfo<CL_PROGRAM_BUILD_LOG>(device) << std::endl;
+    clrt::Program program;
+    clrt::Kernel packKernel;
+    clrt::Kernel unpackKernel;
+    if (!buildExampleProgram(runtime, device, program, 1, codec)
+        || !program.createKernel(examplePackedKernelName, packKernel)
+        || !program.createKernel("storage_unpack", unpackKernel)) {
         return false;
     }
 
-    // Create vector which we will read and write
-    memset(vec.data(), -1, vec.size());
+    // The host encodes the values of the example kernel in the same format, so the packed bytes
+    // of the device can be compared directly
+    std::vector<int32_t> values(count);
+    for (std::size_t i = 0; i < count; i++) {
+        values[i] = static_cast<int32_t>(static_cast<uint32_t>(i));
+    }
+    std::vector<cl_uint> expectedWords;
+    const std::size_t expectedOverflowCount = codec.encode(values.data(), count, expectedWords);
 
-    // Create buffer and check if the size is OK
-    const unsigned int bufferSize = sizeof(cl_int) * vec.size();
-    const uint64_t maxBufferSize = device.getInfo< CL_DEVICE_MAX_MEM_ALLOC_SIZE>();
-    if (bufferSize > maxBufferSize) {
-        std::cout << "\t\t\033[1;31mError: The buffer size (" << bufferSize
+    clrt::BufferPool &bufferPool = runtime.getBufferPool(device);
+    clrt::PooledBuffer packed;
+    clrt::PooledBuffer unpacked;
+    clrt::PooledBuffer overflowCount;
+    if (!bufferPool.acquire(storageSize, packed) || !bufferPool.acquire(bufferSize, unpacked)
+        || !bufferPool.acquire(sizeof(cl_uint), overflowCount)
+        || !unpackKernel.setArg(0, packed.get()) || !unpackKernel.setArg(1, unpacked.get())
+        || !unpackKernel.setArg(2, static_cast<cl_ulong>(count))
+        || !packKernel.setArg(0, packed.get())
+        || !packKernel.setArg(1, static_cast<cl_ulong>(count))
+        || !packKernel.setArg(2, overflowCount.get())) {
+        return false;
+    }
+    const cl::CommandQueue &queue = runtime.getDeviceContext(device).queue;
+
+    // Upload: Write the packed values and unpack them on the device
+    // Download: Pack the values on the device, read them and decode them into the typed view
+    // The effective bandwidth of both directions is the one of the 32 bit values
+    std::vector<cl_uint> words(expectedWords.size());
+    std::vector<int32_t> decoded(count);
+    std::vector<clrt::BenchmarkStatistics> phaseStatistics;
+    benchmark.setDevice(device);
+    const bool success = benchmark.run({
+        { "packed write", storageSize, 0 },
+        { "unpack kernel", storageSize + bufferSize, count },
+        { "pack kernel", storageSize, count },
+        { "packed read", storageSize, 0 },
+        { "host decode", storageSize + bufferSize, count },
+        { "packed upload", bufferSize, count },
+        { "packed download", bufferSize, count }
+    }, [&](std::vector<uint64_t> &phaseNs) {
+        cl::Event writeEvent;
+        cl::Event unpackEvent;
+        cl::Event clearEvent;
+        cl::Event packEvent;
+        cl::Event readEvent;
+        if (queue.enqueueWriteBuffer(packed.get(), CL_FALSE, 0, storageSize, expectedWords.data(),
+                                     nullptr, &writeEvent) != CL_SUCCESS
+            || !unpackKernel.enqueue(cl::NDRange(blockCount), cl::NullRange, nullptr,
+                                     &unpackEvent)
+            || queue.enqueueFillBuffer(overflowCount.get(), cl_uint(0), 0, sizeof(cl_uint),
+                                       nullptr, &clearEvent) != CL_SUCCESS
+            || !packKernel.enqueue(cl::NDRange(blockCount), cl::NullRange, nullptr, &packEvent)
+            || queue.enqueueReadBuffer(packed.get(), CL_TRUE, 0, storageSize, words.data(),
+                                       nullptr, &readEvent) != CL_SUCCESS) {
+            return false;
+        }
+        const auto begin = std::chrono::steady_clock::now();
+        codec.decode(words.data(), count, decoded.data());
+        phaseNs[4] = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>
+                                           (std::chrono::steady_clock::now() - begin).count());
+        phaseNs[0] = getTimeInNs(writeEvent);
+        phaseNs[1] = getTimeInNs(unpackEvent);
+        phaseNs[2] = getTimeInNs(packEvent);
+        phaseNs[3] = getTimeInNs(readEvent);
+        phaseNs[5] = phaseNs[0] + phaseNs[1];
+        phaseNs[6] = phaseNs[2] + phaseNs[3] + phaseNs[4];
+        return true;
+    }, phaseStatistics);
+    if (!success) {
+        return false;
+    }
+    std::cout << "\t\t\tTime (median):"
+              << "\n\t\t\t\tWrite packed:     " << clrt::displayStatistics(phaseStatistics[0])
+              << "\n\t\t\t\tUnpack kernel:    " << clrt::displayStatistics(phaseStatistics[1])
+              << "\n\t\t\t\t\t=> Upload:   " << clrt::displayStatistics(phaseStatistics[5])
+              << "\n\t\t\t\tPack kernel:      " << clrt::displayStatistics(phaseStatistics[2])
+              << "\n\t\t\t\tRead packed:      " << clrt::displayStatistics(phaseStatistics[3])
+              << "\n\t\t\t\tDecode (host):    " << clrt::displayStatistics(phaseStatistics[4])
+              << "\n\t\t\t\t\t=> Download: " << clrt::displayStatistics(phaseStatistics[6])
+              << std::endl;
+
+    // The packed bytes and the overflows have to be the ones of the host, the unpacked values
+    // the decoded ones (lossy formats only differ from the 32 bit values where they overflow)
+    cl_uint deviceOverflowCount = 0;
+    std::vector<int32_t> deviceUnpacked(count);
+    if (queue.enqueueReadBuffer(overflowCount.get(), CL_TRUE, 0, sizeof(cl_uint),
+                                &deviceOverflowCount) != CL_SUCCESS
+        || queue.enqueueReadBuffer(unpacked.get(), CL_TRUE, 0, bufferSize,
+                                   deviceUnpacked.data()) != CL_SUCCESS) {
+        clrt::reportError("The packed results could not be read");
+        return false;
+    }
+    std::size_t lossyCount = 0;
+    for (std::size_t i = 0; i < count; i++) {
+        lossyCount += decoded[i] != values[i] ? 1 : 0;
+    }
+    std::cout << "\t\t\tStorage: " << deviceOverflowCount << " of " << blockCount
+              << " block(s) overflowed, " << lossyCount << " value(s) differ from the 32 bit "
+              << "values" << std::endl;
+    if (words != expectedWords || deviceOverflowCount != expectedOverflowCount
+        || deviceUnpacked != decoded) {
+        std::cout << "\t\t\033[1;31mThe device and the host storage formats differ\033[0m"
+                  << std::endl;
+        return false;
+    }
+    return true;
+}
+
+const bool runPipelineOnOpenClDevice(clrt::Runtime &runtime, clrt::Benchmark &benchmark,
+                                     cl::Device &device, const Options &options)
+{
+    if (!device.getInfo<CL_DEVICE_AVAILABLE>()) {
+        return true;
+    }
+    const std::size_t count = options.pipelineSize;
+    const std::size_t mapCount = 4;
+    const std::size_t bufferSize = count * sizeof(cl_uint);
+    std::cout << "\t\t>> Run " << exampleKernelName << " and " << mapCount << " maps on " << count
+              << " elements as a pipeline" << std::endl;
+
+    // simple writes the indices into the first buffer and every map reads the buffer of the
+    // previous stage and writes the next one, only the last buffer is read by the host
+    clrt::Pipeline pipeline(runtime, device, exampleSourceFiles,
+                            createExampleConstants(device, 1, clrt::StorageCodec()));
+    std::vector<clrt::PipelineBufferId> buffers(mapCount + 1);
+    clrt::PipelineStageId stage = 0;
+    if (!pipeline.isValid()) {
+        return false;
+    }
+    for (auto &buffer : buffers) {
+        if (!pipeline.addBuffer(bufferSize, buffer)) {
+            return false;
+        }
+    }
+    if (!pipeline.addKernel(exampleKernelName, {}, { buffers[0] }, count, stage)) {
+        return false;
+    }
+    for (std::size_t i = 0; i < mapCount; i++) {
+        const char *const *map = examplePipelineMaps[i % 2];
+        if (!pipeline.addMap(map[0], map[1], buffers[i], buffers[i + 1], count, stage)) {
+            return false;
+        }
+    }
+    std::size_t fusedCount = 0;
+    if (!pipeline.fuse(fusedCount)) {
+        return false;
+    }
+
+    // Host reference of the functions of kernel_helper.cl
+    std::vector<cl_uint> expected(count);
+    for (std::size_t i = 0; i < count; i++) {
+        cl_uint value = static_cast<cl_uint>(i);
+        for (std::size_t map = 0; map < mapCount; map++) {
+            value = map % 2 == 0 ? value - 1 : mixBits(value);
+        }
+        expected[i] = value;
+    }
+
+    // Run the stages one by one and with the fused maps, the output is cleared before the
+    // validated run so that it has to be written by it
+    const cl::CommandQueue &queue = runtime.getDeviceContext(device).queue;
+    cl::Buffer &output = pipeline.getBuffer(buffers.back());
+    std::vector<cl_uint> result(count);
+    uint64_t unfusedNs = 0;
+    benchmark.setDevice(device);
+    for (const bool fused : { false, true }) {
+        clrt::PipelineStatistics statistics;
+        if (queue.enqueueFillBuffer(output, cl_uint(0), 0, bufferSize) != CL_SUCCESS
+            || !pipeline.run(fused) || !pipeline.getLastStatistics(statistics)
+            || queue.enqueueReadBuffer(output, CL_TRUE, 0, bufferSize,
+                                       result.data()) != CL_SUCCESS) {
+            clrt::reportError("The pipeline could not be run");
+            return false;
+        }
+        if (result != expected) {
+            std::cout << "\t\t\033[1;31mThe results of the " << (fused ? "fused " : "")
+                      << "pipeline are wrong\033[0m" << std::endl;
+            return false;
+        }
+
+        // The bandwidth is the one of the global memory traffic of all launches
+        const std::string name = fused ? "pipeline (fused)" : "pipeline";
+        clrt::BenchmarkStatistics benchmarkStatistics;
+        const bool success = benchmark.run({ name, statistics.deviceBytes, count },
+        [&](uint64_t &timeNs) {
+            if (!pipeline.run(fused) || !pipeline.getLastStatistics(statistics)) {
+                return false;
+            }
+            timeNs = statistics.durationNs;
+            return true;
+        }, benchmarkStatistics);
+        if (!success) {
+            return false;
+        }
+        std::cout << "\t\t\t" << (fused ? "Fused" : "Stages") << ": "
+                  << clrt::displayStatistics(benchmarkStatistics) << std::endl;
+        for (auto const &launch : statistics.launches) {
+            std::cout << "\t\t\t\t" << launch.name << ": "
+                      << displayTimeAndSpeedup(launch.durationNs) << ", "
+                      << launch.bytes / pow(1024.0, 2) << "MB" << std::endl;
+        }
+        if (!fused) {
+            unfusedNs = benchmarkStatistics.medianNs;
+            std::cout << "\t\t\tIntermediates on the device: "
+                      << statistics.savedTransferBytes / pow(1024.0, 2)
+                      << "MB of host transfers avoided" << std::endl;
+        } else {
+            std::cout << "\t\t\tFusion: " << fusedCount << " fused kernel(s), "
+                      << mapCount + 1 - statistics.launches.size() << " launch(es) and "
+                      << statistics.savedDeviceBytes / pow(1024.0, 2)
+                      << "MB of global memory traffic saved, "
+                      << displayTimeAndSpeedup(benchmarkStatistics.medianNs, true, unfusedNs)
+                      << std::endl;
+        }
+    }
+    return true;
+}
+
+const bool runSortBenchmark(clrt::Runtime &runtime, clrt::Benchmark &benchmark,
+                            clrt::HostEngine &hostEngine, const std::vector<cl::Device> &devices,
+                            const Options &options)
+{
+    // 1M, 10M, 100M and 1B keys (only the maximum if it is smaller)
+    std::vector<std::size_t> sizes;
+    for (std::size_t size = 1000000; size <= std::min<std::size_t>(options.sortSize, 1000000000);
+         size *= 10) {
+        sizes.push_back(size);
+    }
+    if (sizes.empty()) {
+        sizes.push_back(options.sortSize);
+    }
+    std::cout << "\033[1;34mSort random 32 bit, signed 32 bit and signed 64 bit keys:\033[0m"
+              << std::endl;
+
+    bool success = true;
+    std::mt19937 generator(42);
+    for (auto const &count : sizes) {
+        std::cout << "\t>> " << count << " keys" << std::endl;
+        std::vector<cl_uint> keys(count);
+        for (auto &key : keys) {
+            key = static_cast<cl_uint>(generator());
+        }
+
+        // Only the sorts are timed (not the copies of the unsorted keys), the last host sort
+        // leaves the reference of the devices
+        std::vector<cl_uint> sortedKeys(count);
+        const auto timeHostSort = [&](const std::string &name, const std::function<void()> &sort) {
+            clrt::BenchmarkStatistics statistics;
+            const auto runSort = [&](uint64_t &timeNs) {
+                std::copy(keys.begin(), keys.end(), sortedKeys.begin());
+                const auto begin = std::chrono::steady_clock::now();
+                sort();
+                timeNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>
+                                               (std::chrono::steady_clock::now() - begin).count());
+                return true;
+            };
+            benchmark.setHost();
+            benchmark.run({ name, count * sizeof(cl_uint), count }, runSort, statistics);
+            std::cout << "\t\t" << name << ": " << clrt::displayStatistics(statistics)
+                      << std::endl;
+            return statistics.medianNs;
+        };
+        const uint64_t stdSortNs = timeHostSort("std::sort", [&]() {
+            std::sort(sortedKeys.begin(), sortedKeys.end());
+        });
+        const std::string hostSortName = "host sort (" + std::to_string(hostEngine.getThreadCount())
+                                         + " threads)";
+        timeHostSort(hostSortName, [&]() {
+            hostEngine.sort(sortedKeys.data(), sortedKeys.size());
+        });
+        if (!std::is_sorted(sortedKeys.begin(), sortedKeys.end())) {
+            std::cout << "\t\t\033[1;31mThe keys of the host sort are not sorted\033[0m"
+                      << std::endl;
+            return false;
+        }
+
+        for (auto const &device : devices) {
+            if (device.getInfo<CL_DEVICE_AVAILABLE>()
+                && !runRadixSortOnOpenClDevice(runtime, benchmark, device,
+                                               clrt::RadixKeyType::UInt32, "", keys, sortedKeys,
+                                               stdSortNs)) {
+                success = false;
+            }
+        }
+
+        // Signed keys flip their sign bits and 64 bit keys need twice the passes, so both are
+        // validated as well
+        if (!runTypedSortBenchmark<cl_int>(runtime, benchmark, devices, clrt::RadixKeyType::Int32,
+                                           "signed 32 bit", count, generator)
+            || !runTypedSortBenchmark<cl_long>(runtime, benchmark, devices,
+                                               clrt::RadixKeyType::Int64, "signed 64 bit", count,
+                                               generator)) {
+            success = false;
+        }
+    }
+    return success;
+}
+
+template <typename Key>
+const bool runTypedSortBenchmark(clrt::Runtime &runtime, clrt::Benchmark &benchmark,
+                                 const std::vector<cl::Device> &devices,
+                                 const clrt::RadixKeyType &keyType, const std::string &typeName,
+                                 const std::size_t &count, std::mt19937 &generator)
+{
+    // Random bits of the whole key, so half of the keys are negative
+    std::vector<Key> keys(count);
+    for (auto &key : keys) {
+        uint64_t bits = generator();
+        if (sizeof(Key) > sizeof(cl_uint)) {
+            bits = bits << 32 | generator();
+        }
+        key = static_cast<Key>(bits);
+    }
+
+    // Only std::sort is timed as reference (the host sort only sorts 32 bit keys)
+    const std::string name = "std::sort (" + typeName + ")";
+    std::vector<Key> sortedKeys(count);
+    clrt::BenchmarkStatistics statistics;
+    const auto runSort = [&](uint64_t &timeNs) {
+        std::copy(keys.begin(), keys.end(), sortedKeys.begin());
+        const auto begin = std::chrono::steady_clock::now();
+        std::sort(sortedKeys.begin(), sortedKeys.end());
+        timeNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>
+                                       (std::chrono::steady_clock::now() - begin).count());
+        return true;
+    };
+    benchmark.setHost();
+    benchmark.run({ name, count * sizeof(Key), count }, runSort, statistics);
+    std::cout << "\t\t" << name << ": " << clrt::displayStatistics(statistics) << std::endl;
+
+    bool success = true;
+    for (auto const &device : devices) {
+        if (device.getInfo<CL_DEVICE_AVAILABLE>()
+            && !runRadixSortOnOpenClDevice(runtime, benchmark, device, keyType, typeName, keys,
+                                           sortedKeys, statistics.medianNs)) {
+            success = false;
+        }
+    }
+    return success;
+}
+
+template <typename Key>
+const bool runRadixSortOnOpenClDevice(clrt::Runtime &runtime, clrt::Benchmark &benchmark,
+                                      const cl::Device &device, const clrt::RadixKeyType &keyType,
+                                      const std::string &typeName, const std::vector<Key> &keys,
+                                      const std::vector<Key> &sortedKeys,
+                                      const uint64_t &stdSortNs)
+{
+    // The unsigned 32 bit keys keep the phase name of the earlier results
+    const std::string name = "radix sort " + (typeName.empty() ? "" : typeName + " ") + "("
+                             + clrt::trimInfoString(device.getInfo<CL_DEVICE_NAME>()) + ")";
+    clrt::RadixSort radixSort(runtime, device, keyType);
+    if (!radixSort.isValid()) {
+        return false;
+    }
+    const std::size_t count = keys.size();
+    const std::size_t bufferSize = count * sizeof(Key);
+    const std::size_t valueBufferSize = count * sizeof(cl_uint);
+    // The keys, the values and their temporary buffers have to fit into the device (the sort
+    // does not split them into tiles)
+    const uint64_t maxBufferSize = device.getInfo<CL_DEVICE_MAX_MEM_ALLOC_SIZE>();
+    const uint64_t globalMemorySize = device.getInfo<CL_DEVICE_GLOBAL_MEM_SIZE>();
+    if (count > radixSort.getMaxCount()
+        || 2 * (static_cast<uint64_t>(bufferSize) + valueBufferSize) > globalMemorySize) {
+        std::cout << "\t\t" << name << ": Skipped, the buffer size (" << bufferSize
                   << ") is bigger than the device max mem alloc size (" << maxBufferSize
-                  << ")!\033[0m " << std::endl;
+                  << ") or 4 buffers do not fit into the global memory (" << globalMemorySize
+                  << ")" << std::endl;
+        return true;
+    }
+    clrt::BufferPool &bufferPool = runtime.getBufferPool(device);
+    clrt::PooledBuffer keyBuffer;
+    clrt::PooledBuffer valueBuffer;
+    if (!bufferPool.acquire(bufferSize, keyBuffer)
+        || !bufferPool.acquire(valueBufferSize, valueBuffer)) {
+        return false;
+    }
+    const cl::CommandQueue &queue = runtime.getDeviceContext(device).queue;
+
+    // Every repetition sorts the unsorted keys (the upload is not timed)
+    clrt::BenchmarkStatistics statistics;
+    const auto runSort = [&](uint64_t &timeNs) {
+        if (queue.enqueueWriteBuffer(keyBuffer.get(), CL_FALSE, 0, bufferSize,
+                                     keys.data()) != CL_SUCCESS
+            || !radixSort.sort(keyBuffer.get(), count) || queue.finish() != CL_SUCCESS) {
+            return false;
+        }
+        timeNs = radixSort.getLastDurationNs();
+        return true;
+    };
+    benchmark.setDevice(device);
+    if (!benchmark.run({ name, 2 * bufferSize, count }, runSort, statistics)) {
+        return false;
+    }
+    std::cout << "\t\t" << name << ": " << clrt::displayStatistics(statistics)
+              << "\n\t\t\t=> Speedup over std::sort: "
+              << static_cast<double>(stdSortNs) / std::max<uint64_t>(1, statistics.medianNs)
+              << std::endl;
+    std::vector<Key> result(count);
+    if (queue.enqueueReadBuffer(keyBuffer.get(), CL_TRUE, 0, bufferSize,
+                                result.data()) != CL_SUCCESS) {
+        clrt::reportError("The sorted keys could not be read");
+        return false;
+    }
+    if (result != sortedKeys) {
+        std::cout << "\t\t\033[1;31mThe keys of the " << name << " are not sorted\033[0m"
+                  << std::endl;
         return false;
     }
 
-    // Allocate buffer on the OpenCL device for the vector data
-    cl::Buffer buffer_output(context, CL_MEM_READ_ONLY, bufferSize);
+    // Sort the keys with their indices as values: Equal keys have to keep the order of their
+    // indices and every index has to point to its key
+    std::vector<cl_uint> indices(count);
+    for (std::size_t i = 0; i < count; i++) {
+        indices[i] = static_cast<cl_uint>(i);
+    }
+    if (queue.enqueueWriteBuffer(keyBuffer.get(), CL_FALSE, 0, bufferSize,
+                                 keys.data()) != CL_SUCCESS
+        || queue.enqueueWriteBuffer(valueBuffer.get(), CL_FALSE, 0, valueBufferSize,
+                                    indices.data()) != CL_SUCCESS
+        || !radixSort.sortPairs(keyBuffer.get(), valueBuffer.get(), count)
+        || queue.enqueueReadBuffer(keyBuffer.get(), CL_TRUE, 0, bufferSize,
+                                   result.data()) != CL_SUCCESS
+        || queue.enqueueReadBuffer(valueBuffer.get(), CL_TRUE, 0, valueBufferSize,
+                                   indices.data()) != CL_SUCCESS) {
+        clrt::reportError("The key-value pairs could not be sorted");
+        return false;
+    }
+    for (std::size_t i = 0; i < count; i++) {
+        if (result[i] != sortedKeys[i] || indices[i] >= count || keys[indices[i]] != result[i]
+            || (i > 0 && result[i] == result[i - 1] && indices[i] <= indices[i - 1])) {
+            std::cout << "\t\t\033[1;31mThe key-value pairs of the " << name
+                      << " are not sorted stably\033[0m" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
 
-    // Create a queue of commands that will be executed on the OpenCL device
-    cl::CommandQueue queue(context, device, CL_QUEUE_PROFILING_ENABLE);
+const bool runKernelOnAllOpenClDevices(clrt::Runtime &runtime,
+                                       clrt::MultiDeviceScheduler &scheduler,
+                                       clrt::Benchmark &benchmark, HostVector &vec,
+                                       const uint64_t &cpuTimeNs)
+{
+    std::cout << "\033[1;34mRun example kernel on all OpenCL devices at the same time:\033[0m"
+              << std::endl;
 
-    // Write current vector data to the OpenCL buffer
-    cl::Event eventWriteToBuffer;
-    queue.enqueueWriteBuffer(buffer_output, CL_TRUE, 0, sizeof(cl_int) * vec.size(), vec.data(), NULL,
-                             &eventWriteToBuffer);
+    // Create the kernel on every available device (the programs were already built above)
+    std::vector<clrt::Kernel> kernels;
+    for (auto const &device : runtime.getDevices()) {
+        if (!device.getInfo<CL_DEVICE_AVAILABLE>()) {
+            continue;
+        }
+        clrt::Program program;
+        kernels.emplace_back();
+        if (!buildExampleProgram(runtime, device, program)
+            || !program.createKernel(exampleKernelName, kernels.back())) {
+            return false;
+        }
+    }
 
-    // Run the kernel/program on the OpenCL device
-    cl::Kernel kernel_simple = cl::Kernel(program, kernelName);
-    kernel_simple.setArg(0, buffer_output);
-    cl::Event eventKernelExecution;
-    queue.enqueueNDRangeKernel(kernel_simple, cl::NullRange, cl::NDRange(vec.size()), cl::NullRange,
-                               NULL, &eventKernelExecution);
+    clrt::PartitionStatistics statistics;
+    clrt::BenchmarkStatistics wallStatistics;
+    benchmark.setHost();
+    const auto runAllDevices = [&](uint64_t &timeNs) {
+        // Reset the vector so that every repetition has to write all values again
+        memset(vec.data(), -1, vec.size() * sizeof(int));
+        if (!scheduler.run(kernels, vec.data(), sizeof(cl_int), vec.size(), statistics)) {
+            return false;
+        }
+        timeNs = statistics.wallNs;
+        return true;
+    };
+    if (!benchmark.run({ "all devices", sizeof(cl_int) * vec.size(), vec.size() }, runAllDevices,
+                       wallStatistics)) {
+        return false;
+    }
 
-    // Read the new values in the OpenCL device back into to the host into out vector
-    cl::Event eventReadFromBuffer;
-    queue.enqueueReadBuffer(buffer_output, CL_TRUE, 0, sizeof(cl_int) * vec.size(), vec.data(), NULL,
-                            &eventReadFromBuffer);
+    // Display the split of the last repetition
+    for (auto const &share : statistics.devices) {
+        std::cout << "\t" << share.deviceName << ": " << share.elementCount << " elements ("
+                  << 100.0 * share.elementCount / vec.size() << "%) in " << share.packetCount
+                  << " packet(s), " << share.elementsPerNs * 1e9 << " elements/s" << std::endl;
+    }
+    std::cout << "\tTime (median):\n\t\t=> Wall:  "
+              << displayTimeAndSpeedup(wallStatistics.medianNs, true, cpuTimeNs)
+              << "\n\t\t   " << clrt::displayStatistics(wallStatistics) << std::endl;
+    return checkResults(vec);
+}
 
-    // Calculate all times
-    const auto writeToBufferNs = getTimeInNs(eventWriteToBuffer);
-    const auto kernelExecutionNs = getTimeInNs(eventKernelExecution);
-    const auto readFromBufferNs = getTimeInNs(eventReadFromBuffer);
-    const auto wholeTimeNs = writeToBufferNs + kernelExecutionNs + readFromBufferNs;
-    std::cout << "\t\t\tTime:\n\t\t\t\tWrite to buffer:  " << writeToBufferNs
-              << "ns\n\t\t\t\tKernel execution: " << kernelExecutionNs
-              << "ns\n\t\t\t\tRead from buffer: " << readFromBufferNs
-              << "ns\n\t\t\t\t\t=> Sum:   " << displayTimeAndSpeedup(wholeTimeNs, true, cpuTimeNs) << std::endl;
+const bool buildExampleProgram(clrt::Runtime &runtime, const cl::Device &device,
+                               clrt::Program &program, const unsigned int &vectorWidth,
+                               const clrt::StorageCodec &storage)
+{
+    // Create the program that should be executed that is equivalent to the host code
+    return runtime.buildSpecializedProgram(device, exampleSourceFiles,
+                                           createExampleConstants(device, vectorWidth, storage),
+                                           program);
+}
 
-    // Check if the "calculation" was successful
-    unsigned int errorCount = 0;
+const clrt::Specialization createExampleConstants(const cl::Device &device,
+                                                  const unsigned int &vectorWidth,
+                                                  const clrt::StorageCodec &storage)
+{
+    clrt::Specialization constants = clrt::Specialization()
+                                     .set("MAX_WG_SIZE",
+                                          device.getInfo<CL_DEVICE_MAX_WORK_GROUP_SIZE>())
+                                     .set("VECTOR_WIDTH", vectorWidth);
+    storage.addConstants(constants);
+    return constants;
+}
+
+const bool createVectorKernel(clrt::Runtime &runtime, clrt::WorkGroupTuner &tuner,
+                              const cl::Device &device, const cl::Buffer &buffer,
+                              const std::size_t &count, const Options &options,
+                              unsigned int &vectorWidth, std::string &widthSource,
+                              clrt::Kernel &kernel)
+{
+    const auto create = [&](const unsigned int &width, clrt::Kernel &widthKernel) {
+        clrt::Program program;
+        return buildExampleProgram(runtime, device, program, width)
+               && program.createKernel(exampleVectorKernelName, widthKernel)
+               && widthKernel.setArg(0, buffer)
+               && widthKernel.setArg(1, static_cast<cl_ulong>(count));
+    };
+    if (options.vectorWidth > 0) {
+        vectorWidth = options.vectorWidth;
+        widthSource = "option";
+        return create(vectorWidth, kernel);
+    }
+
+    // Biggest width that is not wider than the preferred int vector width of the device
+    const cl_uint preferredWidth = device.getInfo<CL_DEVICE_PREFERRED_VECTOR_WIDTH_INT>();
+    vectorWidth = 1;
+    for (auto const &width : exampleVectorWidths) {
+        if (width <= preferredWidth) {
+            vectorWidth = width;
+        }
+    }
+    widthSource = "preferred";
+
+    // The fastest width if all widths were tuned (tune them first if requested)
+    unsigned int fastestWidth = vectorWidth;
+    uint64_t fastestNs = std::numeric_limits<uint64_t>::max();
+    for (auto const &width : exampleVectorWidths) {
+        const std::string widthKernelName = exampleVectorKernelName + std::to_string(width);
+        const cl::NDRange global((count + width - 1) / width);
+        if (options.tune) {
+            clrt::Kernel widthKernel;
+            cl::NDRange local;
+            if (!create(width, widthKernel)
+                || !tuner.tune(widthKernel, widthKernelName, global, local)) {
+                return false;
+            }
+        }
+        uint64_t kernelNs = 0;
+        if (!tuner.lookupKernelTime(device, widthKernelName, global, kernelNs)) {
+            return create(vectorWidth, kernel);
+        }
+        if (kernelNs < fastestNs) {
+            fastestNs = kernelNs;
+            fastestWidth = width;
+        }
+    }
+    vectorWidth = fastestWidth;
+    widthSource = options.tune ? "tuned" : "stored";
+    return create(vectorWidth, kernel);
+}
+
+const bool checkResults(const HostVector &vec)
+{
+    clrt::TraceSpan span("validate on host");
+    std::size_t errorCount = 0;
     // display errors (the first 10 then ...
     // and error count
-    for (unsigned int i = 0; i < vec.size(); i++) {
+    for (std::size_t i = 0; i < vec.size(); i++) {
         if (static_cast<int>(i) != vec[i]) {
             if (errorCount < 10) {
                 std::cout << "\t\t\t\033[1;31mCalculation error in kernel execution! (" << i << "=!" << vec[i]
@@ -221,6 +1913,15 @@ const bool runKernelOnOpenClDevice(cl::Device &device, std::vector<int> &vec,
     }
 }
 
+const cl_uint mixBits(cl_uint value)
+{
+    value ^= value >> 16;
+    value *= 0x85EBCA6BU;
+    value ^= value >> 13;
+    value *= 0xC2B2AE35U;
+    return value ^ (value >> 16);
+}
+
 inline const uint64_t getTimeInNs(cl::Event &openClEvent)
 {
     return openClEvent.getProfilingInfo<CL_PROFILING_COMMAND_END>() -
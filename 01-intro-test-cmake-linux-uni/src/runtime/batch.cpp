@@ -0,0 +1,247 @@
+#include "batch.hpp"
+
+// Include project headers
+#include "benchmark.hpp"
+#include "trace.hpp"
+
+// Include stl libraries
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+const uint64_t getElapsedNs(const std::chrono::steady_clock::time_point &begin)
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>
+                                 (std::chrono::steady_clock::now() - begin).count());
+}
+
+}
+
+namespace clrt {
+
+BatchLauncher::BatchLauncher(Runtime &runtime, const cl::Device &device)
+    : deviceContext(runtime.getDeviceContext(device)), bufferPool(runtime.getBufferPool(device))
+{
+}
+
+const bool BatchLauncher::run(Kernel &batchedKernel, const std::vector<BatchJob> &jobs,
+                              const std::size_t &elementSize, BatchStatistics &statistics)
+{
+    statistics = BatchStatistics();
+    statistics.jobCount = jobs.size();
+    statistics.launchCount = 1;
+    if (&batchedKernel.getDeviceContext() != &deviceContext) {
+        reportError("BatchLauncher::run: The kernel was created for another device");
+        return false;
+    }
+    const auto begin = std::chrono::steady_clock::now();
+
+    // Pack the jobs behind each other and remember where every job starts
+    {
+        TraceSpan span("pack batch");
+        offsets.assign(1, 0);
+        std::size_t elementCount = 0;
+        for (auto const &job : jobs) {
+            elementCount += job.elementCount;
+            if (elementCount > std::numeric_limits<cl_uint>::max()) {
+                reportError("BatchLauncher::run: The jobs have more elements than the offsets "
+                            "table can address");
+                return false;
+            }
+            offsets.push_back(static_cast<cl_uint>(elementCount));
+        }
+        statistics.elementCount = elementCount;
+        packedData.resize(elementCount * elementSize);
+        for (std::size_t job = 0; job < jobs.size(); job++) {
+            if (jobs[job].elementCount > 0) {
+                std::memcpy(packedData.data() + offsets[job] * elementSize, jobs[job].data,
+                            jobs[job].elementCount * elementSize);
+            }
+        }
+    }
+    statistics.packNs = getElapsedNs(begin);
+    if (statistics.elementCount == 0) {
+        statistics.wallNs = getElapsedNs(begin);
+        return true;
+    }
+
+    // Write the packed jobs and the offsets table, process all elements with one NDRange and
+    // read the packed results back
+    PooledBuffer dataBuffer;
+    PooledBuffer offsetsBuffer;
+    const std::size_t dataSize = packedData.size();
+    const std::size_t offsetsSize = offsets.size() * sizeof(cl_uint);
+    if (!bufferPool.acquire(dataSize, dataBuffer)
+        || !bufferPool.acquire(offsetsSize, offsetsBuffer)) {
+        return false;
+    }
+    const cl::CommandQueue &queue = deviceContext.queue;
+    // Wait for the enqueued commands before the buffers are given back to the pool
+    const auto fail = [&queue]() {
+        queue.finish();
+        return false;
+    };
+    cl::Event writeDataEvent;
+    cl::Event writeOffsetsEvent;
+    cl_int err = queue.enqueueWriteBuffer(dataBuffer.get(), CL_FALSE, 0, dataSize,
+                                          packedData.data(), nullptr, &writeDataEvent);
+    if (err == CL_SUCCESS) {
+        traceCommand("write batch", &writeDataEvent);
+        err = queue.enqueueWriteBuffer(offsetsBuffer.get(), CL_FALSE, 0, offsetsSize,
+                                       offsets.data(), nullptr, &writeOffsetsEvent);
+    }
+    if (err != CL_SUCCESS) {
+        reportError("CommandQueue::enqueueWriteBuffer failed", err);
+        return fail();
+    }
+    traceCommand("write batch offsets", &writeOffsetsEvent);
+    cl::Event kernelEvent;
+    if (!batchedKernel.setArg(0, dataBuffer.get()) || !batchedKernel.setArg(1, offsetsBuffer.get())
+        || !batchedKernel.setArg(2, static_cast<cl_uint>(jobs.size()))
+        || !batchedKernel.enqueue(cl::NDRange(statistics.elementCount), cl::NullRange, nullptr,
+                                  &kernelEvent)) {
+        return fail();
+    }
+    cl::Event readEvent;
+    err = queue.enqueueReadBuffer(dataBuffer.get(), CL_TRUE, 0, dataSize, packedData.data(),
+                                  nullptr, &readEvent);
+    if (err != CL_SUCCESS) {
+        reportError("CommandQueue::enqueueReadBuffer failed", err);
+        return fail();
+    }
+    traceCommand("read batch", &readEvent);
+
+    // Scatter the results back into the jobs
+    const auto scatterBegin = std::chrono::steady_clock::now();
+    {
+        TraceSpan span("scatter batch");
+        for (std::size_t job = 0; job < jobs.size(); job++) {
+            if (jobs[job].elementCount > 0) {
+                std::memcpy(jobs[job].data, packedData.data() + offsets[job] * elementSize,
+                            jobs[job].elementCount * elementSize);
+            }
+        }
+    }
+    statistics.scatterNs = getElapsedNs(scatterBegin);
+    statistics.writeNs = getEventDurationNs(writeDataEvent) + getEventDurationNs(writeOffsetsEvent);
+    statistics.kernelNs = getEventDurationNs(kernelEvent);
+    statistics.readNs = getEventDurationNs(readEvent);
+    statistics.wallNs = getElapsedNs(begin);
+    return true;
+}
+
+const bool BatchLauncher::runSingle(Kernel &singleKernel, const std::vector<BatchJob> &jobs,
+                                    const std::size_t &elementSize, BatchStatistics &statistics)
+{
+    statistics = BatchStatistics();
+    statistics.jobCount = jobs.size();
+    if (&singleKernel.getDeviceContext() != &deviceContext) {
+        reportError("BatchLauncher::runSingle: The kernel was created for another device");
+        return false;
+    }
+    const auto begin = std::chrono::steady_clock::now();
+
+    // Enqueue write -> kernel -> read of every job without waiting in between (the in order
+    // queue keeps them in sequence)
+    std::vector<PooledBuffer> buffers(jobs.size());
+    std::vector<cl::Event> writeEvents(jobs.size());
+    std::vector<cl::Event> kernelEvents(jobs.size());
+    std::vector<cl::Event> readEvents(jobs.size());
+    const cl::CommandQueue &queue = deviceContext.queue;
+    const auto fail = [&queue]() {
+        queue.finish();
+        return false;
+    };
+    for (std::size_t job = 0; job < jobs.size(); job++) {
+        const std::size_t size = jobs[job].elementCount * elementSize;
+        if (size == 0) {
+            continue;
+        }
+        if (!bufferPool.acquire(size, buffers[job])) {
+            return fail();
+        }
+        cl_int err = queue.enqueueWriteBuffer(buffers[job].get(), CL_FALSE, 0, size,
+                                              jobs[job].data, nullptr, &writeEvents[job]);
+        if (err != CL_SUCCESS) {
+            reportError("CommandQueue::enqueueWriteBuffer failed", err);
+            return fail();
+        }
+        traceCommand("write job", &writeEvents[job]);
+        if (!singleKernel.setArg(0, buffers[job].get())
+            || !singleKernel.enqueue(cl::NDRange(jobs[job].elementCount), cl::NullRange, nullptr,
+                                     &kernelEvents[job])) {
+            return fail();
+        }
+        err = queue.enqueueReadBuffer(buffers[job].get(), CL_FALSE, 0, size, jobs[job].data,
+                                      nullptr, &readEvents[job]);
+        if (err != CL_SUCCESS) {
+            reportError("CommandQueue::enqueueReadBuffer failed", err);
+            return fail();
+        }
+        traceCommand("read job", &readEvents[job]);
+        statistics.elementCount += jobs[job].elementCount;
+        statistics.launchCount++;
+    }
+    queue.finish();
+
+    for (std::size_t job = 0; job < jobs.size(); job++) {
+        if (jobs[job].elementCount > 0) {
+            statistics.writeNs += getEventDurationNs(writeEvents[job]);
+            statistics.kernelNs += getEventDurationNs(kernelEvents[job]);
+            statistics.readNs += getEventDurationNs(readEvents[job]);
+        }
+    }
+    statistics.wallNs = getElapsedNs(begin);
+    return true;
+}
+
+const bool BatchLauncher::findBreakEven(Kernel &singleKernel, Kernel &batchedKernel,
+                                        const std::vector<BatchJob> &jobs,
+                                        const std::size_t &elementSize,
+                                        const unsigned int &repetitionCount,
+                                        BatchBreakEven &breakEven)
+{
+    breakEven = BatchBreakEven();
+    for (std::size_t jobCount = 1; jobCount < jobs.size(); jobCount *= 2) {
+        breakEven.jobCounts.push_back(jobCount);
+    }
+    if (!jobs.empty()) {
+        breakEven.jobCounts.push_back(jobs.size());
+    }
+
+    for (auto const &jobCount : breakEven.jobCounts) {
+        const std::vector<BatchJob> subset(jobs.begin(), jobs.begin() + jobCount);
+        std::vector<uint64_t> singleSamplesNs;
+        std::vector<uint64_t> batchedSamplesNs;
+        // Alternate the modes so that both see the same device/driver state
+        for (unsigned int repetition = 0; repetition < std::max(1U, repetitionCount);
+             repetition++) {
+            BatchStatistics statistics;
+            if (!runSingle(singleKernel, subset, elementSize, statistics)) {
+                return false;
+            }
+            singleSamplesNs.push_back(statistics.wallNs);
+            if (!run(batchedKernel, subset, elementSize, statistics)) {
+                return false;
+            }
+            batchedSamplesNs.push_back(statistics.wallNs);
+        }
+        const uint64_t singleNs = calculateStatistics({ "single" }, singleSamplesNs).medianNs;
+        const uint64_t batchedNs = calculateStatistics({ "batched" }, batchedSamplesNs).medianNs;
+        breakEven.singleNs.push_back(singleNs);
+        breakEven.batchedNs.push_back(batchedNs);
+
+        // Batching has to stay faster for all bigger job counts
+        if (batchedNs >= singleNs) {
+            breakEven.breakEvenJobCount = 0;
+        } else if (breakEven.breakEvenJobCount == 0) {
+            breakEven.breakEvenJobCount = jobCount;
+        }
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+// Include project headers
+#include "runtime.hpp"
+
+// Include stl libraries
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace clrt {
+
+// Small independent problem: Its elements are the input of the kernel and are overwritten with
+// the results
+struct BatchJob {
+    void *data = nullptr;
+    std::size_t elementCount = 0;
+};
+
+// Times of a launch of many jobs (the wall time is measured on the host and includes packing,
+// all transfers, the kernel(s) and scattering the results back)
+struct BatchStatistics {
+    std::size_t jobCount = 0;
+    std::size_t elementCount = 0;
+    // Number of kernel launches (1 for a batched launch, the job count for single launches)
+    std::size_t launchCount = 0;
+    uint64_t packNs = 0;
+    uint64_t writeNs = 0;
+    uint64_t kernelNs = 0;
+    uint64_t readNs = 0;
+    uint64_t scatterNs = 0;
+    uint64_t wallNs = 0;
+};
+
+// Comparison of single and batched launches for growing numbers of jobs (1, 2, 4, ...)
+struct BatchBreakEven {
+    std::vector<std::size_t> jobCounts;
+    // Median wall times of all jobs of the job count
+    std::vector<uint64_t> singleNs;
+    std::vector<uint64_t> batchedNs;
+    // Smallest measured job count from which on one batched launch is faster than single
+    // launches (0 = batching was never faster)
+    std::size_t breakEvenJobCount = 0;
+};
+
+// Runs many small jobs (for which the launch overhead dominates) with one NDRange: The jobs are
+// packed into one contiguous buffer with an offsets table, processed by a single kernel launch
+// and the results are scattered back into the jobs
+//
+// The batched kernel gets the packed elements as argument 0, the offsets table (job count + 1
+// uints, the elements of job i are offsets[i] <= index < offsets[i + 1]) as argument 1 and the
+// job count as argument 2, it can find the job of its element with batch_find_job of
+// "batch.cl" (further arguments can be set by the caller)
+// The single kernel gets the buffer of one job as argument 0 and one work item per element
+class BatchLauncher
+{
+public:
+    BatchLauncher(Runtime &runtime, const cl::Device &device);
+
+    // Process all jobs with one launch of the batched kernel
+    const bool run(Kernel &batchedKernel, const std::vector<BatchJob> &jobs,
+                   const std::size_t &elementSize, BatchStatistics &statistics);
+    // Process every job with its own launch of the single kernel (the reference of batching)
+    const bool runSingle(Kernel &singleKernel, const std::vector<BatchJob> &jobs,
+                         const std::size_t &elementSize, BatchStatistics &statistics);
+    // Measure both launch modes for the first 1, 2, 4, ... jobs (and all jobs) to find the
+    // job count from which on batching pays off on this device
+    const bool findBreakEven(Kernel &singleKernel, Kernel &batchedKernel,
+                             const std::vector<BatchJob> &jobs, const std::size_t &elementSize,
+                             const unsigned int &repetitionCount, BatchBreakEven &breakEven);
+
+private:
+    DeviceContext &deviceContext;
+    BufferPool &bufferPool;
+    // Host staging memory of the packed jobs (kept to avoid allocations in every launch)
+    std::vector<unsigned char> packedData;
+    std::vector<cl_uint> offsets;
+};
+
+}
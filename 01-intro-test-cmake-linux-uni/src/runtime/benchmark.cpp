@@ -0,0 +1,211 @@
+#include "benchmark.hpp"
+
+// Include stl libraries
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+
+// Nearest rank percentile of sorted samples
+const uint64_t getPercentile(const std::vector<uint64_t> &sortedSamples, const double &percentile)
+{
+    const auto rank = static_cast<std::size_t>(std::ceil(percentile / 100.0
+                                                         * sortedSamples.size()));
+    return sortedSamples[std::min(sortedSamples.size(), std::max<std::size_t>(1, rank)) - 1];
+}
+
+const std::string escapeCsv(const std::string &text)
+{
+    if (text.find_first_of(",\"\n") == std::string::npos) {
+        return text;
+    }
+    std::string escaped = "\"";
+    for (const char character : text) {
+        escaped += character == '"' ? "\"\"" : std::string(1, character);
+    }
+    return escaped + "\"";
+}
+
+}
+
+namespace clrt {
+
+Benchmark::Benchmark(const unsigned int &warmUpCount, const unsigned int &repetitionCount)
+    : warmUpCount(warmUpCount), repetitionCount(std::max(1U, repetitionCount))
+{
+}
+
+void Benchmark::setDevice(const cl::Device &device)
+{
+    deviceName = trimInfoString(device.getInfo<CL_DEVICE_NAME>());
+    driverVersion = trimInfoString(device.getInfo<CL_DRIVER_VERSION>());
+}
+
+void Benchmark::setHost()
+{
+    deviceName.clear();
+    driverVersion.clear();
+}
+
+const bool Benchmark::run(const std::vector<BenchmarkPhase> &phases,
+                          const BenchmarkIteration &iteration,
+                          std::vector<BenchmarkStatistics> &statistics)
+{
+    std::vector<std::vector<uint64_t>> samplesNs(phases.size());
+    for (unsigned int i = 0; i < warmUpCount + repetitionCount; i++) {
+        std::vector<uint64_t> phaseNs(phases.size(), 0);
+        if (!iteration(phaseNs)) {
+            return false;
+        }
+        if (i < warmUpCount) {
+            continue;
+        }
+        for (std::size_t phase = 0; phase < phases.size(); phase++) {
+            samplesNs[phase].push_back(phaseNs[phase]);
+        }
+    }
+
+    statistics.clear();
+    for (std::size_t phase = 0; phase < phases.size(); phase++) {
+        BenchmarkStatistics phaseStatistics = calculateStatistics(phases[phase], samplesNs[phase]);
+        phaseStatistics.deviceName = deviceName;
+        phaseStatistics.driverVersion = driverVersion;
+        statistics.push_back(phaseStatistics);
+        results.push_back(phaseStatistics);
+    }
+    return true;
+}
+
+const bool Benchmark::run(const BenchmarkPhase &phase,
+                          const std::function<bool(uint64_t &timeNs)> &iteration,
+                          BenchmarkStatistics &statistics)
+{
+    const BenchmarkIteration phaseIteration = [&iteration](std::vector<uint64_t> &phaseNs) {
+        return iteration(phaseNs[0]);
+    };
+    std::vector<BenchmarkStatistics> phaseStatistics;
+    if (!run({ phase }, phaseIteration, phaseStatistics)) {
+        return false;
+    }
+    statistics = phaseStatistics[0];
+    return true;
+}
+
+const std::vector<BenchmarkStatistics> &Benchmark::getResults() const
+{
+    return results;
+}
+
+const bool Benchmark::writeJson(const std::string &filePath) const
+{
+    std::ofstream file(filePath, std::ios::trunc);
+    file << "{\n  \"warmUpCount\": " << warmUpCount << ",\n  \"repetitionCount\": "
+         << repetitionCount << ",\n  \"results\": [";
+    for (std::size_t i = 0; i < results.size(); i++) {
+        const BenchmarkStatistics &result = results[i];
+        file << (i > 0 ? "," : "") << "\n    {"
+             << "\"name\": \"" << escapeJson(result.name) << "\", "
+             << "\"device\": \"" << escapeJson(result.deviceName) << "\", "
+             << "\"driverVersion\": \"" << escapeJson(result.driverVersion) << "\", "
+             << "\"repetitions\": " << result.repetitionCount << ", "
+             << "\"minNs\": " << result.minNs << ", "
+             << "\"medianNs\": " << result.medianNs << ", "
+             << "\"p95Ns\": " << result.p95Ns << ", "
+             << "\"p99Ns\": " << result.p99Ns << ", "
+             << "\"meanNs\": " << result.meanNs << ", "
+             << "\"stddevNs\": " << result.stddevNs << ", "
+             << "\"bytes\": " << result.bytes << ", "
+             << "\"elements\": " << result.elements << ", "
+             << "\"gigabytesPerSecond\": " << result.gigabytesPerSecond << ", "
+             << "\"elementsPerSecond\": " << result.elementsPerSecond << "}";
+    }
+    file << "\n  ]\n}\n";
+    if (!file) {
+        reportError("Benchmark results could not be written: " + filePath);
+        return false;
+    }
+    return true;
+}
+
+const bool Benchmark::writeCsv(const std::string &filePath) const
+{
+    std::ofstream file(filePath, std::ios::trunc);
+    file << "name,device,driverVersion,repetitions,minNs,medianNs,p95Ns,p99Ns,meanNs,stddevNs,"
+         << "bytes,elements,gigabytesPerSecond,elementsPerSecond\n";
+    for (const auto &result : results) {
+        file << escapeCsv(result.name) << ',' << escapeCsv(result.deviceName) << ','
+             << escapeCsv(result.driverVersion) << ',' << result.repetitionCount << ','
+             << result.minNs << ',' << result.medianNs << ',' << result.p95Ns << ','
+             << result.p99Ns << ',' << result.meanNs << ',' << result.stddevNs << ','
+             << result.bytes << ',' << result.elements << ',' << result.gigabytesPerSecond << ','
+             << result.elementsPerSecond << '\n';
+    }
+    if (!file) {
+        reportError("Benchmark results could not be written: " + filePath);
+        return false;
+    }
+    return true;
+}
+
+const BenchmarkStatistics calculateStatistics(const BenchmarkPhase &phase,
+                                              std::vector<uint64_t> samplesNs)
+{
+    BenchmarkStatistics statistics;
+    statistics.name = phase.name;
+    statistics.bytes = phase.bytes;
+    statistics.elements = phase.elements;
+    statistics.repetitionCount = static_cast<unsigned int>(samplesNs.size());
+    if (samplesNs.empty()) {
+        return statistics;
+    }
+
+    std::sort(samplesNs.begin(), samplesNs.end());
+    statistics.minNs = samplesNs.front();
+    const std::size_t middle = samplesNs.size() / 2;
+    statistics.medianNs = samplesNs.size() % 2 == 1 ? samplesNs[middle]
+                          : (samplesNs[middle - 1] + samplesNs[middle]) / 2;
+    statistics.p95Ns = getPercentile(samplesNs, 95);
+    statistics.p99Ns = getPercentile(samplesNs, 99);
+
+    double sum = 0;
+    for (const auto sample : samplesNs) {
+        sum += static_cast<double>(sample);
+    }
+    statistics.meanNs = sum / samplesNs.size();
+    double squaredDeviationSum = 0;
+    for (const auto sample : samplesNs) {
+        squaredDeviationSum += std::pow(static_cast<double>(sample) - statistics.meanNs, 2);
+    }
+    // Sample standard deviation (the repetitions are a sample of all possible runs)
+    statistics.stddevNs = samplesNs.size() > 1
+                          ? std::sqrt(squaredDeviationSum / (samplesNs.size() - 1)) : 0;
+
+    if (statistics.medianNs > 0) {
+        statistics.gigabytesPerSecond = static_cast<double>(statistics.bytes) / statistics.medianNs;
+        statistics.elementsPerSecond = statistics.elements * 1e9 / statistics.medianNs;
+    }
+    return statistics;
+}
+
+const std::string displayStatistics(const BenchmarkStatistics &statistics)
+{
+    std::ostringstream text;
+    text << statistics.medianNs << "ns (min: " << statistics.minNs << "ns, p95: "
+         << statistics.p95Ns << "ns, p99: " << statistics.p99Ns << "ns, stddev: "
+         << std::fixed << std::setprecision(0) << statistics.stddevNs << "ns";
+    if (statistics.bytes > 0) {
+        text << ", " << std::setprecision(2) << statistics.gigabytesPerSecond << "GB/s";
+    }
+    if (statistics.elements > 0) {
+        text << ", " << std::scientific << std::setprecision(3) << statistics.elementsPerSecond
+             << " elements/s";
+    }
+    text << ")";
+    return text.str();
+}
+
+}
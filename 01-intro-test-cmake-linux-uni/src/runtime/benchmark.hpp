@@ -0,0 +1,84 @@
+#pragma once
+
+// Include project headers
+#include "runtime.hpp"
+
+// Include stl libraries
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace clrt {
+
+// Something that is timed in every iteration of a benchmark (e.g. write, kernel or read)
+struct BenchmarkPhase {
+    std::string name;
+    // Bytes and elements that the phase processes (0 = no bandwidth/throughput is calculated)
+    uint64_t bytes = 0;
+    uint64_t elements = 0;
+};
+
+// Statistics of the timed repetitions of a phase
+struct BenchmarkStatistics {
+    std::string name;
+    std::string deviceName;
+    std::string driverVersion;
+    unsigned int repetitionCount = 0;
+    uint64_t minNs = 0;
+    uint64_t medianNs = 0;
+    uint64_t p95Ns = 0;
+    uint64_t p99Ns = 0;
+    double meanNs = 0;
+    double stddevNs = 0;
+    uint64_t bytes = 0;
+    uint64_t elements = 0;
+    // Throughput of the median time
+    double gigabytesPerSecond = 0;
+    double elementsPerSecond = 0;
+};
+
+// One iteration of a benchmark: Run all phases and write the time of every phase into phaseNs
+typedef std::function<bool(std::vector<uint64_t> &phaseNs)> BenchmarkIteration;
+
+// Runs warm up iterations (first use of the driver/JIT, page faults, cold caches) that are not
+// counted followed by the timed repetitions and collects the statistics of all runs so that they
+// can be exported as JSON/CSV
+class Benchmark
+{
+public:
+    explicit Benchmark(const unsigned int &warmUpCount = 2,
+                       const unsigned int &repetitionCount = 10);
+
+    // The device name and driver version are added to all following results (empty = host)
+    void setDevice(const cl::Device &device);
+    void setHost();
+
+    // Run the iterations and calculate the statistics of every phase
+    const bool run(const std::vector<BenchmarkPhase> &phases, const BenchmarkIteration &iteration,
+                   std::vector<BenchmarkStatistics> &statistics);
+    // Run the iterations of a single phase
+    const bool run(const BenchmarkPhase &phase,
+                   const std::function<bool(uint64_t &timeNs)> &iteration,
+                   BenchmarkStatistics &statistics);
+
+    const std::vector<BenchmarkStatistics> &getResults() const;
+    const bool writeJson(const std::string &filePath) const;
+    const bool writeCsv(const std::string &filePath) const;
+
+private:
+    unsigned int warmUpCount;
+    unsigned int repetitionCount;
+    std::string deviceName;
+    std::string driverVersion;
+    std::vector<BenchmarkStatistics> results;
+};
+
+// Calculate the statistics of the measured times of a phase
+const BenchmarkStatistics calculateStatistics(const BenchmarkPhase &phase,
+                                              std::vector<uint64_t> samplesNs);
+
+// Display statistics as "median (min, p95, p99, stddev, throughput)"
+const std::string displayStatistics(const BenchmarkStatistics &statistics);
+
+}
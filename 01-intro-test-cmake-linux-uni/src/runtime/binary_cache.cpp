@@ -0,0 +1,284 @@
+#include "binary_cache.hpp"
+
+// Include project headers
+#include "trace.hpp"
+
+// Include stl libraries
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+// Include the method to create directories
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+namespace {
+
+// Header that is written in front of every cached program binary
+constexpr char entryMagic[4] = { 'C', 'L', 'P', 'B' };
+constexpr uint32_t entryFormatVersion = 1;
+struct EntryHeader {
+    char magic[4];
+    uint32_t formatVersion;
+    uint64_t key;
+    uint64_t sourceBuildTimeNs;
+    uint64_t binarySize;
+    uint64_t binaryChecksum;
+};
+
+// 64 bit FNV-1a hash (fast and good enough to detect changed inputs and corrupt files)
+constexpr uint64_t fnvOffsetBasis = 14695981039346656037ULL;
+constexpr uint64_t fnvPrime = 1099511628211ULL;
+
+const uint64_t hashBytes(const void *data, const std::size_t &size,
+                         uint64_t hash = fnvOffsetBasis)
+{
+    const auto bytes = static_cast<const unsigned char *>(data);
+    for (std::size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= fnvPrime;
+    }
+    return hash;
+}
+
+const uint64_t hashString(const std::string &text, const uint64_t &hash)
+{
+    // Hash the length too so that {"ab", "c"} and {"a", "bc"} result in different keys
+    const uint64_t length = text.size();
+    return hashBytes(text.data(), text.size(), hashBytes(&length, sizeof(length), hash));
+}
+
+const uint64_t getElapsedNs(const std::chrono::steady_clock::time_point &begin)
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>
+                                 (std::chrono::steady_clock::now() - begin).count());
+}
+
+// Create a program from SPIR-V if the device accepts it (OpenCL 2.1 or cl_khr_il_program), the
+// function is queried at runtime because the headers/ICD loader may only know OpenCL 2.0
+const bool createProgramWithIL(const cl::Context &context, const cl::Device &device,
+                               const std::string &il, cl::Program &program)
+{
+    // CL_DEVICE_IL_VERSION (CL_DEVICE_IL_VERSION_KHR of the extension)
+    constexpr cl_device_info deviceIlVersion = 0x105B;
+    std::size_t size = 0;
+    if (clGetDeviceInfo(device(), deviceIlVersion, 0, nullptr, &size) != CL_SUCCESS || size == 0) {
+        return false;
+    }
+    std::string ilVersions(size, '\0');
+    if (clGetDeviceInfo(device(), deviceIlVersion, size, &ilVersions[0], nullptr) != CL_SUCCESS
+        || ilVersions.find("SPIR-V") == std::string::npos) {
+        return false;
+    }
+
+    typedef cl_program(CL_API_CALL * CreateProgramWithIL)(cl_context, const void *, size_t,
+                                                          cl_int *);
+    const cl_platform_id platform = device.getInfo<CL_DEVICE_PLATFORM>();
+    CreateProgramWithIL create = nullptr;
+    for (auto const &name : { "clCreateProgramWithIL", "clCreateProgramWithILKHR" }) {
+        if (create == nullptr) {
+            create = reinterpret_cast<CreateProgramWithIL>(
+                         clGetExtensionFunctionAddressForPlatform(platform, name));
+        }
+    }
+    if (create == nullptr) {
+        return false;
+    }
+    cl_int err = CL_SUCCESS;
+    const cl_program ilProgram = create(context(), il.data(), il.size(), &err);
+    if (err != CL_SUCCESS) {
+        return false;
+    }
+    // The wrapper takes over the reference of the created program
+    program = cl::Program(ilProgram);
+    return true;
+}
+
+}
+
+namespace clrt {
+
+void createDirectory(const std::string &path)
+{
+#ifdef _WIN32
+    _mkdir(path.c_str());
+#else
+    mkdir(path.c_str(), 0755);
+#endif
+}
+
+ProgramBinaryCache::ProgramBinaryCache(const std::string &cacheDirectory)
+    : cacheDirectory(cacheDirectory)
+{
+    createDirectory(cacheDirectory);
+}
+
+const bool ProgramBinaryCache::buildProgram(const cl::Context &context, const cl::Device &device,
+                                            const std::vector<std::string> &sources,
+                                            const std::string &buildOptions, cl::Program &program,
+                                            const std::string &il)
+{
+    // Create the cache key from everything that influences the resulting binary
+    uint64_t key = fnvOffsetBasis;
+    for (auto const &source : sources) {
+        key = hashString(source, key);
+    }
+    key = hashString(il, key);
+    key = hashString(buildOptions, key);
+    key = hashString(device.getInfo<CL_DEVICE_NAME>(), key);
+    key = hashString(device.getInfo<CL_DEVICE_VERSION>(), key);
+    key = hashString(device.getInfo<CL_DRIVER_VERSION>(), key);
+    const std::string entryPath = getEntryPath(key);
+
+    // Try to create the program from the cached binary
+    std::vector<unsigned char> binary;
+    uint64_t sourceBuildTimeNs = 0;
+    const EntryStatus entryStatus = loadEntry(entryPath, key, binary, sourceBuildTimeNs);
+    if (entryStatus == EntryStatus::Loaded) {
+        TraceSpan span("build program from binary", "build");
+        const auto binaryBuildBegin = std::chrono::steady_clock::now();
+        cl_int err = CL_SUCCESS;
+        std::vector<cl_int> binaryStatus;
+        cl::Program binaryProgram(context, {device}, cl::Program::Binaries{binary}, &binaryStatus,
+                                  &err);
+        if (err == CL_SUCCESS && binaryStatus.size() == 1 && binaryStatus[0] == CL_SUCCESS
+            && binaryProgram.build({device}, buildOptions.c_str()) == CL_SUCCESS) {
+            const auto binaryBuildNs = getElapsedNs(binaryBuildBegin);
+            hitCount++;
+            if (sourceBuildTimeNs > binaryBuildNs) {
+                savedBuildTimeNs += sourceBuildTimeNs - binaryBuildNs;
+            }
+            program = binaryProgram;
+            return true;
+        }
+    }
+    // The entry is stale, corrupt or was rejected by the driver, remove it and fall back to a
+    // source build (that stores a new entry)
+    if (entryStatus != EntryStatus::Missing) {
+        invalidCount++;
+        std::remove(entryPath.c_str());
+    }
+    missCount++;
+
+    // Build the program from SPIR-V (without parsing the sources) if the device supports it
+    const auto sourceBuildBegin = std::chrono::steady_clock::now();
+    bool builtFromIl = false;
+    cl::Program ilProgram;
+    if (!il.empty() && createProgramWithIL(context, device, il, ilProgram)) {
+        TraceSpan span("build program from IL", "build");
+        builtFromIl = ilProgram.build({device}, buildOptions.c_str()) == CL_SUCCESS;
+        if (builtFromIl) {
+            program = ilProgram;
+        }
+    }
+
+    // Build the program from source and check if compilation was successful
+    if (!builtFromIl) {
+        TraceSpan span("build program from source", "build");
+        cl::Program sourceProgram(context, sources);
+        if (sourceProgram.build({device}, buildOptions.c_str()) != CL_SUCCESS) {
+            std::cout << "\t\t\033[1;31mError building:\033[0m "
+                      << sourceProgram.getBuildInfo<CL_PROGRAM_BUILD_LOG>(device) << std::endl;
+            return false;
+        }
+        program = sourceProgram;
+    }
+    sourceBuildTimeNs = getElapsedNs(sourceBuildBegin);
+
+    // Store the binary of the only device of the program in the cache
+    const auto binaries = program.getInfo<CL_PROGRAM_BINARIES>();
+    if (binaries.size() == 1 && !binaries[0].empty()
+        && !storeEntry(entryPath, key, binaries[0], sourceBuildTimeNs)) {
+        std::cout << "\t\t\033[1;33mWarning: Could not write program binary cache entry \""
+                  << entryPath << "\"\033[0m" << std::endl;
+    }
+    return true;
+}
+
+const unsigned int ProgramBinaryCache::getHitCount() const
+{
+    return hitCount;
+}
+
+const unsigned int ProgramBinaryCache::getMissCount() const
+{
+    return missCount;
+}
+
+const unsigned int ProgramBinaryCache::getInvalidCount() const
+{
+    return invalidCount;
+}
+
+const uint64_t ProgramBinaryCache::getSavedBuildTimeNs() const
+{
+    return savedBuildTimeNs;
+}
+
+const std::string ProgramBinaryCache::getEntryPath(const uint64_t &key) const
+{
+    std::stringstream ss;
+    ss << cacheDirectory << "/" << std::hex << std::setw(16) << std::setfill('0') << key << ".bin";
+    return ss.str();
+}
+
+const ProgramBinaryCache::EntryStatus ProgramBinaryCache::loadEntry(
+    const std::string &path, const uint64_t &key, std::vector<unsigned char> &binary,
+    uint64_t &sourceBuildTimeNs) const
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        return EntryStatus::Missing;
+    }
+    const uint64_t fileSize = static_cast<uint64_t>(file.tellg());
+    file.seekg(0);
+    EntryHeader header;
+    if (!file.read(reinterpret_cast<char *>(&header), sizeof(header))
+        || std::memcmp(header.magic, entryMagic, sizeof(entryMagic)) != 0
+        || header.formatVersion != entryFormatVersion || header.key != key
+        || header.binarySize != fileSize - sizeof(header)) {
+        return EntryStatus::Invalid;
+    }
+    binary.resize(header.binarySize);
+    if (!file.read(reinterpret_cast<char *>(binary.data()), binary.size())
+        || hashBytes(binary.data(), binary.size()) != header.binaryChecksum) {
+        return EntryStatus::Invalid;
+    }
+    sourceBuildTimeNs = header.sourceBuildTimeNs;
+    return EntryStatus::Loaded;
+}
+
+const bool ProgramBinaryCache::storeEntry(const std::string &path, const uint64_t &key,
+                                          const std::vector<unsigned char> &binary,
+                                          const uint64_t &sourceBuildTimeNs) const
+{
+    EntryHeader header;
+    std::memcpy(header.magic, entryMagic, sizeof(entryMagic));
+    header.formatVersion = entryFormatVersion;
+    header.key = key;
+    header.sourceBuildTimeNs = sourceBuildTimeNs;
+    header.binarySize = binary.size();
+    header.binaryChecksum = hashBytes(binary.data(), binary.size());
+
+    // Write to a temporary file first so that a crash never leaves a half written entry behind
+    const std::string temporaryPath = path + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!file.write(reinterpret_cast<const char *>(&header), sizeof(header))
+            || !file.write(reinterpret_cast<const char *>(binary.data()), binary.size())) {
+            std::remove(temporaryPath.c_str());
+            return false;
+        }
+    }
+    std::remove(path.c_str());
+    return std::rename(temporaryPath.c_str(), path.c_str()) == 0;
+}
+
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+// TARGET OPENCL 2.0
+#ifndef CL_HPP_TARGET_OPENCL_VERSION
+#define CL_HPP_TARGET_OPENCL_VERSION 200
+#endif
+#include <CL/cl2.hpp>
+
+// Include stl libraries
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace clrt {
+
+// Persistent on-disk cache of built OpenCL programs (CL_PROGRAM_BINARIES)
+// Every entry is keyed by a hash of the kernel sources, the build options (-D...) and the
+// device name/version/driver version so that a change of any of them results in a rebuild
+class ProgramBinaryCache
+{
+public:
+    explicit ProgramBinaryCache(const std::string &cacheDirectory = "cache");
+
+    // Build the program for the device: Load it from the cache if a valid entry exists and
+    // otherwise (cache miss, stale or corrupt entry) build it from SPIR-V (if there is one and the
+    // device supports it) or from source and store the binary
+    const bool buildProgram(const cl::Context &context, const cl::Device &device,
+                            const std::vector<std::string> &sources,
+                            const std::string &buildOptions, cl::Program &program,
+                            const std::string &il = "");
+
+    const unsigned int getHitCount() const;
+    const unsigned int getMissCount() const;
+    // Entries that existed but could not be used (wrong key, checksum or rejected by the driver)
+    const unsigned int getInvalidCount() const;
+    // Sum of (source build time - binary load time) over all cache hits
+    const uint64_t getSavedBuildTimeNs() const;
+
+private:
+    // Result of reading an entry (an invalid file has a wrong header, key, size or checksum)
+    enum class EntryStatus {
+        Missing,
+        Invalid,
+        Loaded
+    };
+
+    const std::string getEntryPath(const uint64_t &key) const;
+    const EntryStatus loadEntry(const std::string &path, const uint64_t &key,
+                         std::vector<unsigned char> &binary, uint64_t &sourceBuildTimeNs) const;
+    const bool storeEntry(const std::string &path, const uint64_t &key,
+                          const std::vector<unsigned char> &binary,
+                          const uint64_t &sourceBuildTimeNs) const;
+
+    std::string cacheDirectory;
+    unsigned int hitCount = 0;
+    unsigned int missCount = 0;
+    unsigned int invalidCount = 0;
+    uint64_t savedBuildTimeNs = 0;
+};
+
+// Create a directory (nothing happens if it already exists)
+void createDirectory(const std::string &path);
+
+}
@@ -0,0 +1,255 @@
+#include "buffer_pool.hpp"
+
+// Include project headers
+#include "runtime.hpp"
+
+// Include stl libraries
+#include <algorithm>
+#include <limits>
+#include <string>
+
+namespace {
+
+// Slab of dedicated buffers
+constexpr std::size_t noSlab = 0;
+// Smallest size class (a multiple of every base address alignment of sub-buffers in practice)
+constexpr std::size_t minBlockSize = 4096;
+// Every slab holds at least this many blocks
+constexpr std::size_t minBlocksPerSlab = 8;
+// Big size classes are multiples of an eighth of the next power of two
+constexpr std::size_t bigSizeClassSteps = 8;
+
+}
+
+namespace clrt {
+
+PooledBuffer::~PooledBuffer()
+{
+    release();
+}
+
+PooledBuffer::PooledBuffer(PooledBuffer &&other)
+{
+    *this = std::move(other);
+}
+
+PooledBuffer &PooledBuffer::operator=(PooledBuffer &&other)
+{
+    if (this != &other) {
+        release();
+        pool = other.pool;
+        buffer = other.buffer;
+        size = other.size;
+        sizeClass = other.sizeClass;
+        slab = other.slab;
+        other.pool = nullptr;
+        other.buffer = cl::Buffer();
+    }
+    return *this;
+}
+
+const bool PooledBuffer::isValid() const
+{
+    return pool != nullptr;
+}
+
+cl::Buffer &PooledBuffer::get()
+{
+    return buffer;
+}
+
+const std::size_t PooledBuffer::getSize() const
+{
+    return size;
+}
+
+void PooledBuffer::release()
+{
+    if (pool != nullptr) {
+        pool->release(*this);
+        pool = nullptr;
+        buffer = cl::Buffer();
+    }
+}
+
+BufferPool::BufferPool(DeviceContext &deviceContext, const uint64_t &limitBytes,
+                       const std::size_t &slabSize)
+    : deviceContext(deviceContext), limitBytes(limitBytes)
+{
+    const cl::Device &device = deviceContext.device;
+    if (this->limitBytes == 0) {
+        this->limitBytes = device.getInfo<CL_DEVICE_GLOBAL_MEM_SIZE>();
+    }
+    // Sub-buffers have to start at a multiple of the base address alignment (in bits)
+    minSizeClass = std::max<std::size_t>(minBlockSize,
+                                         device.getInfo<CL_DEVICE_MEM_BASE_ADDR_ALIGN>() / 8);
+    const uint64_t maxAllocationBytes = device.getInfo<CL_DEVICE_MAX_MEM_ALLOC_SIZE>();
+    maxAllocationSize = static_cast<std::size_t>(
+                            std::min<uint64_t>(maxAllocationBytes,
+                                               std::numeric_limits<std::size_t>::max()));
+    this->slabSize = std::min(slabSize, maxAllocationSize);
+    maxSlabSizeClass = this->slabSize / minBlocksPerSlab;
+    statistics.limitBytes = this->limitBytes;
+}
+
+const bool BufferPool::acquire(const std::size_t &size, PooledBuffer &buffer)
+{
+    // Give the old buffer back first (it may be reused for this request)
+    buffer.release();
+    if (!deviceContext.valid) {
+        reportError("BufferPool::acquire: The device context is not valid");
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    const std::size_t sizeClass = getSizeClass(size);
+    statistics.requestCount++;
+    std::vector<Block> &blocks = freeBlocks[sizeClass];
+    if (!blocks.empty()) {
+        statistics.hitCount++;
+    } else if (!addBlocks(sizeClass)) {
+        return false;
+    }
+
+    const Block block = blocks.back();
+    blocks.pop_back();
+    if (block.slab != noSlab) {
+        slabs.at(block.slab).usedCount++;
+    }
+    buffer.pool = this;
+    buffer.buffer = block.buffer;
+    buffer.size = size;
+    buffer.sizeClass = sizeClass;
+    buffer.slab = block.slab;
+    statistics.usedBytes += sizeClass;
+    statistics.requestedBytes += size;
+    return true;
+}
+
+void BufferPool::trim()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    trimFreeMemory();
+}
+
+const std::size_t BufferPool::getSizeClass(const std::size_t &size) const
+{
+    std::size_t sizeClass = minSizeClass;
+    while (sizeClass < size) {
+        sizeClass *= 2;
+    }
+    if (sizeClass > maxSlabSizeClass) {
+        // Powers of two would waste up to half of big buffers
+        const std::size_t step = sizeClass / bigSizeClassSteps;
+        sizeClass = (size + step - 1) / step * step;
+        // A request that fits into one allocation must not be rounded up beyond it (bigger
+        // requests fail in the driver like a direct cl::Buffer)
+        sizeClass = std::min(sizeClass, std::max(size, maxAllocationSize));
+    }
+    return sizeClass;
+}
+
+const BufferPoolStatistics BufferPool::getStatistics() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    BufferPoolStatistics result = statistics;
+    result.slabCount = slabs.size();
+    if (result.requestCount > 0) {
+        result.hitRate = static_cast<double>(result.hitCount) / result.requestCount;
+    }
+    if (result.reservedBytes > 0) {
+        result.fragmentation = 1.0 - static_cast<double>(result.requestedBytes)
+                               / result.reservedBytes;
+    }
+    return result;
+}
+
+void BufferPool::release(PooledBuffer &buffer)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (buffer.slab != noSlab) {
+        slabs.at(buffer.slab).usedCount--;
+    }
+    freeBlocks[buffer.sizeClass].push_back({ buffer.buffer, buffer.slab });
+    statistics.usedBytes -= buffer.sizeClass;
+    statistics.requestedBytes -= buffer.size;
+}
+
+const bool BufferPool::addBlocks(const std::size_t &sizeClass)
+{
+    const bool useSlab = sizeClass <= maxSlabSizeClass;
+    const std::size_t bytes = useSlab ? slabSize : sizeClass;
+    if (!reserve(bytes)) {
+        return false;
+    }
+    cl_int err = CL_SUCCESS;
+    cl::Buffer buffer(deviceContext.context, CL_MEM_READ_WRITE, bytes, nullptr, &err);
+    if (err != CL_SUCCESS) {
+        reportError("BufferPool could not create a buffer of " + std::to_string(bytes)
+                    + " bytes", err);
+        return false;
+    }
+    std::vector<Block> &blocks = freeBlocks[sizeClass];
+    if (!useSlab) {
+        blocks.push_back({ buffer, noSlab });
+    } else {
+        // Carve the slab into blocks of the size class
+        const std::size_t slab = nextSlab++;
+        std::vector<Block> slabBlocks;
+        for (std::size_t origin = 0; origin + sizeClass <= slabSize; origin += sizeClass) {
+            cl_buffer_region region = { origin, sizeClass };
+            const cl::Buffer block = buffer.createSubBuffer(CL_MEM_READ_WRITE,
+                                                            CL_BUFFER_CREATE_TYPE_REGION,
+                                                            &region, &err);
+            if (err != CL_SUCCESS) {
+                reportError("Buffer::createSubBuffer failed", err);
+                return false;
+            }
+            slabBlocks.push_back({ block, slab });
+        }
+        blocks.insert(blocks.end(), slabBlocks.begin(), slabBlocks.end());
+        slabs[slab] = { buffer, sizeClass, 0 };
+    }
+    statistics.reservedBytes += bytes;
+    statistics.highWaterBytes = std::max(statistics.highWaterBytes, statistics.reservedBytes);
+    return true;
+}
+
+const bool BufferPool::reserve(const std::size_t &bytes)
+{
+    if (statistics.reservedBytes + bytes > limitBytes) {
+        trimFreeMemory();
+    }
+    if (statistics.reservedBytes + bytes > limitBytes) {
+        reportError("BufferPool limit of " + std::to_string(limitBytes) + " bytes reached ("
+                    + std::to_string(statistics.reservedBytes) + " bytes reserved, "
+                    + std::to_string(bytes) + " bytes requested)");
+        return false;
+    }
+    return true;
+}
+
+void BufferPool::trimFreeMemory()
+{
+    for (auto &sizeClassBlocks : freeBlocks) {
+        std::vector<Block> &blocks = sizeClassBlocks.second;
+        blocks.erase(std::remove_if(blocks.begin(), blocks.end(), [&](const Block & block) {
+            // Dedicated buffers and blocks of unused slabs
+            if (block.slab == noSlab) {
+                statistics.reservedBytes -= sizeClassBlocks.first;
+                return true;
+            }
+            return slabs.at(block.slab).usedCount == 0;
+        }), blocks.end());
+    }
+    for (auto slab = slabs.begin(); slab != slabs.end();) {
+        if (slab->second.usedCount == 0) {
+            statistics.reservedBytes -= slabSize;
+            slab = slabs.erase(slab);
+        } else {
+            ++slab;
+        }
+    }
+}
+
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+// TARGET OPENCL 2.0
+#ifndef CL_HPP_TARGET_OPENCL_VERSION
+#define CL_HPP_TARGET_OPENCL_VERSION 200
+#endif
+#include <CL/cl2.hpp>
+
+// Include stl libraries
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace clrt {
+
+struct DeviceContext;
+class BufferPool;
+
+// Counters of a buffer pool (bytes of the buffers that are in use at the moment)
+struct BufferPoolStatistics {
+    uint64_t requestCount = 0;
+    // Requests that got recycled memory instead of a new buffer/slab
+    uint64_t hitCount = 0;
+    double hitRate = 0.0;
+    std::size_t slabCount = 0;
+    // Memory of all slabs and dedicated buffers (in use or free)
+    uint64_t reservedBytes = 0;
+    uint64_t highWaterBytes = 0;
+    uint64_t limitBytes = 0;
+    // Size classes and requested sizes of the buffers in use
+    uint64_t usedBytes = 0;
+    uint64_t requestedBytes = 0;
+    // Share of the reserved memory that is not requested (size class rounding and free blocks)
+    double fragmentation = 0.0;
+};
+
+// Buffer of a pool that is given back to the pool when the handle is destroyed or released
+// (the commands that use it have to be finished by then)
+class PooledBuffer
+{
+public:
+    PooledBuffer() = default;
+    ~PooledBuffer();
+    PooledBuffer(PooledBuffer &&other);
+    PooledBuffer &operator=(PooledBuffer &&other);
+    PooledBuffer(const PooledBuffer &) = delete;
+    PooledBuffer &operator=(const PooledBuffer &) = delete;
+
+    const bool isValid() const;
+    cl::Buffer &get();
+    // Requested size (the buffer may be bigger)
+    const std::size_t getSize() const;
+    void release();
+
+private:
+    friend class BufferPool;
+
+    BufferPool *pool = nullptr;
+    cl::Buffer buffer;
+    std::size_t size = 0;
+    std::size_t sizeClass = 0;
+    std::size_t slab = 0;
+};
+
+// Recycles the device buffers (CL_MEM_READ_WRITE) of a context instead of creating and freeing
+// them for every call: Requests are rounded up to size classes, small classes are sub-buffers
+// (createSubBuffer) of big slabs and bigger ones are dedicated buffers
+//
+// The reserved memory never exceeds the limit: Free buffers and unused slabs are released when
+// a request would exceed it, requests fail if that is not enough
+// The pool has to outlive all of its buffers
+class BufferPool
+{
+public:
+    // A limit of 0 is the global memory size of the device
+    explicit BufferPool(DeviceContext &deviceContext, const uint64_t &limitBytes = 0,
+                        const std::size_t &slabSize = 64 * 1024 * 1024);
+    BufferPool(const BufferPool &) = delete;
+    BufferPool &operator=(const BufferPool &) = delete;
+
+    // Replaces (releases) the buffer that the handle had before
+    const bool acquire(const std::size_t &size, PooledBuffer &buffer);
+    // Release all free buffers and all slabs without used sub-buffers
+    void trim();
+
+    const std::size_t getSizeClass(const std::size_t &size) const;
+    const BufferPoolStatistics getStatistics() const;
+
+private:
+    friend class PooledBuffer;
+
+    struct Block {
+        cl::Buffer buffer;
+        std::size_t slab;
+    };
+    struct Slab {
+        cl::Buffer buffer;
+        std::size_t sizeClass;
+        std::size_t usedCount;
+    };
+
+    void release(PooledBuffer &buffer);
+    // Create the free blocks of a size class (a slab or a dedicated buffer)
+    const bool addBlocks(const std::size_t &sizeClass);
+    // Make room for new memory within the limit
+    const bool reserve(const std::size_t &bytes);
+    void trimFreeMemory();
+
+    DeviceContext &deviceContext;
+    uint64_t limitBytes;
+    std::size_t slabSize;
+    std::size_t minSizeClass;
+    std::size_t maxSlabSizeClass;
+    // CL_DEVICE_MAX_MEM_ALLOC_SIZE (size classes are never rounded up beyond it)
+    std::size_t maxAllocationSize;
+    std::map<std::size_t, std::vector<Block>> freeBlocks;
+    std::map<std::size_t, Slab> slabs;
+    std::size_t nextSlab = 1;
+    BufferPoolStatistics statistics;
+    mutable std::mutex mutex;
+};
+
+}
@@ -0,0 +1,283 @@
+#include "device_registry.hpp"
+
+// Include project headers
+#include "trace.hpp"
+
+// Include stl libraries
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+// Number of tab separated values of a snapshot (without the key)
+const std::size_t snapshotFieldCount = 24;
+
+const bool startsWith(const std::string &text, const std::string &prefix)
+{
+    return text.compare(0, prefix.size(), prefix) == 0;
+}
+
+const std::string joinSizes(const std::vector<std::size_t> &sizes)
+{
+    std::string text;
+    for (std::size_t i = 0; i < sizes.size(); i++) {
+        text += (i > 0 ? "x" : "") + std::to_string(sizes[i]);
+    }
+    return text;
+}
+
+const std::vector<std::size_t> splitSizes(const std::string &text)
+{
+    std::vector<std::size_t> sizes;
+    std::istringstream values(text);
+    std::string value;
+    while (std::getline(values, value, 'x')) {
+        sizes.push_back(std::strtoull(value.c_str(), nullptr, 10));
+    }
+    return sizes;
+}
+
+const unsigned long long toNumber(const std::string &text)
+{
+    return std::strtoull(text.c_str(), nullptr, 10);
+}
+
+}
+
+namespace clrt {
+
+const bool DeviceCapabilities::hasExtension(const std::string &extension) const
+{
+    // The extensions are separated by spaces
+    return (" " + extensions + " ").find(" " + extension + " ") != std::string::npos;
+}
+
+DeviceRegistry::DeviceRegistry(Runtime &runtime, const std::string &snapshotDirectory)
+    : runtime(runtime), snapshotPath(snapshotDirectory + "/device_snapshots.txt")
+{
+    createDirectory(snapshotDirectory);
+    load();
+}
+
+const bool DeviceRegistry::discover()
+{
+    TraceSpan span("discover devices");
+    const auto begin = std::chrono::steady_clock::now();
+    devices = runtime.getDevices();
+    capabilities.clear();
+    snapshotHitCount = 0;
+
+    // Only the names and versions are read to find the snapshot of a device
+    bool changed = false;
+    std::map<cl_platform_id, std::string> platformKeys;
+    for (auto const &device : devices) {
+        const cl::Platform platform(device.getInfo<CL_DEVICE_PLATFORM>());
+        auto platformKey = platformKeys.find(platform());
+        if (platformKey == platformKeys.end()) {
+            const std::string key = trimInfoString(platform.getInfo<CL_PLATFORM_NAME>()) + "|"
+                                    + trimInfoString(platform.getInfo<CL_PLATFORM_VERSION>());
+            platformKey = platformKeys.emplace(platform(), key).first;
+        }
+        const std::string key = platformKey->second + "|"
+                                + trimInfoString(device.getInfo<CL_DEVICE_NAME>()) + "|"
+                                + trimInfoString(device.getInfo<CL_DRIVER_VERSION>());
+        const auto snapshot = snapshots.find(key);
+        if (snapshot != snapshots.end()) {
+            capabilities.push_back(snapshot->second);
+            snapshotHitCount++;
+        } else {
+            capabilities.push_back(readCapabilities(device, platform));
+            snapshots[key] = capabilities.back();
+            changed = true;
+        }
+        capabilities.back().available = device.getInfo<CL_DEVICE_AVAILABLE>() == CL_TRUE;
+    }
+    discoveryNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>
+                                        (std::chrono::steady_clock::now() - begin).count());
+    return !changed || save();
+}
+
+const std::vector<cl::Device> &DeviceRegistry::getDevices() const
+{
+    return devices;
+}
+
+const std::vector<DeviceCapabilities> &DeviceRegistry::getCapabilities() const
+{
+    return capabilities;
+}
+
+const bool DeviceRegistry::select(const DeviceQuery &query, cl::Device &device) const
+{
+    double bestScore = -1;
+    for (std::size_t i = 0; i < devices.size(); i++) {
+        if (!capabilities[i].available || !matches(capabilities[i], query)) {
+            continue;
+        }
+        const double score = static_cast<double>(capabilities[i].computeUnitCount)
+                             * capabilities[i].maxClockFrequency;
+        if (score > bestScore) {
+            bestScore = score;
+            device = devices[i];
+        }
+    }
+    if (bestScore < 0) {
+        reportError("No available OpenCL device fulfills the device query");
+        return false;
+    }
+    return true;
+}
+
+const bool DeviceRegistry::matches(const DeviceCapabilities &capabilities,
+                                   const DeviceQuery &query)
+{
+    if (!(capabilities.type & query.type)
+        || capabilities.globalMemorySize < query.minGlobalMemorySize
+        || capabilities.maxWorkGroupSize < query.minWorkGroupSize
+        || capabilities.preferredVectorWidthInt < query.minPreferredVectorWidthInt
+        || (query.unifiedMemory && !capabilities.unifiedMemory)
+        || (query.imageSupport && !capabilities.imageSupport)
+        || !startsWith(capabilities.platformName, query.platformName)
+        || !startsWith(capabilities.name, query.deviceName)) {
+        return false;
+    }
+    for (auto const &extension : query.extensions) {
+        if (!capabilities.hasExtension(extension)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+const uint64_t DeviceRegistry::getDiscoveryNs() const
+{
+    return discoveryNs;
+}
+
+const std::size_t DeviceRegistry::getSnapshotHitCount() const
+{
+    return snapshotHitCount;
+}
+
+const DeviceCapabilities DeviceRegistry::readCapabilities(const cl::Device &device,
+                                                          const cl::Platform &platform)
+{
+    DeviceCapabilities capabilities;
+    capabilities.platformName = trimInfoString(platform.getInfo<CL_PLATFORM_NAME>());
+    capabilities.platformVendor = trimInfoString(platform.getInfo<CL_PLATFORM_VENDOR>());
+    capabilities.platformVersion = trimInfoString(platform.getInfo<CL_PLATFORM_VERSION>());
+    capabilities.platformProfile = trimInfoString(platform.getInfo<CL_PLATFORM_PROFILE>());
+    capabilities.icdSuffix = trimInfoString(platform.getInfo<CL_PLATFORM_ICD_SUFFIX_KHR>());
+    capabilities.platformExtensions = trimInfoString(platform.getInfo<CL_PLATFORM_EXTENSIONS>());
+    capabilities.name = trimInfoString(device.getInfo<CL_DEVICE_NAME>());
+    capabilities.vendor = trimInfoString(device.getInfo<CL_DEVICE_VENDOR>());
+    capabilities.version = trimInfoString(device.getInfo<CL_DEVICE_VERSION>());
+    capabilities.driverVersion = trimInfoString(device.getInfo<CL_DRIVER_VERSION>());
+    capabilities.type = device.getInfo<CL_DEVICE_TYPE>();
+    capabilities.computeUnitCount = device.getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>();
+    capabilities.maxClockFrequency = device.getInfo<CL_DEVICE_MAX_CLOCK_FREQUENCY>();
+    capabilities.maxWorkGroupSize = device.getInfo<CL_DEVICE_MAX_WORK_GROUP_SIZE>();
+    for (auto const &size : device.getInfo<CL_DEVICE_MAX_WORK_ITEM_SIZES>()) {
+        capabilities.maxWorkItemSizes.push_back(size);
+    }
+    capabilities.globalMemorySize = device.getInfo<CL_DEVICE_GLOBAL_MEM_SIZE>();
+    capabilities.localMemorySize = device.getInfo<CL_DEVICE_LOCAL_MEM_SIZE>();
+    capabilities.maxAllocationSize = device.getInfo<CL_DEVICE_MAX_MEM_ALLOC_SIZE>();
+    capabilities.preferredVectorWidthInt = device.getInfo<CL_DEVICE_PREFERRED_VECTOR_WIDTH_INT>();
+    capabilities.nativeVectorWidthInt = device.getInfo<CL_DEVICE_NATIVE_VECTOR_WIDTH_INT>();
+    capabilities.unifiedMemory = device.getInfo<CL_DEVICE_HOST_UNIFIED_MEMORY>() == CL_TRUE;
+    capabilities.imageSupport = device.getInfo<CL_DEVICE_IMAGE_SUPPORT>() == CL_TRUE;
+    capabilities.extensions = trimInfoString(device.getInfo<CL_DEVICE_EXTENSIONS>());
+    return capabilities;
+}
+
+void DeviceRegistry::load()
+{
+    // Format: One snapshot per line "key<TAB>value<TAB>value..." (see save)
+    std::ifstream file(snapshotPath);
+    std::string line;
+    while (std::getline(file, line)) {
+        std::vector<std::string> fields;
+        std::istringstream values(line);
+        std::string field;
+        while (std::getline(values, field, '\t')) {
+            fields.push_back(field);
+        }
+        // Lines of other versions of the format are ignored and replaced
+        if (fields.size() != snapshotFieldCount + 1) {
+            continue;
+        }
+        DeviceCapabilities capabilities;
+        std::size_t i = 1;
+        capabilities.platformName = fields[i++];
+        capabilities.platformVendor = fields[i++];
+        capabilities.platformVersion = fields[i++];
+        capabilities.platformProfile = fields[i++];
+        capabilities.icdSuffix = fields[i++];
+        capabilities.platformExtensions = fields[i++];
+        capabilities.name = fields[i++];
+        capabilities.vendor = fields[i++];
+        capabilities.version = fields[i++];
+        capabilities.driverVersion = fields[i++];
+        capabilities.type = static_cast<cl_device_type>(toNumber(fields[i++]));
+        capabilities.computeUnitCount = static_cast<cl_uint>(toNumber(fields[i++]));
+        capabilities.maxClockFrequency = static_cast<cl_uint>(toNumber(fields[i++]));
+        capabilities.maxWorkGroupSize = static_cast<std::size_t>(toNumber(fields[i++]));
+        capabilities.maxWorkItemSizes = splitSizes(fields[i++]);
+        capabilities.globalMemorySize = toNumber(fields[i++]);
+        capabilities.localMemorySize = toNumber(fields[i++]);
+        capabilities.maxAllocationSize = toNumber(fields[i++]);
+        capabilities.preferredVectorWidthInt = static_cast<cl_uint>(toNumber(fields[i++]));
+        capabilities.nativeVectorWidthInt = static_cast<cl_uint>(toNumber(fields[i++]));
+        capabilities.unifiedMemory = fields[i++] == "1";
+        capabilities.imageSupport = fields[i++] == "1";
+        capabilities.extensions = fields[i++];
+        // Marker of a complete line
+        if (fields[i] != "end") {
+            continue;
+        }
+        snapshots[fields[0]] = capabilities;
+    }
+}
+
+const bool DeviceRegistry::save() const
+{
+    // Write a temporary file first so that a crash never leaves a partially written file
+    const std::string temporaryPath = snapshotPath + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::trunc);
+        for (auto const &snapshot : snapshots) {
+            const DeviceCapabilities &capabilities = snapshot.second;
+            file << snapshot.first << '\t' << capabilities.platformName << '\t'
+                 << capabilities.platformVendor << '\t' << capabilities.platformVersion << '\t'
+                 << capabilities.platformProfile << '\t' << capabilities.icdSuffix << '\t'
+                 << capabilities.platformExtensions << '\t' << capabilities.name << '\t'
+                 << capabilities.vendor << '\t' << capabilities.version << '\t'
+                 << capabilities.driverVersion << '\t' << capabilities.type << '\t'
+                 << capabilities.computeUnitCount << '\t' << capabilities.maxClockFrequency
+                 << '\t' << capabilities.maxWorkGroupSize << '\t'
+                 << joinSizes(capabilities.maxWorkItemSizes) << '\t'
+                 << capabilities.globalMemorySize << '\t' << capabilities.localMemorySize << '\t'
+                 << capabilities.maxAllocationSize << '\t' << capabilities.preferredVectorWidthInt
+                 << '\t' << capabilities.nativeVectorWidthInt << '\t'
+                 << (capabilities.unifiedMemory ? 1 : 0) << '\t'
+                 << (capabilities.imageSupport ? 1 : 0) << '\t' << capabilities.extensions
+                 << "\tend\n";
+        }
+        if (!file) {
+            reportError("Device snapshots could not be written: " + temporaryPath);
+            return false;
+        }
+    }
+    std::remove(snapshotPath.c_str());
+    if (std::rename(temporaryPath.c_str(), snapshotPath.c_str()) != 0) {
+        reportError("Device snapshots could not be written: " + snapshotPath);
+        return false;
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+// Include project headers
+#include "runtime.hpp"
+
+// Include stl libraries
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace clrt {
+
+// Capabilities of a device and its platform that are read once (from the driver or from the
+// snapshot file)
+struct DeviceCapabilities {
+    std::string platformName;
+    std::string platformVendor;
+    std::string platformVersion;
+    std::string platformProfile;
+    std::string icdSuffix;
+    std::string platformExtensions;
+    std::string name;
+    std::string vendor;
+    std::string version;
+    std::string driverVersion;
+    cl_device_type type = 0;
+    // Is read on every discovery because it can change while the driver stays the same
+    bool available = false;
+    cl_uint computeUnitCount = 0;
+    // MHz
+    cl_uint maxClockFrequency = 0;
+    std::size_t maxWorkGroupSize = 0;
+    std::vector<std::size_t> maxWorkItemSizes;
+    cl_ulong globalMemorySize = 0;
+    cl_ulong localMemorySize = 0;
+    cl_ulong maxAllocationSize = 0;
+    cl_uint preferredVectorWidthInt = 0;
+    cl_uint nativeVectorWidthInt = 0;
+    // The device shares its memory with the host (buffers of host memory need no copies)
+    bool unifiedMemory = false;
+    bool imageSupport = false;
+    std::string extensions;
+
+    const bool hasExtension(const std::string &extension) const;
+};
+
+// Requirements of a device (default values = no requirement)
+struct DeviceQuery {
+    cl_device_type type = CL_DEVICE_TYPE_ALL;
+    cl_ulong minGlobalMemorySize = 0;
+    std::size_t minWorkGroupSize = 0;
+    cl_uint minPreferredVectorWidthInt = 0;
+    bool unifiedMemory = false;
+    bool imageSupport = false;
+    std::vector<std::string> extensions;
+    // Prefixes of the platform and device name
+    std::string platformName;
+    std::string deviceName;
+};
+
+// Takes one snapshot of the capabilities of all devices of a runtime instead of querying them
+// with many getInfo calls whenever they are needed
+//
+// The snapshots are stored in a file per platform (ICD), device and driver version, so later
+// discoveries only have to read the name and the versions of every device to reuse them
+class DeviceRegistry
+{
+public:
+    explicit DeviceRegistry(Runtime &runtime, const std::string &snapshotDirectory = "cache");
+
+    // Take the snapshot of all devices (reuses the stored snapshots of unchanged devices)
+    const bool discover();
+
+    // Devices of the runtime and their capabilities (same order)
+    const std::vector<cl::Device> &getDevices() const;
+    const std::vector<DeviceCapabilities> &getCapabilities() const;
+    // Select the available device that fulfills the query with the most compute units times
+    // clock frequency
+    const bool select(const DeviceQuery &query, cl::Device &device) const;
+    static const bool matches(const DeviceCapabilities &capabilities,
+                              const DeviceQuery &query);
+
+    // Time of the last discovery and the number of devices whose snapshot was reused
+    const uint64_t getDiscoveryNs() const;
+    const std::size_t getSnapshotHitCount() const;
+
+private:
+    static const DeviceCapabilities readCapabilities(const cl::Device &device,
+                                                     const cl::Platform &platform);
+    void load();
+    const bool save() const;
+
+    Runtime &runtime;
+    std::string snapshotPath;
+    std::map<std::string, DeviceCapabilities> snapshots;
+    std::vector<cl::Device> devices;
+    std::vector<DeviceCapabilities> capabilities;
+    uint64_t discoveryNs = 0;
+    std::size_t snapshotHitCount = 0;
+};
+
+}
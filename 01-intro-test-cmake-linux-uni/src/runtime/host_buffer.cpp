@@ -0,0 +1,163 @@
+#include "host_buffer.hpp"
+
+// Include project headers
+#include "trace.hpp"
+
+// Include stl libraries
+#include <cstdlib>
+
+// Include the aligned memory allocation methods
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+namespace clrt {
+
+void *allocateAlignedHostMemory(const std::size_t &size)
+{
+    // Round the size up to a multiple of the alignment (required by some zero copy devices)
+    const std::size_t alignedSize = (size + hostMemoryAlignment - 1) / hostMemoryAlignment
+                                    * hostMemoryAlignment;
+#ifdef _WIN32
+    return _aligned_malloc(alignedSize, hostMemoryAlignment);
+#else
+    void *data = nullptr;
+    if (posix_memalign(&data, hostMemoryAlignment, alignedSize) != 0) {
+        return nullptr;
+    }
+    return data;
+#endif
+}
+
+void freeAlignedHostMemory(void *data)
+{
+#ifdef _WIN32
+    _aligned_free(data);
+#else
+    free(data);
+#endif
+}
+
+HostBuffer::HostBuffer(DeviceContext &deviceContext, void *hostData, const std::size_t &size,
+                       const cl_mem_flags &flags, BufferPool *bufferPool)
+    : deviceContext(deviceContext), hostData(hostData), size(size)
+{
+    zeroCopy = deviceContext.device.getInfo<CL_DEVICE_HOST_UNIFIED_MEMORY>()
+               && reinterpret_cast<uintptr_t>(hostData) % hostMemoryAlignment == 0;
+    cl_int err = CL_SUCCESS;
+    if (zeroCopy) {
+        buffer = cl::Buffer(deviceContext.context, flags | CL_MEM_USE_HOST_PTR, size, hostData,
+                            &err);
+        if (err == CL_SUCCESS) {
+            // Map the buffer so that the host memory belongs to the host
+            deviceContext.queue.enqueueMapBuffer(buffer, CL_TRUE, CL_MAP_READ | CL_MAP_WRITE, 0,
+                                                 size, nullptr, nullptr, &err);
+            mapped = err == CL_SUCCESS;
+            valid = mapped;
+            if (valid) {
+                return;
+            }
+        }
+        // Fall back to a separate device buffer
+        zeroCopy = false;
+    }
+    if (bufferPool != nullptr) {
+        valid = bufferPool->acquire(size, pooledBuffer);
+        buffer = pooledBuffer.get();
+        return;
+    }
+    buffer = cl::Buffer(deviceContext.context, flags, size, nullptr, &err);
+    valid = err == CL_SUCCESS;
+    if (!valid) {
+        reportError("Buffer::Buffer failed", err);
+    }
+}
+
+HostBuffer::~HostBuffer()
+{
+    if (mapped) {
+        deviceContext.queue.enqueueUnmapMemObject(buffer, hostData);
+        deviceContext.queue.finish();
+    }
+}
+
+const bool HostBuffer::isValid() const
+{
+    return valid;
+}
+
+const bool HostBuffer::isZeroCopy() const
+{
+    return zeroCopy;
+}
+
+cl::Buffer &HostBuffer::get()
+{
+    return buffer;
+}
+
+const bool HostBuffer::toDevice(const std::vector<cl::Event> *waitEvents, cl::Event *event)
+{
+    cl::Event traceEvent;
+    event = getTraceEvent(event, traceEvent);
+    cl_int err = CL_SUCCESS;
+    if (zeroCopy) {
+        if (mapped) {
+            err = deviceContext.queue.enqueueUnmapMemObject(buffer, hostData, waitEvents, event);
+            mapped = false;
+        } else if (event != nullptr) {
+            err = deviceContext.queue.enqueueMarkerWithWaitList(waitEvents, event);
+        }
+        avoidedCopyBytes += size;
+    } else {
+        err = deviceContext.queue.enqueueWriteBuffer(buffer, CL_FALSE, 0, size, hostData,
+                                                     waitEvents, event);
+        copiedBytes += size;
+    }
+    if (err != CL_SUCCESS) {
+        reportError("HostBuffer::toDevice failed", err);
+        return false;
+    }
+    traceCommand(zeroCopy ? "unmap buffer" : "write buffer", event);
+    return true;
+}
+
+const bool HostBuffer::toHost(const std::vector<cl::Event> *waitEvents, cl::Event *event)
+{
+    cl::Event traceEvent;
+    event = getTraceEvent(event, traceEvent);
+    cl_int err = CL_SUCCESS;
+    if (zeroCopy) {
+        if (!mapped) {
+            // The mapped pointer is always the host pointer of a CL_MEM_USE_HOST_PTR buffer
+            deviceContext.queue.enqueueMapBuffer(buffer, CL_TRUE, CL_MAP_READ | CL_MAP_WRITE, 0,
+                                                 size, waitEvents, event, &err);
+            mapped = err == CL_SUCCESS;
+        } else if (event != nullptr) {
+            err = deviceContext.queue.enqueueMarkerWithWaitList(waitEvents, event);
+        }
+        avoidedCopyBytes += size;
+    } else {
+        err = deviceContext.queue.enqueueReadBuffer(buffer, CL_TRUE, 0, size, hostData,
+                                                    waitEvents, event);
+        copiedBytes += size;
+    }
+    if (err != CL_SUCCESS) {
+        reportError("HostBuffer::toHost failed", err);
+        return false;
+    }
+    traceCommand(zeroCopy ? "map buffer" : "read buffer", event);
+    return true;
+}
+
+const uint64_t HostBuffer::getCopiedBytes() const
+{
+    return copiedBytes;
+}
+
+const uint64_t HostBuffer::getAvoidedCopyBytes() const
+{
+    return avoidedCopyBytes;
+}
+
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+// Include project headers
+#include "runtime.hpp"
+
+// Include stl libraries
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+namespace clrt {
+
+// Alignment of host memory that devices can use without copying it (page size)
+constexpr std::size_t hostMemoryAlignment = 4096;
+
+void *allocateAlignedHostMemory(const std::size_t &size);
+void freeAlignedHostMemory(void *data);
+
+// Allocator for standard containers whose data can be used by the device without copying it
+template <typename T>
+struct AlignedAllocator {
+    typedef T value_type;
+
+    AlignedAllocator() = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U> &) {}
+
+    T *allocate(const std::size_t count)
+    {
+        void *data = allocateAlignedHostMemory(count * sizeof(T));
+        if (data == nullptr) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T *>(data);
+    }
+    void deallocate(T *data, const std::size_t)
+    {
+        freeAlignedHostMemory(data);
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const AlignedAllocator<T> &, const AlignedAllocator<U> &)
+{
+    return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const AlignedAllocator<T> &, const AlignedAllocator<U> &)
+{
+    return false;
+}
+
+// Device buffer for host memory that is not copied (zero copy) if the device shares the memory
+// with the host (CL_DEVICE_HOST_UNIFIED_MEMORY) and the host memory is page aligned:
+// The buffer is created with CL_MEM_USE_HOST_PTR and handed between host and device by
+// mapping/unmapping it, on all other devices the data is copied into/out of a device buffer
+//
+// The host memory belongs to the host after the creation and after toHost() and to the device
+// after toDevice() and has to stay valid as long as the buffer exists
+// The device buffer of the copy path is taken from the buffer pool if there is one (pooled
+// buffers are always CL_MEM_READ_WRITE)
+class HostBuffer
+{
+public:
+    HostBuffer(DeviceContext &deviceContext, void *hostData, const std::size_t &size,
+               const cl_mem_flags &flags = CL_MEM_READ_WRITE, BufferPool *bufferPool = nullptr);
+    ~HostBuffer();
+    HostBuffer(const HostBuffer &) = delete;
+    HostBuffer &operator=(const HostBuffer &) = delete;
+
+    const bool isValid() const;
+    const bool isZeroCopy() const;
+    cl::Buffer &get();
+
+    // Hand the host memory to the device (unmap it or write it into the device buffer)
+    const bool toDevice(const std::vector<cl::Event> *waitEvents = nullptr,
+                        cl::Event *event = nullptr);
+    // Hand the memory back to the host (map it or read the device buffer), blocks until the
+    // host can access the memory
+    const bool toHost(const std::vector<cl::Event> *waitEvents = nullptr,
+                      cl::Event *event = nullptr);
+
+    // Bytes that were transferred between host and device memory
+    const uint64_t getCopiedBytes() const;
+    // Bytes that did not need to be transferred because of the zero copy path
+    const uint64_t getAvoidedCopyBytes() const;
+
+private:
+    DeviceContext &deviceContext;
+    void *hostData;
+    std::size_t size;
+    cl::Buffer buffer;
+    PooledBuffer pooledBuffer;
+    bool valid = false;
+    bool zeroCopy = false;
+    bool mapped = false;
+    uint64_t copiedBytes = 0;
+    uint64_t avoidedCopyBytes = 0;
+};
+
+}
@@ -0,0 +1,247 @@
+#include "host_engine.hpp"
+
+// Include stl libraries
+#include <algorithm>
+#include <cstdint>
+
+// Include SIMD intrinsics: SSE2 is the baseline of x86-64, the AVX2 functions are compiled for
+// AVX2 independent of the compiler flags and are only called if the CPU supports it
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <immintrin.h>
+#define HOST_ENGINE_SSE2
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define HOST_ENGINE_AVX2_TARGET
+#else
+#define HOST_ENGINE_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace {
+
+// Chunks are a multiple of this element count so that no two threads write the same cache line
+constexpr std::size_t chunkGranularity = 4096;
+
+// Signed overflow is undefined behaviour, the kernels wrap around so the host does too
+inline int wrappingAdd(const std::size_t &index, const int &offset)
+{
+    return static_cast<int>(static_cast<uint32_t>(index) + static_cast<uint32_t>(offset));
+}
+
+#if defined(HOST_ENGINE_SSE2)
+// Check once if the CPU and the operating system (saved AVX registers) support AVX2
+const bool detectAvx2()
+{
+#if defined(_MSC_VER)
+    int info[4] = {};
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    if (!osxsave || (_xgetbv(0) & 6) != 6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+const bool supportsAvx2()
+{
+    static const bool avx2 = detectAvx2();
+    return avx2;
+}
+
+// Streaming (non temporal) stores do not pollute the cache with data that is not read again,
+// both functions start at an aligned element and return the first element they did not write
+HOST_ENGINE_AVX2_TARGET
+std::size_t fillIndexRangeAvx2(int *data, std::size_t i, const std::size_t &end,
+                               const int &offset)
+{
+    __m256i values = _mm256_add_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+                                      _mm256_set1_epi32(wrappingAdd(i, offset)));
+    const __m256i step = _mm256_set1_epi32(16);
+    const __m256i half = _mm256_set1_epi32(8);
+    for (; i + 16 <= end; i += 16) {
+        _mm256_stream_si256(reinterpret_cast<__m256i *>(data + i), values);
+        _mm256_stream_si256(reinterpret_cast<__m256i *>(data + i + 8),
+                            _mm256_add_epi32(values, half));
+        values = _mm256_add_epi32(values, step);
+    }
+    _mm_sfence();
+    return i;
+}
+
+std::size_t fillIndexRangeSse2(int *data, std::size_t i, const std::size_t &end,
+                               const int &offset)
+{
+    __m128i values = _mm_add_epi32(_mm_setr_epi32(0, 1, 2, 3),
+                                   _mm_set1_epi32(wrappingAdd(i, offset)));
+    const __m128i step = _mm_set1_epi32(8);
+    const __m128i half = _mm_set1_epi32(4);
+    for (; i + 8 <= end; i += 8) {
+        _mm_stream_si128(reinterpret_cast<__m128i *>(data + i), values);
+        _mm_stream_si128(reinterpret_cast<__m128i *>(data + i + 4), _mm_add_epi32(values, half));
+        values = _mm_add_epi32(values, step);
+    }
+    _mm_sfence();
+    return i;
+}
+#endif
+
+void fillIndexRange(int *data, const std::size_t &begin, const std::size_t &end,
+                    const int &offset)
+{
+    std::size_t i = begin;
+#if defined(HOST_ENGINE_SSE2)
+    // Write single elements until the data is aligned for the streaming stores
+    constexpr std::size_t alignment = 32;
+    while (i < end && reinterpret_cast<uintptr_t>(data + i) % alignment != 0) {
+        data[i] = wrappingAdd(i, offset);
+        i++;
+    }
+    i = supportsAvx2() ? fillIndexRangeAvx2(data, i, end, offset)
+        : fillIndexRangeSse2(data, i, end, offset);
+#endif
+    // Remaining elements
+    for (; i < end; i++) {
+        data[i] = wrappingAdd(i, offset);
+    }
+}
+
+}
+
+namespace clrt {
+
+HostEngine::HostEngine(const unsigned int &threadCount)
+{
+    const unsigned int workerCount = threadCount > 0 ? threadCount
+                                     : std::max(1U, std::thread::hardware_concurrency());
+    for (unsigned int i = 0; i < workerCount; i++) {
+        workers.emplace_back(&HostEngine::runWorker, this);
+    }
+}
+
+HostEngine::~HostEngine()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    taskAvailable.notify_all();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+const unsigned int HostEngine::getThreadCount() const
+{
+    return static_cast<unsigned int>(workers.size());
+}
+
+const char *HostEngine::getSimdName()
+{
+#if defined(HOST_ENGINE_SSE2)
+    return supportsAvx2() ? "AVX2" : "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+void HostEngine::parallelFor(const std::size_t &size,
+                             const std::function<void(std::size_t, std::size_t)> &function)
+{
+    const std::size_t chunkCount = std::max<std::size_t>(1, std::min<std::size_t>(
+                                                             workers.size(), size / chunkGranularity));
+    std::size_t chunkSize = (size + chunkCount - 1) / chunkCount;
+    chunkSize = (chunkSize + chunkGranularity - 1) / chunkGranularity * chunkGranularity;
+
+    std::vector<std::function<void()>> chunks;
+    for (std::size_t begin = 0; begin < size; begin += chunkSize) {
+        const std::size_t end = std::min(size, begin + chunkSize);
+        chunks.push_back([&function, begin, end]() {
+            function(begin, end);
+        });
+    }
+    runTasks(chunks);
+}
+
+void HostEngine::sort(uint32_t *keys, const std::size_t &size)
+{
+    // Sort one run per thread and merge neighbouring runs in parallel until one run is left
+    const std::size_t runCount = std::max<std::size_t>(1, std::min<std::size_t>(
+                                                           workers.size(), size / chunkGranularity));
+    const std::size_t runSize = (size + runCount - 1) / runCount;
+    std::vector<std::function<void()>> sorts;
+    for (std::size_t begin = 0; begin < size; begin += runSize) {
+        const std::size_t end = std::min(size, begin + runSize);
+        sorts.push_back([keys, begin, end]() {
+            std::sort(keys + begin, keys + end);
+        });
+    }
+    runTasks(sorts);
+    for (std::size_t width = runSize; width < size; width *= 2) {
+        std::vector<std::function<void()>> merges;
+        for (std::size_t begin = 0; begin + width < size; begin += 2 * width) {
+            const std::size_t middle = begin + width;
+            const std::size_t end = std::min(size, begin + 2 * width);
+            merges.push_back([keys, begin, middle, end]() {
+                std::inplace_merge(keys + begin, keys + middle, keys + end);
+            });
+        }
+        runTasks(merges);
+    }
+}
+
+void HostEngine::fillIndices(int *output, const std::size_t &size, const int &offset)
+{
+    parallelFor(size, [output, offset](std::size_t begin, std::size_t end) {
+        fillIndexRange(output, begin, end, offset);
+    });
+}
+
+void HostEngine::fillIndices(std::vector<int> &output, const int &offset)
+{
+    fillIndices(output.data(), output.size(), offset);
+}
+
+void HostEngine::runTasks(const std::vector<std::function<void()>> &functions)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    for (auto const &function : functions) {
+        tasks.push(function);
+        unfinishedTaskCount++;
+    }
+    taskAvailable.notify_all();
+    tasksFinished.wait(lock, [this]() {
+        return unfinishedTaskCount == 0;
+    });
+}
+
+void HostEngine::runWorker()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        taskAvailable.wait(lock, [this]() {
+            return stopping || !tasks.empty();
+        });
+        if (tasks.empty()) {
+            return;
+        }
+        const std::function<void()> task = std::move(tasks.front());
+        tasks.pop();
+        lock.unlock();
+        task();
+        lock.lock();
+        if (--unfinishedTaskCount == 0) {
+            tasksFinished.notify_all();
+        }
+    }
+}
+
+}
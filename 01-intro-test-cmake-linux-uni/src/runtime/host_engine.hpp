@@ -0,0 +1,57 @@
+#pragma once
+
+// Include stl libraries
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace clrt {
+
+// Optimized host (CPU) reference implementation: A thread pool that splits index ranges
+// across all hardware threads and SIMD (AVX2/SSE2) implementations of the kernels
+class HostEngine
+{
+public:
+    // Use all hardware threads if the thread count is 0
+    explicit HostEngine(const unsigned int &threadCount = 0);
+    ~HostEngine();
+    HostEngine(const HostEngine &) = delete;
+    HostEngine &operator=(const HostEngine &) = delete;
+
+    const unsigned int getThreadCount() const;
+    // Name of the instruction set that the SIMD implementations use on this CPU (AVX2 is
+    // selected at runtime if the CPU supports it)
+    static const char *getSimdName();
+
+    // Split [0, size) into one chunk per thread and call function(begin, end) for every chunk,
+    // returns when all chunks are finished
+    void parallelFor(const std::size_t &size,
+                     const std::function<void(std::size_t, std::size_t)> &function);
+
+    // output[i] = i + offset (the host equivalent of the kernels "simple" and "kernelSimple")
+    void fillIndices(int *output, const std::size_t &size, const int &offset = 0);
+    void fillIndices(std::vector<int> &output, const int &offset = 0);
+    // Multithreaded sort: Every thread sorts a run with std::sort and the runs are merged in
+    // rounds (the merges of a round run in parallel)
+    void sort(uint32_t *keys, const std::size_t &size);
+
+private:
+    // Run the functions on the workers and return when all of them are finished
+    void runTasks(const std::vector<std::function<void()>> &functions);
+    void runWorker();
+
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable taskAvailable;
+    std::condition_variable tasksFinished;
+    std::size_t unfinishedTaskCount = 0;
+    bool stopping = false;
+};
+
+}
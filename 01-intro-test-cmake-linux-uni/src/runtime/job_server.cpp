@@ -0,0 +1,332 @@
+#include "job_server.hpp"
+
+// Include project headers
+#include "benchmark.hpp"
+#include "trace.hpp"
+
+// Include stl libraries
+#include <algorithm>
+
+namespace {
+
+const uint64_t getElapsedNs(const std::chrono::steady_clock::time_point &begin)
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>
+                                 (std::chrono::steady_clock::now() - begin).count());
+}
+
+}
+
+namespace clrt {
+
+JobArgument::JobArgument(const cl::Buffer &buffer)
+    : buffer(buffer)
+{
+}
+
+const bool JobArgument::apply(cl::Kernel &kernel, const cl_uint &index) const
+{
+    const cl_int err = buffer() != nullptr ? kernel.setArg(index, buffer)
+                       : kernel.setArg(index, value.size(), value.data());
+    if (err != CL_SUCCESS) {
+        reportError("Kernel::setArg(" + std::to_string(index) + ") failed", err);
+        return false;
+    }
+    return true;
+}
+
+JobServer::JobServer(Runtime &runtime, const std::vector<cl::Device> &devices,
+                     const unsigned int &workersPerDevice, const std::size_t &maxPendingJobs,
+                     const std::size_t &maxCoalescedJobs)
+    : maxPendingJobs(std::max<std::size_t>(1, maxPendingJobs)),
+      maxCoalescedJobs(std::max<std::size_t>(1, maxCoalescedJobs)),
+      statisticsBegin(std::chrono::steady_clock::now())
+{
+    // Create all workers with their own queue before the threads start
+    for (auto const &device : devices) {
+        DeviceContext &deviceContext = runtime.getDeviceContext(device);
+        const std::string deviceName = trimInfoString(device.getInfo<CL_DEVICE_NAME>());
+        this->devices.push_back(device());
+        deviceWorkers.emplace_back();
+        // Devices without a context get no workers (their jobs are rejected by submit)
+        if (!deviceContext.valid) {
+            continue;
+        }
+        for (unsigned int i = 0; i < std::max(1U, workersPerDevice); i++) {
+            std::unique_ptr<Worker> worker(new Worker());
+            worker->deviceIndex = this->devices.size() - 1;
+            cl_int err = CL_SUCCESS;
+            worker->queue = cl::CommandQueue(deviceContext.context, device,
+                                             CL_QUEUE_PROFILING_ENABLE, &err);
+            if (err != CL_SUCCESS) {
+                reportError("CommandQueue::CommandQueue failed", err);
+                continue;
+            }
+            worker->statistics.deviceName = deviceName;
+            worker->statistics.workerIndex = workers.size();
+            deviceWorkers.back().push_back(workers.size());
+            workers.push_back(std::move(worker));
+        }
+    }
+    nextWorkers.assign(this->devices.size(), 0);
+    queuedJobCounts.assign(this->devices.size(), 0);
+    for (std::size_t i = 0; i < workers.size(); i++) {
+        workers[i]->thread = std::thread(&JobServer::runWorker, this, i);
+    }
+}
+
+JobServer::~JobServer()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    pendingJobsAvailable.notify_all();
+    for (auto &worker : workers) {
+        worker->thread.join();
+    }
+}
+
+const bool JobServer::submit(const Program &program, const std::string &kernelName,
+                             const std::vector<JobArgument> &arguments,
+                             const cl::NDRange &global, std::future<JobResult> &future,
+                             const cl::NDRange &local)
+{
+    const auto device = std::find(devices.begin(), devices.end(),
+                                  program.getDeviceContext().device());
+    if (device == devices.end() || deviceWorkers[device - devices.begin()].empty()) {
+        reportError("JobServer::submit: The program of the kernel " + kernelName
+                    + " was built for a device without workers");
+        return false;
+    }
+    const std::size_t deviceIndex = device - devices.begin();
+
+    std::unique_ptr<Job> job(new Job());
+    job->program = program.get();
+    job->kernelName = kernelName;
+    job->arguments = arguments;
+    job->global = global;
+    job->local = local;
+    future = job->promise.get_future();
+
+    // Wait until there is room for another unfinished job, select the worker and queue the job
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        pendingJobsAvailable.wait(lock, [this]() {
+            return stopping || pendingJobCount < maxPendingJobs;
+        });
+        if (stopping) {
+            reportError("JobServer::submit: The server is stopping");
+            return false;
+        }
+        pendingJobCount++;
+        const std::vector<std::size_t> &candidates = deviceWorkers[deviceIndex];
+        Worker &worker = *workers[candidates[nextWorkers[deviceIndex]++ % candidates.size()]];
+        job->submitTime = std::chrono::steady_clock::now();
+        // The job is queued and counted under the server lock (the only place that holds both
+        // locks, always in this order), so a worker can never take it before it is counted
+        std::lock_guard<std::mutex> workerLock(worker.mutex);
+        worker.jobs.push_back(std::move(job));
+        queuedJobCounts[deviceIndex]++;
+    }
+    workAvailable.notify_all();
+    return true;
+}
+
+const std::size_t JobServer::getWorkerCount() const
+{
+    return workers.size();
+}
+
+const std::vector<JobQueueStatistics> JobServer::getStatistics() const
+{
+    uint64_t elapsedNs = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        elapsedNs = getElapsedNs(statisticsBegin);
+    }
+    std::vector<JobQueueStatistics> statistics;
+    for (auto const &worker : workers) {
+        std::lock_guard<std::mutex> lock(worker->mutex);
+        statistics.push_back(worker->statistics);
+        if (!worker->latenciesNs.empty()) {
+            const BenchmarkStatistics latency = calculateStatistics({ "latency" },
+                                                                    worker->latenciesNs);
+            statistics.back().medianLatencyNs = latency.medianNs;
+            statistics.back().p99LatencyNs = latency.p99Ns;
+        }
+        if (elapsedNs > 0) {
+            statistics.back().jobsPerSecond = 1e9 * worker->statistics.jobCount / elapsedNs;
+        }
+    }
+    return statistics;
+}
+
+void JobServer::resetStatistics()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        statisticsBegin = std::chrono::steady_clock::now();
+    }
+    for (auto &worker : workers) {
+        std::lock_guard<std::mutex> lock(worker->mutex);
+        JobQueueStatistics statistics;
+        statistics.deviceName = worker->statistics.deviceName;
+        statistics.workerIndex = worker->statistics.workerIndex;
+        worker->statistics = statistics;
+        worker->latenciesNs.clear();
+    }
+}
+
+void JobServer::runWorker(const std::size_t &workerIndex)
+{
+    Worker &worker = *workers[workerIndex];
+    while (true) {
+        std::vector<std::unique_ptr<Job>> jobs;
+        takeJobs(workerIndex, jobs);
+        if (!jobs.empty()) {
+            runJobs(worker, jobs);
+            continue;
+        }
+
+        // Sleep until a job is queued for the device (all jobs are run before the server stops)
+        std::unique_lock<std::mutex> lock(mutex);
+        if (stopping && queuedJobCounts[worker.deviceIndex] == 0) {
+            return;
+        }
+        workAvailable.wait(lock, [this, &worker]() {
+            return stopping || queuedJobCounts[worker.deviceIndex] > 0;
+        });
+    }
+}
+
+void JobServer::takeJobs(const std::size_t &workerIndex, std::vector<std::unique_ptr<Job>> &jobs)
+{
+    Worker &worker = *workers[workerIndex];
+    {
+        // Oldest jobs of the own queue first
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        while (!worker.jobs.empty() && jobs.size() < maxCoalescedJobs) {
+            jobs.push_back(std::move(worker.jobs.front()));
+            worker.jobs.pop_front();
+        }
+    }
+    if (jobs.empty()) {
+        // Steal half of the newest jobs of the fullest queue of the device
+        Worker *victim = nullptr;
+        std::size_t victimJobCount = 0;
+        for (auto const &index : deviceWorkers[worker.deviceIndex]) {
+            if (index == workerIndex) {
+                continue;
+            }
+            std::lock_guard<std::mutex> lock(workers[index]->mutex);
+            if (workers[index]->jobs.size() > victimJobCount) {
+                victim = workers[index].get();
+                victimJobCount = workers[index]->jobs.size();
+            }
+        }
+        if (victim != nullptr) {
+            std::lock_guard<std::mutex> lock(victim->mutex);
+            const std::size_t stealCount = std::min(maxCoalescedJobs,
+                                                    (victim->jobs.size() + 1) / 2);
+            while (!victim->jobs.empty() && jobs.size() < stealCount) {
+                jobs.push_back(std::move(victim->jobs.back()));
+                victim->jobs.pop_back();
+            }
+            std::reverse(jobs.begin(), jobs.end());
+        }
+        if (!jobs.empty()) {
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            worker.statistics.stolenJobCount += jobs.size();
+        }
+    }
+    if (!jobs.empty()) {
+        std::lock_guard<std::mutex> lock(mutex);
+        queuedJobCounts[worker.deviceIndex] -= jobs.size();
+    }
+}
+
+void JobServer::runJobs(Worker &worker, std::vector<std::unique_ptr<Job>> &jobs)
+{
+    // Enqueue all jobs and flush them together (the kernel arguments are captured by the
+    // enqueue so the same kernel object can be used by all of them)
+    std::vector<cl::Event> events(jobs.size());
+    std::vector<bool> enqueued(jobs.size(), false);
+    for (std::size_t i = 0; i < jobs.size(); i++) {
+        const Job &job = *jobs[i];
+        cl::Kernel *kernel = nullptr;
+        if (!getKernel(worker, job, kernel)) {
+            continue;
+        }
+        bool success = true;
+        for (std::size_t argument = 0; argument < job.arguments.size() && success; argument++) {
+            success = job.arguments[argument].apply(*kernel, static_cast<cl_uint>(argument));
+        }
+        if (!success) {
+            continue;
+        }
+        const cl_int err = worker.queue.enqueueNDRangeKernel(*kernel, cl::NullRange, job.global,
+                                                             job.local, nullptr, &events[i]);
+        if (err != CL_SUCCESS) {
+            reportError("CommandQueue::enqueueNDRangeKernel failed for the job " + job.kernelName,
+                        err);
+            continue;
+        }
+        traceCommand("job", &events[i]);
+        enqueued[i] = true;
+    }
+    worker.queue.flush();
+
+    // The in order queue finishes the jobs in order, report every job as soon as it is done
+    std::vector<JobResult> results(jobs.size());
+    for (std::size_t i = 0; i < jobs.size(); i++) {
+        JobResult &result = results[i];
+        if (enqueued[i]) {
+            const cl_int err = events[i].wait();
+            if (err != CL_SUCCESS) {
+                reportError("Event::wait failed for the job " + jobs[i]->kernelName, err);
+            } else {
+                result.success = true;
+                result.kernelNs = getEventDurationNs(events[i]);
+            }
+        }
+        result.latencyNs = getElapsedNs(jobs[i]->submitTime);
+        jobs[i]->promise.set_value(result);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.statistics.flushCount++;
+        for (auto const &result : results) {
+            worker.statistics.jobCount++;
+            worker.statistics.failedJobCount += result.success ? 0 : 1;
+            worker.statistics.kernelNs += result.kernelNs;
+            worker.latenciesNs.push_back(result.latencyNs);
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pendingJobCount -= jobs.size();
+    }
+    pendingJobsAvailable.notify_all();
+}
+
+const bool JobServer::getKernel(Worker &worker, const Job &job, cl::Kernel *&kernel)
+{
+    const auto key = std::make_pair(job.program(), job.kernelName);
+    auto found = worker.kernels.find(key);
+    if (found == worker.kernels.end()) {
+        cl_int err = CL_SUCCESS;
+        const cl::Kernel created(job.program, job.kernelName.c_str(), &err);
+        if (err != CL_SUCCESS) {
+            reportError("Kernel::Kernel failed for the job " + job.kernelName, err);
+            return false;
+        }
+        found = worker.kernels.emplace(key, created).first;
+    }
+    kernel = &found->second;
+    return true;
+}
+
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+// Include project headers
+#include "runtime.hpp"
+
+// Include stl libraries
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace clrt {
+
+// Kernel argument of a job: A buffer or a plain value that is copied when it is created
+class JobArgument
+{
+public:
+    JobArgument(const cl::Buffer &buffer);
+    template <typename T>
+    JobArgument(const T &value);
+
+    const bool apply(cl::Kernel &kernel, const cl_uint &index) const;
+
+private:
+    cl::Buffer buffer;
+    std::vector<unsigned char> value;
+};
+
+// Result of a job that the future of the submission returns when the kernel is finished
+struct JobResult {
+    bool success = false;
+    // Execution time of the kernel on the device
+    uint64_t kernelNs = 0;
+    // Time between the submission and the moment the host saw the kernel finish
+    uint64_t latencyNs = 0;
+};
+
+// Metrics of a worker (and its command queue) since the server started or the last reset
+struct JobQueueStatistics {
+    std::string deviceName;
+    std::size_t workerIndex = 0;
+    std::size_t jobCount = 0;
+    std::size_t failedJobCount = 0;
+    // Jobs that the worker took from the queues of other workers of the same device
+    std::size_t stolenJobCount = 0;
+    // Number of coalesced groups of jobs that were flushed to the device together
+    std::size_t flushCount = 0;
+    uint64_t kernelNs = 0;
+    uint64_t medianLatencyNs = 0;
+    uint64_t p99LatencyNs = 0;
+    double jobsPerSecond = 0;
+};
+
+// In process server that runs kernel jobs of many producer threads: Every device gets a pool of
+// host worker threads that own a command queue each, a worker takes all jobs of its own queue
+// at once (up to the coalescing limit), enqueues them with a single flush and steals jobs from
+// the other workers of the device when its own queue is empty so that no queue of a busy device
+// stays idle
+//
+// submit blocks while the maximum number of unfinished jobs is reached (back pressure), so fast
+// producers cannot queue up unbounded work
+// Jobs of the same program and kernel name may run on any worker of the device, every worker
+// creates its own kernel object for them so that the arguments of concurrent jobs do not mix
+class JobServer
+{
+public:
+    JobServer(Runtime &runtime, const std::vector<cl::Device> &devices,
+              const unsigned int &workersPerDevice = 2, const std::size_t &maxPendingJobs = 1024,
+              const std::size_t &maxCoalescedJobs = 16);
+    // Runs all submitted jobs and stops the workers
+    ~JobServer();
+    JobServer(const JobServer &) = delete;
+    JobServer &operator=(const JobServer &) = delete;
+
+    // Submit a kernel of a program (built for one of the devices of the server) with its
+    // arguments, the buffers have to stay valid until the future is ready
+    const bool submit(const Program &program, const std::string &kernelName,
+                      const std::vector<JobArgument> &arguments, const cl::NDRange &global,
+                      std::future<JobResult> &future, const cl::NDRange &local = cl::NullRange);
+
+    const std::size_t getWorkerCount() const;
+    // Metrics of every worker/command queue
+    const std::vector<JobQueueStatistics> getStatistics() const;
+    void resetStatistics();
+
+private:
+    struct Job {
+        cl::Program program;
+        std::string kernelName;
+        std::vector<JobArgument> arguments;
+        cl::NDRange global;
+        cl::NDRange local;
+        std::promise<JobResult> promise;
+        std::chrono::steady_clock::time_point submitTime;
+    };
+
+    struct Worker {
+        // Index of the device whose workers can steal from each other
+        std::size_t deviceIndex = 0;
+        cl::CommandQueue queue;
+        std::deque<std::unique_ptr<Job>> jobs;
+        // Kernels of the worker per program and kernel name (only used by the worker thread)
+        std::map<std::pair<cl_program, std::string>, cl::Kernel> kernels;
+        JobQueueStatistics statistics;
+        std::vector<uint64_t> latenciesNs;
+        // Guards the jobs and the statistics
+        mutable std::mutex mutex;
+        std::thread thread;
+    };
+
+    void runWorker(const std::size_t &workerIndex);
+    // Take the jobs of the own queue or steal from the fullest queue of the device
+    void takeJobs(const std::size_t &workerIndex, std::vector<std::unique_ptr<Job>> &jobs);
+    void runJobs(Worker &worker, std::vector<std::unique_ptr<Job>> &jobs);
+    const bool getKernel(Worker &worker, const Job &job, cl::Kernel *&kernel);
+
+    std::size_t maxPendingJobs;
+    std::size_t maxCoalescedJobs;
+    std::vector<cl_device_id> devices;
+    std::vector<std::unique_ptr<Worker>> workers;
+    // Workers of every device and the one that gets the next submission
+    std::vector<std::vector<std::size_t>> deviceWorkers;
+    std::vector<std::size_t> nextWorkers;
+
+    // Guards the counters and the shutdown flag
+    mutable std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::condition_variable pendingJobsAvailable;
+    // Jobs that were submitted but are not finished (back pressure) and jobs in the queues of
+    // the workers of every device
+    std::size_t pendingJobCount = 0;
+    std::vector<std::size_t> queuedJobCounts;
+    bool stopping = false;
+    std::chrono::steady_clock::time_point statisticsBegin;
+};
+
+template <typename T>
+JobArgument::JobArgument(const T &value)
+    : value(sizeof(T))
+{
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "Kernel arguments have to be buffers or trivially copyable values");
+    std::memcpy(this->value.data(), &value, sizeof(T));
+}
+
+}
@@ -0,0 +1,261 @@
+#include "mapped_file.hpp"
+
+// Include project headers
+#include "runtime.hpp"
+
+// Include stl libraries
+#include <cerrno>
+#include <cstring>
+
+// Include the memory mapping methods
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Description of the last error of the operating system
+const std::string getSystemError()
+{
+#ifdef _WIN32
+    return "error " + std::to_string(GetLastError());
+#else
+    return std::strerror(errno);
+#endif
+}
+
+}
+
+namespace clrt {
+
+MappedRange::~MappedRange()
+{
+    unmap();
+}
+
+MappedRange::MappedRange(MappedRange &&other)
+{
+    *this = std::move(other);
+}
+
+MappedRange &MappedRange::operator=(MappedRange &&other)
+{
+    if (this != &other) {
+        unmap();
+        base = other.base;
+        mappedSize = other.mappedSize;
+        data = other.data;
+        size = other.size;
+        other.base = nullptr;
+        other.data = nullptr;
+    }
+    return *this;
+}
+
+const bool MappedRange::isMapped() const
+{
+    return base != nullptr;
+}
+
+void *MappedRange::getData() const
+{
+    return data;
+}
+
+const std::size_t MappedRange::getSize() const
+{
+    return size;
+}
+
+void MappedRange::unmap()
+{
+    if (base != nullptr) {
+#ifdef _WIN32
+        UnmapViewOfFile(base);
+#else
+        munmap(base, mappedSize);
+#endif
+        base = nullptr;
+        data = nullptr;
+    }
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+const bool MappedFile::openRead(const std::string &filePath)
+{
+    return open(filePath, false, 0);
+}
+
+const bool MappedFile::create(const std::string &filePath, const uint64_t &size)
+{
+    return open(filePath, true, size);
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+    if (mapping != nullptr) {
+        CloseHandle(mapping);
+        mapping = nullptr;
+    }
+    if (file != nullptr) {
+        CloseHandle(file);
+        file = nullptr;
+    }
+#else
+    if (descriptor >= 0) {
+        ::close(descriptor);
+        descriptor = -1;
+    }
+#endif
+    size = 0;
+    writable = false;
+}
+
+const bool MappedFile::isOpen() const
+{
+#ifdef _WIN32
+    return file != nullptr;
+#else
+    return descriptor >= 0;
+#endif
+}
+
+const bool MappedFile::isWritable() const
+{
+    return isOpen() && writable;
+}
+
+const uint64_t MappedFile::getSize() const
+{
+    return size;
+}
+
+const bool MappedFile::map(const uint64_t &offset, const std::size_t &size,
+                           MappedRange &range) const
+{
+    range.unmap();
+    if (!isOpen() || size == 0 || offset + size > this->size) {
+        reportError("MappedFile::map: The range " + std::to_string(offset) + "+"
+                    + std::to_string(size) + " is not part of the file " + filePath);
+        return false;
+    }
+
+    // Mappings have to start at a multiple of the granularity
+    const uint64_t mappedOffset = offset / getGranularity() * getGranularity();
+    const std::size_t mappedSize = static_cast<std::size_t>(offset - mappedOffset) + size;
+#ifdef _WIN32
+    void *base = MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ,
+                               static_cast<DWORD>(mappedOffset >> 32),
+                               static_cast<DWORD>(mappedOffset & 0xFFFFFFFF), mappedSize);
+    if (base == nullptr) {
+#else
+    void *base = mmap(nullptr, mappedSize, writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                      MAP_SHARED, descriptor, static_cast<off_t>(mappedOffset));
+    if (base == MAP_FAILED) {
+#endif
+        reportError("MappedFile::map: The range " + std::to_string(offset) + "+"
+                    + std::to_string(size) + " of the file " + filePath
+                    + " could not be mapped (" + getSystemError() + ")");
+        return false;
+    }
+#ifndef _WIN32
+    // The ranges are processed from front to back, read ahead and drop them early
+    madvise(base, mappedSize, MADV_SEQUENTIAL);
+#endif
+    range.base = base;
+    range.mappedSize = mappedSize;
+    range.data = static_cast<unsigned char *>(base) + (offset - mappedOffset);
+    range.size = size;
+    return true;
+}
+
+const std::size_t MappedFile::getGranularity()
+{
+#ifdef _WIN32
+    SYSTEM_INFO systemInfo;
+    GetSystemInfo(&systemInfo);
+    return systemInfo.dwAllocationGranularity;
+#else
+    return static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+const bool MappedFile::open(const std::string &filePath, const bool &write,
+                            const uint64_t &newSize)
+{
+    close();
+    this->filePath = filePath;
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(filePath.c_str(), write ? GENERIC_READ | GENERIC_WRITE
+                                : GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                write ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                                nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        reportError("The file " + filePath + " could not be opened (" + getSystemError() + ")");
+        return false;
+    }
+    file = handle;
+    LARGE_INTEGER fileSize;
+    fileSize.QuadPart = static_cast<LONGLONG>(newSize);
+    if (write && (!SetFilePointerEx(handle, fileSize, nullptr, FILE_BEGIN)
+                  || !SetEndOfFile(handle))) {
+        reportError("The file " + filePath + " could not be resized (" + getSystemError() + ")");
+        close();
+        return false;
+    }
+    if (!write && !GetFileSizeEx(handle, &fileSize)) {
+        reportError("The size of the file " + filePath + " could not be read ("
+                    + getSystemError() + ")");
+        close();
+        return false;
+    }
+    size = static_cast<uint64_t>(fileSize.QuadPart);
+    // Empty files cannot be mapped (and have no ranges)
+    if (size > 0) {
+        mapping = CreateFileMappingA(handle, nullptr, write ? PAGE_READWRITE : PAGE_READONLY, 0, 0,
+                                     nullptr);
+        if (mapping == nullptr) {
+            reportError("The file " + filePath + " could not be mapped (" + getSystemError()
+                        + ")");
+            close();
+            return false;
+        }
+    }
+#else
+    descriptor = ::open(filePath.c_str(), write ? O_RDWR | O_CREAT | O_TRUNC : O_RDONLY, 0644);
+    if (descriptor < 0) {
+        reportError("The file " + filePath + " could not be opened (" + getSystemError() + ")");
+        return false;
+    }
+    if (write && ftruncate(descriptor, static_cast<off_t>(newSize)) != 0) {
+        reportError("The file " + filePath + " could not be resized (" + getSystemError() + ")");
+        close();
+        return false;
+    }
+    struct stat fileStatus;
+    if (fstat(descriptor, &fileStatus) != 0) {
+        reportError("The size of the file " + filePath + " could not be read ("
+                    + getSystemError() + ")");
+        close();
+        return false;
+    }
+    size = static_cast<uint64_t>(fileStatus.st_size);
+#endif
+    writable = write;
+    return true;
+}
+
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+// Include stl libraries
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace clrt {
+
+class MappedFile;
+
+// Mapped range of a file that is unmapped when the handle is destroyed or unmapped (changes of
+// a writable range are written back into the file by the operating system)
+class MappedRange
+{
+public:
+    MappedRange() = default;
+    ~MappedRange();
+    MappedRange(MappedRange &&other);
+    MappedRange &operator=(MappedRange &&other);
+    MappedRange(const MappedRange &) = delete;
+    MappedRange &operator=(const MappedRange &) = delete;
+
+    const bool isMapped() const;
+    // Start of the requested range (page aligned if the offset was a multiple of the
+    // granularity)
+    void *getData() const;
+    const std::size_t getSize() const;
+    void unmap();
+
+private:
+    friend class MappedFile;
+
+    // The mapping starts at the granularity boundary in front of the requested offset
+    void *base = nullptr;
+    std::size_t mappedSize = 0;
+    void *data = nullptr;
+    std::size_t size = 0;
+};
+
+// File whose content is accessed through memory mapped ranges instead of reading it into host
+// memory: Only the pages of the mapped ranges are resident so the host memory that is used
+// stays bounded by the mapped ranges independent of the file size
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // Open an existing file whose ranges can only be read
+    const bool openRead(const std::string &filePath);
+    // Create (or truncate) a file of the size whose ranges can be read and written
+    const bool create(const std::string &filePath, const uint64_t &size);
+    void close();
+
+    const bool isOpen() const;
+    const bool isWritable() const;
+    const uint64_t getSize() const;
+
+    // Map a range of the file (replaces/unmaps the range that the handle had before), ranges
+    // that start at a multiple of the granularity are page aligned
+    const bool map(const uint64_t &offset, const std::size_t &size, MappedRange &range) const;
+    // Alignment of the mappings of the operating system (page size or allocation granularity)
+    static const std::size_t getGranularity();
+
+private:
+    const bool open(const std::string &filePath, const bool &write, const uint64_t &newSize);
+
+    std::string filePath;
+    uint64_t size = 0;
+    bool writable = false;
+#ifdef _WIN32
+    // Handles of the file and its file mapping object
+    void *file = nullptr;
+    void *mapping = nullptr;
+#else
+    int descriptor = -1;
+#endif
+};
+
+}
@@ -0,0 +1,284 @@
+#include "pipeline.hpp"
+
+// Include stl libraries
+#include <algorithm>
+#include <functional>
+#include <sstream>
+
+namespace clrt {
+
+Pipeline::Pipeline(Runtime &runtime, const cl::Device &device,
+                   const std::vector<std::string> &sourceFiles,
+                   const Specialization &specialization)
+    : runtime(runtime), device(device), sourceFiles(sourceFiles), specialization(specialization)
+{
+    valid = runtime.buildSpecializedProgram(device, sourceFiles, specialization, program);
+}
+
+const bool Pipeline::isValid() const
+{
+    return valid;
+}
+
+const bool Pipeline::addBuffer(const std::size_t &size, PipelineBufferId &buffer)
+{
+    PooledBuffer pooledBuffer;
+    if (!runtime.getBufferPool(device).acquire(size, pooledBuffer)) {
+        return false;
+    }
+    buffer = buffers.size();
+    buffers.push_back(std::move(pooledBuffer));
+    return true;
+}
+
+cl::Buffer &Pipeline::getBuffer(const PipelineBufferId &buffer)
+{
+    return buffers[buffer].get();
+}
+
+const bool Pipeline::addKernel(const std::string &kernelName,
+                               const std::vector<PipelineBufferId> &inputs,
+                               const std::vector<PipelineBufferId> &outputs,
+                               const std::size_t &globalSize, PipelineStageId &stage)
+{
+    Stage newStage;
+    newStage.name = kernelName;
+    newStage.inputs = inputs;
+    newStage.outputs = outputs;
+    newStage.globalSize = globalSize;
+    if (!valid || !checkBuffers(inputs) || !checkBuffers(outputs)
+        || !program.createKernel(kernelName, newStage.kernel)) {
+        return false;
+    }
+    cl_uint arg = 0;
+    for (auto const &stageBuffers : { &inputs, &outputs }) {
+        for (auto const &buffer : *stageBuffers) {
+            if (!newStage.kernel.setArg(arg++, getBuffer(buffer))) {
+                return false;
+            }
+        }
+    }
+    stage = stages.size();
+    stages.push_back(newStage);
+    return true;
+}
+
+const bool Pipeline::addMap(const std::string &kernelName, const std::string &functionName,
+                            const PipelineBufferId &input, const PipelineBufferId &output,
+                            const std::size_t &count, PipelineStageId &stage)
+{
+    if (!addKernel(kernelName, { input }, { output }, count, stage)) {
+        return false;
+    }
+    stages[stage].function = functionName;
+    return stages[stage].kernel.setArg(2, static_cast<cl_ulong>(count));
+}
+
+Kernel &Pipeline::getKernel(const PipelineStageId &stage)
+{
+    return stages[stage].kernel;
+}
+
+const bool Pipeline::fuse(std::size_t &fusedCount)
+{
+    fusedCount = 0;
+    fusedKernels.clear();
+    if (!valid) {
+        return false;
+    }
+
+    // One kernel per chain that reads the input of its first map and writes the output of its
+    // last map
+    std::ostringstream source;
+    source << "// Fused maps of clrt::Pipeline\n";
+    for (std::size_t first = 0; first < stages.size(); first++) {
+        const std::size_t stageCount = getFusableCount(first);
+        if (stageCount < 2) {
+            continue;
+        }
+        FusedKernel fusedKernel;
+        fusedKernel.firstStage = first;
+        fusedKernel.stageCount = stageCount;
+        fusedKernels.push_back(fusedKernel);
+        source << "\nvoid kernel pipeline_fused_" << fusedCount++
+               << "(global const uint* input, global uint* output, const ulong count) {\n"
+               << "    const ulong index = get_global_id(0);\n"
+               << "    if (index < count) {\n"
+               << "        uint value = input[index];\n";
+        for (std::size_t stage = first; stage < first + stageCount; stage++) {
+            source << "        value = " << stages[stage].function << "(value);\n";
+        }
+        source << "        output[index] = value;\n"
+               << "    }\n"
+               << "}\n";
+        first += stageCount - 1;
+    }
+    if (fusedKernels.empty()) {
+        return true;
+    }
+
+    // The file name depends on the source, so every fusion is built (and cached) once
+    const std::string fusedSource = source.str();
+    std::ostringstream fileName;
+    fileName << "pipeline_" << std::hex << std::hash<std::string>()(fusedSource) << ".cl";
+    std::vector<std::string> fusedSourceFiles = sourceFiles;
+    fusedSourceFiles.push_back(fileName.str());
+    Program fusedProgram;
+    if (!runtime.addGeneratedKernelFile(fileName.str(), fusedSource)
+        || !runtime.buildSpecializedProgram(device, fusedSourceFiles, specialization,
+                                            fusedProgram)) {
+        fusedKernels.clear();
+        return false;
+    }
+    for (std::size_t i = 0; i < fusedKernels.size(); i++) {
+        FusedKernel &fusedKernel = fusedKernels[i];
+        const Stage &firstStage = stages[fusedKernel.firstStage];
+        const Stage &lastStage = stages[fusedKernel.firstStage + fusedKernel.stageCount - 1];
+        if (!fusedProgram.createKernel("pipeline_fused_" + std::to_string(i), fusedKernel.kernel)
+            || !fusedKernel.kernel.setArg(0, getBuffer(firstStage.inputs[0]))
+            || !fusedKernel.kernel.setArg(1, getBuffer(lastStage.outputs[0]))
+            || !fusedKernel.kernel.setArg(2, static_cast<cl_ulong>(firstStage.globalSize))) {
+            fusedKernels.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+const bool Pipeline::run(const bool &fused)
+{
+    lastLaunches.clear();
+    const bool fuseMaps = fused && !fusedKernels.empty();
+    if (!valid) {
+        return false;
+    }
+    auto fusedKernel = fusedKernels.begin();
+    for (std::size_t stage = 0; stage < stages.size(); stage++) {
+        LaunchEvent launchEvent;
+        Kernel *kernel = &stages[stage].kernel;
+        launchEvent.launch.name = stages[stage].name;
+        launchEvent.launch.stageCount = 1;
+        launchEvent.launch.bytes = getStageBytes(stages[stage]);
+        if (fuseMaps && fusedKernel != fusedKernels.end() && fusedKernel->firstStage == stage) {
+            // Only the input of the first and the output of the last map are in global memory
+            kernel = &fusedKernel->kernel;
+            launchEvent.launch.name = "fused";
+            launchEvent.launch.stageCount = fusedKernel->stageCount;
+            for (std::size_t i = 0; i < fusedKernel->stageCount; i++) {
+                launchEvent.launch.name += (i == 0 ? " " : "+") + stages[stage + i].name;
+            }
+            launchEvent.launch.bytes = 2 * stages[stage].globalSize * sizeof(cl_uint);
+            stage += fusedKernel->stageCount - 1;
+            fusedKernel++;
+        }
+        if (!kernel->enqueue(cl::NDRange(stages[stage].globalSize), cl::NullRange, nullptr,
+                             &launchEvent.event)) {
+            return false;
+        }
+        lastLaunches.push_back(launchEvent);
+    }
+    return true;
+}
+
+const bool Pipeline::getLastStatistics(PipelineStatistics &statistics) const
+{
+    statistics = PipelineStatistics();
+    if (lastLaunches.empty()) {
+        return false;
+    }
+    const cl_int err = lastLaunches.back().event.wait();
+    if (err != CL_SUCCESS) {
+        reportError("Pipeline: The last run failed", err);
+        return false;
+    }
+    for (auto const &launchEvent : lastLaunches) {
+        PipelineLaunch launch = launchEvent.launch;
+        launch.durationNs = getEventDurationNs(launchEvent.event);
+        statistics.deviceBytes += launch.bytes;
+        statistics.launches.push_back(launch);
+    }
+    statistics.durationNs =
+        lastLaunches.back().event.getProfilingInfo<CL_PROFILING_COMMAND_END>()
+        - lastLaunches.front().event.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+
+    // Buffers that a stage writes and a later stage reads would be read back after the first
+    // and written again before the second stage
+    for (std::size_t buffer = 0; buffer < buffers.size(); buffer++) {
+        bool written = false;
+        bool intermediate = false;
+        for (auto const &stage : stages) {
+            const auto &inputs = stage.inputs;
+            intermediate |= written && std::find(inputs.begin(), inputs.end(), buffer)
+                            != inputs.end();
+            written |= std::find(stage.outputs.begin(), stage.outputs.end(), buffer)
+                       != stage.outputs.end();
+        }
+        if (intermediate) {
+            statistics.savedTransferBytes += 2 * buffers[buffer].getSize();
+        }
+    }
+    uint64_t unfusedBytes = 0;
+    for (auto const &stage : stages) {
+        unfusedBytes += getStageBytes(stage);
+    }
+    statistics.savedDeviceBytes = unfusedBytes - statistics.deviceBytes;
+    return true;
+}
+
+const bool Pipeline::checkBuffers(const std::vector<PipelineBufferId> &buffers) const
+{
+    for (auto const &buffer : buffers) {
+        if (buffer >= this->buffers.size()) {
+            reportError("Pipeline: The buffer " + std::to_string(buffer) + " does not exist");
+            return false;
+        }
+    }
+    return true;
+}
+
+const uint64_t Pipeline::getStageBytes(const Stage &stage) const
+{
+    if (!stage.function.empty()) {
+        return 2 * stage.globalSize * sizeof(cl_uint);
+    }
+    uint64_t bytes = 0;
+    for (auto const &stageBuffers : { &stage.inputs, &stage.outputs }) {
+        for (auto const &buffer : *stageBuffers) {
+            bytes += buffers[buffer].getSize();
+        }
+    }
+    return bytes;
+}
+
+const std::size_t Pipeline::getUseCount(const PipelineBufferId &buffer) const
+{
+    std::size_t useCount = 0;
+    for (auto const &stage : stages) {
+        useCount += std::count(stage.inputs.begin(), stage.inputs.end(), buffer);
+        useCount += std::count(stage.outputs.begin(), stage.outputs.end(), buffer);
+    }
+    return useCount;
+}
+
+const std::size_t Pipeline::getFusableCount(const std::size_t &firstStage) const
+{
+    if (stages[firstStage].function.empty()) {
+        return 0;
+    }
+    // The next map has to read the output of the previous one (with the same count) and
+    // nothing else may use the intermediate buffer
+    std::size_t stageCount = 1;
+    for (std::size_t stage = firstStage + 1; stage < stages.size(); stage++) {
+        const Stage &previous = stages[stage - 1];
+        const Stage &next = stages[stage];
+        if (next.function.empty() || next.inputs[0] != previous.outputs[0]
+            || next.globalSize != previous.globalSize || next.outputs[0] == previous.outputs[0]
+            || getUseCount(previous.outputs[0]) != 2) {
+            break;
+        }
+        stageCount++;
+    }
+    return stageCount;
+}
+
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+// Include project headers
+#include "runtime.hpp"
+
+// Include stl libraries
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace clrt {
+
+// Identifiers of the buffers and stages of a pipeline
+typedef std::size_t PipelineBufferId;
+typedef std::size_t PipelineStageId;
+
+// Launch of a pipeline run (a fused kernel covers multiple stages)
+struct PipelineLaunch {
+    std::string name;
+    std::size_t stageCount = 0;
+    uint64_t durationNs = 0;
+    // Bytes that the launch reads from and writes to global memory
+    uint64_t bytes = 0;
+};
+
+// Times and memory traffic of a pipeline run
+struct PipelineStatistics {
+    std::vector<PipelineLaunch> launches;
+    // From the start of the first to the end of the last launch
+    uint64_t durationNs = 0;
+    uint64_t deviceBytes = 0;
+    // Bytes of the intermediate buffers that running one kernel at a time with host round trips
+    // would read back and write again
+    uint64_t savedTransferBytes = 0;
+    // Global memory traffic of the intermediate values that the fused kernels keep in registers
+    uint64_t savedDeviceBytes = 0;
+};
+
+// Chain of kernels of one program whose intermediate buffers stay on the device: The stages are
+// enqueued one after the other into the command queue of the device context, the host only
+// writes the inputs and reads the outputs of the pipeline
+//
+// Map stages are element-wise kernels that apply a function of the program
+// (uint function(const uint)) to every element, consecutive maps can be replaced by one
+// generated kernel that calls their functions one after the other (the intermediate buffers of
+// fused maps are not written, so they must not be used by other stages)
+// The stages are enqueued without waiting, an instance must not be used by multiple threads at
+// the same time
+class Pipeline
+{
+public:
+    // The fused kernels are built from the same source files and constants
+    Pipeline(Runtime &runtime, const cl::Device &device,
+             const std::vector<std::string> &sourceFiles,
+             const Specialization &specialization = Specialization());
+
+    const bool isValid() const;
+
+    // Device buffer of the buffer pool of the device (the reference stays valid)
+    const bool addBuffer(const std::size_t &size, PipelineBufferId &buffer);
+    cl::Buffer &getBuffer(const PipelineBufferId &buffer);
+
+    // Kernel with one work item per element whose first arguments are the input and the output
+    // buffers (in this order), further arguments can be set with getKernel
+    const bool addKernel(const std::string &kernelName, const std::vector<PipelineBufferId> &inputs,
+                         const std::vector<PipelineBufferId> &outputs,
+                         const std::size_t &globalSize, PipelineStageId &stage);
+    // Map kernel (input, output, count) that applies the function to count uints
+    const bool addMap(const std::string &kernelName, const std::string &functionName,
+                      const PipelineBufferId &input, const PipelineBufferId &output,
+                      const std::size_t &count, PipelineStageId &stage);
+    Kernel &getKernel(const PipelineStageId &stage);
+
+    // Generate and build one kernel for every chain of consecutive maps whose intermediate
+    // buffers are only used by the chain (the fused kernel count can be 0)
+    const bool fuse(std::size_t &fusedCount);
+    // Enqueue all stages (the fused kernels instead of their maps if fused is set)
+    const bool run(const bool &fused = true);
+    // Wait for the last run and get its times
+    const bool getLastStatistics(PipelineStatistics &statistics) const;
+
+private:
+    struct Stage {
+        std::string name;
+        Kernel kernel;
+        std::vector<PipelineBufferId> inputs;
+        std::vector<PipelineBufferId> outputs;
+        std::size_t globalSize = 0;
+        // Function of a map stage (empty for other kernels)
+        std::string function;
+    };
+    struct FusedKernel {
+        std::size_t firstStage = 0;
+        std::size_t stageCount = 0;
+        Kernel kernel;
+    };
+    struct LaunchEvent {
+        PipelineLaunch launch;
+        cl::Event event;
+    };
+
+    const bool checkBuffers(const std::vector<PipelineBufferId> &buffers) const;
+    const uint64_t getStageBytes(const Stage &stage) const;
+    // Number of stages that use the buffer as input or output
+    const std::size_t getUseCount(const PipelineBufferId &buffer) const;
+    // Number of consecutive maps from the first stage on that can be fused (less than 2 = none)
+    const std::size_t getFusableCount(const std::size_t &firstStage) const;
+
+    Runtime &runtime;
+    cl::Device device;
+    std::vector<std::string> sourceFiles;
+    Specialization specialization;
+    Program program;
+    bool valid = false;
+    // Deques keep the references of getBuffer and getKernel valid
+    std::deque<PooledBuffer> buffers;
+    std::deque<Stage> stages;
+    std::vector<FusedKernel> fusedKernels;
+    std::vector<LaunchEvent> lastLaunches;
+};
+
+}
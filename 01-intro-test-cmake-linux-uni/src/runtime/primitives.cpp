@@ -0,0 +1,237 @@
+#include "primitives.hpp"
+
+// Include project headers
+#include "trace.hpp"
+
+// Include stl libraries
+#include <algorithm>
+#include <string>
+
+namespace {
+
+// Work group size of the primitives (rounded down to a power of two if the kernels allow less)
+constexpr std::size_t maxLocalSize = 256;
+// Work groups of the grid stride kernels (compaction and histogram) per compute unit
+constexpr std::size_t groupsPerComputeUnit = 4;
+
+const std::size_t getPowerOfTwoLocalSize(const cl::Device &device,
+                                         const std::vector<clrt::Kernel *> &kernels)
+{
+    std::size_t limit = maxLocalSize;
+    for (auto const &kernel : kernels) {
+        limit = std::min(limit,
+                         kernel->get().getWorkGroupInfo<CL_KERNEL_WORK_GROUP_SIZE>(device));
+    }
+    std::size_t localSize = 1;
+    while (localSize * 2 <= limit) {
+        localSize *= 2;
+    }
+    return localSize;
+}
+
+}
+
+namespace clrt {
+
+Primitives::Primitives(Runtime &runtime, const cl::Device &device)
+    : deviceContext(runtime.getDeviceContext(device))
+{
+    Program program;
+    if (!runtime.buildProgram(device, { "primitives.cl", "scan_helper.cl" }, {}, program)
+        || !program.createKernel("scan_blocks", scanBlocks)
+        || !program.createKernel("scan_add_offsets", scanAddOffsets)
+        || !program.createKernel("compact_flags", compactFlags)
+        || !program.createKernel("compact_scatter", compactScatter)
+        || !program.createKernel("histogram_int", histogramInt)) {
+        return;
+    }
+    scanLocalSize = getPowerOfTwoLocalSize(device, { &scanBlocks, &scanAddOffsets });
+    localSize = getPowerOfTwoLocalSize(device, { &compactFlags, &compactScatter, &histogramInt });
+    groupCount = std::max<std::size_t>(1, device.getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>()
+                                       * groupsPerComputeUnit);
+    valid = true;
+}
+
+const bool Primitives::isValid() const
+{
+    return valid;
+}
+
+const uint64_t Primitives::getLastDurationNs() const
+{
+    if (firstEvent() == nullptr || lastEvent() == nullptr) {
+        return 0;
+    }
+    return lastEvent.getProfilingInfo<CL_PROFILING_COMMAND_END>()
+           - firstEvent.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+}
+
+const bool Primitives::exclusiveScan(const cl::Buffer &input, const cl::Buffer &output,
+                                     const std::size_t &count)
+{
+    beginPrimitive();
+    return valid && scan(input, output, count, false, 0);
+}
+
+const bool Primitives::inclusiveScan(const cl::Buffer &input, const cl::Buffer &output,
+                                     const std::size_t &count)
+{
+    beginPrimitive();
+    return valid && scan(input, output, count, true, 0);
+}
+
+const bool Primitives::compact(const cl::Buffer &input, const std::size_t &count,
+                               const CompactPredicate &predicate, const cl_int &operand,
+                               const cl::Buffer &output, const cl::Buffer &outputCount)
+{
+    beginPrimitive();
+    if (!valid) {
+        return false;
+    }
+    if (count == 0) {
+        cl::Event event;
+        const cl_int err = deviceContext.queue.enqueueFillBuffer(outputCount, cl_uint(0), 0,
+                                                                 sizeof(cl_uint), nullptr,
+                                                                 &event);
+        if (err != CL_SUCCESS) {
+            reportError("CommandQueue::enqueueFillBuffer failed", err);
+            return false;
+        }
+        traceCommand("clear compaction count", &event);
+        firstEvent = lastEvent = event;
+        return true;
+    }
+    // The flags are scanned in place into the positions
+    const std::size_t global = std::min(groupCount, (count + localSize - 1) / localSize)
+                               * localSize;
+    const cl_int predicateValue = static_cast<cl_int>(predicate);
+    return reserve(positions, positionCapacity, count)
+           && compactFlags.setArg(0, input) && compactFlags.setArg(1, positions)
+           && compactFlags.setArg(2, static_cast<cl_ulong>(count))
+           && compactFlags.setArg(3, predicateValue) && compactFlags.setArg(4, operand)
+           && enqueue(compactFlags, global, localSize)
+           && scan(positions, positions, count, false, 0)
+           && compactScatter.setArg(0, input) && compactScatter.setArg(1, positions)
+           && compactScatter.setArg(2, output) && compactScatter.setArg(3, outputCount)
+           && compactScatter.setArg(4, static_cast<cl_ulong>(count))
+           && compactScatter.setArg(5, predicateValue) && compactScatter.setArg(6, operand)
+           && enqueue(compactScatter, global, localSize);
+}
+
+const bool Primitives::histogram(const cl::Buffer &input, const std::size_t &count,
+                                 const cl_int &minValue, const cl_int &maxValue,
+                                 const std::size_t &binCount, const cl::Buffer &bins)
+{
+    beginPrimitive();
+    if (!valid) {
+        return false;
+    }
+    const cl_ulong localMemorySize = deviceContext.device.getInfo<CL_DEVICE_LOCAL_MEM_SIZE>();
+    if (binCount == 0 || minValue >= maxValue || binCount * sizeof(cl_uint) > localMemorySize) {
+        reportError("Primitives::histogram: " + std::to_string(binCount) + " bins over ["
+                    + std::to_string(minValue) + ", " + std::to_string(maxValue)
+                    + ") are not supported by the device");
+        return false;
+    }
+    cl::Event fillEvent;
+    const cl_int err = deviceContext.queue.enqueueFillBuffer(bins, cl_uint(0), 0,
+                                                             binCount * sizeof(cl_uint), nullptr,
+                                                             &fillEvent);
+    if (err != CL_SUCCESS) {
+        reportError("CommandQueue::enqueueFillBuffer failed", err);
+        return false;
+    }
+    traceCommand("clear histogram", &fillEvent);
+    firstEvent = lastEvent = fillEvent;
+    firstCommand = false;
+    if (count == 0) {
+        return true;
+    }
+    const std::size_t global = std::min(groupCount, (count + localSize - 1) / localSize)
+                               * localSize;
+    return histogramInt.setArg(0, input)
+           && histogramInt.setArg(1, static_cast<cl_ulong>(count))
+           && histogramInt.setArg(2, bins)
+           && histogramInt.setArg(3, static_cast<cl_uint>(binCount))
+           && histogramInt.setArg(4, minValue) && histogramInt.setArg(5, maxValue)
+           && histogramInt.setArg(6, cl::Local(binCount * sizeof(cl_uint)))
+           && enqueue(histogramInt, global, localSize);
+}
+
+const bool Primitives::scan(const cl::Buffer &input, const cl::Buffer &output,
+                            const std::size_t &count, const bool &inclusive,
+                            const std::size_t &level)
+{
+    if (count == 0) {
+        return true;
+    }
+    const std::size_t blockSize = 2 * scanLocalSize;
+    const std::size_t blockCount = (count + blockSize - 1) / blockSize;
+    if (blockSums.size() <= level) {
+        blockSums.resize(level + 1);
+        blockSumCapacities.resize(level + 1, 0);
+    }
+    if (!reserve(blockSums[level], blockSumCapacities[level], blockCount)) {
+        return false;
+    }
+    // The kernel arguments are copied when a kernel is enqueued, so the recursion can set them
+    // again for the next level (the handle is copied because the recursion can grow the levels)
+    const cl::Buffer sums = blockSums[level];
+    if (!scanBlocks.setArg(0, input) || !scanBlocks.setArg(1, output)
+        || !scanBlocks.setArg(2, sums) || !scanBlocks.setArg(3, static_cast<cl_ulong>(count))
+        || !scanBlocks.setArg(4, static_cast<cl_uint>(inclusive ? 1 : 0))
+        || !scanBlocks.setArg(5, cl::Local(blockSize * sizeof(cl_uint)))
+        || !enqueue(scanBlocks, blockCount * scanLocalSize, scanLocalSize)) {
+        return false;
+    }
+    if (blockCount == 1) {
+        return true;
+    }
+    // The exclusive scan of the block sums are the offsets of the blocks
+    return scan(sums, sums, blockCount, false, level + 1)
+           && scanAddOffsets.setArg(0, output) && scanAddOffsets.setArg(1, sums)
+           && scanAddOffsets.setArg(2, static_cast<cl_ulong>(count))
+           && enqueue(scanAddOffsets, blockCount * scanLocalSize, scanLocalSize);
+}
+
+const bool Primitives::reserve(cl::Buffer &buffer, std::size_t &capacity,
+                               const std::size_t &count)
+{
+    if (count <= capacity) {
+        return true;
+    }
+    cl_int err = CL_SUCCESS;
+    buffer = cl::Buffer(deviceContext.context, CL_MEM_READ_WRITE, count * sizeof(cl_uint),
+                        nullptr, &err);
+    if (err != CL_SUCCESS) {
+        reportError("Buffer::Buffer failed", err);
+        capacity = 0;
+        return false;
+    }
+    capacity = count;
+    return true;
+}
+
+const bool Primitives::enqueue(Kernel &kernel, const std::size_t &global,
+                               const std::size_t &local)
+{
+    cl::Event event;
+    if (!kernel.enqueue(cl::NDRange(global), cl::NDRange(local), nullptr, &event)) {
+        return false;
+    }
+    if (firstCommand) {
+        firstEvent = event;
+        firstCommand = false;
+    }
+    lastEvent = event;
+    return true;
+}
+
+void Primitives::beginPrimitive()
+{
+    firstCommand = true;
+    firstEvent = cl::Event();
+    lastEvent = cl::Event();
+}
+
+}
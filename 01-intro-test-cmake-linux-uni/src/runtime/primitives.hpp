@@ -0,0 +1,90 @@
+#pragma once
+
+// Include project headers
+#include "runtime.hpp"
+
+// Include stl libraries
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace clrt {
+
+// Elements that are kept by a compaction (element <predicate> operand)
+enum class CompactPredicate : cl_int {
+    Less = 0,
+    LessEqual = 1,
+    Greater = 2,
+    GreaterEqual = 3,
+    Equal = 4,
+    NotEqual = 5
+};
+
+// Device primitives of 32 bit integer buffers (the kernels are in "primitives.cl" that is linked
+// with "scan_helper.cl" in the kernel directory of the runtime): Scans, compactions and
+// histograms of buffers of any size whose results stay on the device, so that pipelines of
+// kernels never need a round trip through the host
+//
+// Scans add uint values (int values give the same bits), positions and counts are 32 bit
+// The primitives are enqueued into the command queue of the device context without waiting
+// (after all commands that were enqueued before), an instance must not be used by multiple
+// threads at the same time
+class Primitives
+{
+public:
+    Primitives(Runtime &runtime, const cl::Device &device);
+
+    const bool isValid() const;
+    // Device time of the last primitive (from the start of its first to the end of its last
+    // command, only valid after the queue finished it)
+    const uint64_t getLastDurationNs() const;
+
+    // Prefix sums of the input without/with the element itself (the output can be the input)
+    const bool exclusiveScan(const cl::Buffer &input, const cl::Buffer &output,
+                             const std::size_t &count);
+    const bool inclusiveScan(const cl::Buffer &input, const cl::Buffer &output,
+                             const std::size_t &count);
+    // Copy the elements that fulfill the predicate (in their order) into the output and their
+    // number into outputCount (one cl_uint) that can be read by later kernels
+    const bool compact(const cl::Buffer &input, const std::size_t &count,
+                       const CompactPredicate &predicate, const cl_int &operand,
+                       const cl::Buffer &output, const cl::Buffer &outputCount);
+    // Count the elements in binCount bins of the same width over [minValue, maxValue) into bins
+    // (binCount cl_uints, the bins have to fit into the local memory of the device)
+    const bool histogram(const cl::Buffer &input, const std::size_t &count,
+                         const cl_int &minValue, const cl_int &maxValue,
+                         const std::size_t &binCount, const cl::Buffer &bins);
+
+private:
+    // Scan one level and the levels of its block sums recursively
+    const bool scan(const cl::Buffer &input, const cl::Buffer &output, const std::size_t &count,
+                    const bool &inclusive, const std::size_t &level);
+    // Scratch buffer of at least count cl_uints (grows if it is too small)
+    const bool reserve(cl::Buffer &buffer, std::size_t &capacity, const std::size_t &count);
+    // Enqueue and remember the events of the first and the last command of a primitive
+    const bool enqueue(Kernel &kernel, const std::size_t &global, const std::size_t &local);
+    void beginPrimitive();
+
+    DeviceContext &deviceContext;
+    bool valid = false;
+    // Work group size of the scans (a block has 2 * scanLocalSize elements) and the grid stride
+    // kernels
+    std::size_t scanLocalSize = 0;
+    std::size_t localSize = 0;
+    std::size_t groupCount = 0;
+    // Block sums of every level of the scans and the positions of the compaction
+    std::vector<cl::Buffer> blockSums;
+    std::vector<std::size_t> blockSumCapacities;
+    cl::Buffer positions;
+    std::size_t positionCapacity = 0;
+    bool firstCommand = false;
+    cl::Event firstEvent;
+    cl::Event lastEvent;
+    Kernel scanBlocks;
+    Kernel scanAddOffsets;
+    Kernel compactFlags;
+    Kernel compactScatter;
+    Kernel histogramInt;
+};
+
+}
@@ -0,0 +1,186 @@
+#include "radix_sort.hpp"
+
+// Include stl libraries
+#include <algorithm>
+#include <limits>
+#include <string>
+
+namespace {
+
+constexpr unsigned int radixBits = 4;
+constexpr std::size_t radixSize = 1 << radixBits;
+// Work group size of the sort (rounded down to a power of two if the kernels allow less)
+constexpr std::size_t maxLocalSize = 256;
+// The digit counts of a chunk are scanned in 16 bit halves (see radix_sort.cl)
+static_assert(2 * maxLocalSize < (1 << 16), "The chunks of the radix sort are too big");
+// Every work group sorts a contiguous block chunk by chunk, so there have to be enough of them
+// to fill the device
+constexpr std::size_t groupsPerComputeUnit = 16;
+
+}
+
+namespace clrt {
+
+RadixSort::RadixSort(Runtime &runtime, const cl::Device &device, const RadixKeyType &keyType)
+    : deviceContext(runtime.getDeviceContext(device)), primitives(runtime, device)
+{
+    const bool wideKeys = keyType == RadixKeyType::UInt64 || keyType == RadixKeyType::Int64;
+    const bool signedKeys = keyType == RadixKeyType::Int32 || keyType == RadixKeyType::Int64;
+    keySize = wideKeys ? sizeof(cl_ulong) : sizeof(cl_uint);
+    const Specialization constants = Specialization()
+                                     .set("KEY_BITS", static_cast<cl_uint>(8 * keySize))
+                                     .set("SIGNED_KEYS", signedKeys);
+    Program program;
+    if (!primitives.isValid()
+        || !runtime.buildSpecializedProgram(device, { "radix_sort.cl", "scan_helper.cl" },
+                                            constants, program)
+        || !program.createKernel("radix_histogram", histogram)
+        || !program.createKernel("radix_scatter", scatter)
+        || !program.createKernel("radix_scatter_pairs", scatterPairs)) {
+        return;
+    }
+    std::size_t limit = maxLocalSize;
+    for (auto kernel : { &histogram, &scatter, &scatterPairs }) {
+        limit = std::min(limit,
+                         kernel->get().getWorkGroupInfo<CL_KERNEL_WORK_GROUP_SIZE>(device));
+    }
+    localSize = 1;
+    while (localSize * 2 <= limit) {
+        localSize *= 2;
+    }
+    // Every digit needs a work item to clear and write its count
+    if (localSize < radixSize) {
+        reportError("RadixSort: The device does not support work groups of "
+                    + std::to_string(radixSize) + " work items");
+        return;
+    }
+    maxGroupCount = std::max<std::size_t>(1, device.getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>()
+                                          * groupsPerComputeUnit);
+    // The values (cl_uint) are never bigger than the keys
+    const cl_ulong maxAllocationSize = device.getInfo<CL_DEVICE_MAX_MEM_ALLOC_SIZE>();
+    maxCount = static_cast<std::size_t>(std::min<cl_ulong>(maxAllocationSize / keySize,
+                                                           std::numeric_limits<cl_uint>::max()));
+    valid = true;
+}
+
+const bool RadixSort::isValid() const
+{
+    return valid;
+}
+
+const uint64_t RadixSort::getLastDurationNs() const
+{
+    if (firstEvent() == nullptr || lastEvent() == nullptr) {
+        return 0;
+    }
+    return lastEvent.getProfilingInfo<CL_PROFILING_COMMAND_END>()
+           - firstEvent.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+}
+
+const std::size_t RadixSort::getMaxCount() const
+{
+    return maxCount;
+}
+
+const bool RadixSort::sort(const cl::Buffer &keys, const std::size_t &count)
+{
+    return run(keys, nullptr, count);
+}
+
+const bool RadixSort::sortPairs(const cl::Buffer &keys, const cl::Buffer &values,
+                                const std::size_t &count)
+{
+    return run(keys, &values, count);
+}
+
+const bool RadixSort::run(const cl::Buffer &keys, const cl::Buffer *values,
+                          const std::size_t &count)
+{
+    firstEvent = cl::Event();
+    lastEvent = cl::Event();
+    if (!valid) {
+        return false;
+    }
+    if (count > std::numeric_limits<cl_uint>::max()) {
+        reportError("RadixSort: " + std::to_string(count) + " keys are more than the 32 bit "
+                    "output positions can address");
+        return false;
+    }
+    if (count > maxCount) {
+        reportError("RadixSort: The temporary buffer of " + std::to_string(count) + " keys is "
+                    "bigger than the device max mem alloc size");
+        return false;
+    }
+    if (count <= 1) {
+        return true;
+    }
+    // Blocks of whole chunks (2 * local size keys) per work group
+    const std::size_t chunkSize = 2 * localSize;
+    std::size_t groupCount = std::min(maxGroupCount, (count + chunkSize - 1) / chunkSize);
+    std::size_t blockSize = (count + groupCount - 1) / groupCount;
+    blockSize = (blockSize + chunkSize - 1) / chunkSize * chunkSize;
+    groupCount = (count + blockSize - 1) / blockSize;
+    const std::size_t histogramCount = radixSize * groupCount;
+    if (!reserve(histograms, histogramCapacity, histogramCount * sizeof(cl_uint))
+        || !reserve(temporaryKeys, temporaryKeyCapacity, count * keySize)
+        || (values != nullptr
+            && !reserve(temporaryValues, temporaryValueCapacity, count * sizeof(cl_uint)))) {
+        return false;
+    }
+
+    Kernel &scatterKernel = values != nullptr ? scatterPairs : scatter;
+    const cl_uint offsetArg = values != nullptr ? 4 : 2;
+    cl::Buffer sourceKeys = keys;
+    cl::Buffer targetKeys = temporaryKeys;
+    cl::Buffer sourceValues = values != nullptr ? *values : cl::Buffer();
+    cl::Buffer targetValues = temporaryValues;
+    for (cl_uint shift = 0; shift < 8 * keySize; shift += radixBits) {
+        if (!histogram.setArg(0, sourceKeys) || !histogram.setArg(1, histograms)
+            || !histogram.setArg(2, static_cast<cl_ulong>(count))
+            || !histogram.setArg(3, static_cast<cl_ulong>(blockSize))
+            || !histogram.setArg(4, shift)
+            || !enqueue(histogram, groupCount, shift == 0 ? &firstEvent : nullptr)
+            || !primitives.exclusiveScan(histograms, histograms, histogramCount)) {
+            return false;
+        }
+        if (!scatterKernel.setArg(0, sourceKeys) || !scatterKernel.setArg(1, targetKeys)
+            || (values != nullptr && (!scatterKernel.setArg(2, sourceValues)
+                                      || !scatterKernel.setArg(3, targetValues)))
+            || !scatterKernel.setArg(offsetArg, histograms)
+            || !scatterKernel.setArg(offsetArg + 1, static_cast<cl_ulong>(count))
+            || !scatterKernel.setArg(offsetArg + 2, static_cast<cl_ulong>(blockSize))
+            || !scatterKernel.setArg(offsetArg + 3, shift)
+            || !scatterKernel.setArg(offsetArg + 4, cl::Local(chunkSize * sizeof(cl_uint)))
+            || !enqueue(scatterKernel, groupCount, &lastEvent)) {
+            return false;
+        }
+        std::swap(sourceKeys, targetKeys);
+        std::swap(sourceValues, targetValues);
+    }
+    return true;
+}
+
+const bool RadixSort::reserve(cl::Buffer &buffer, std::size_t &capacity,
+                              const std::size_t &size)
+{
+    if (size <= capacity) {
+        return true;
+    }
+    cl_int err = CL_SUCCESS;
+    buffer = cl::Buffer(deviceContext.context, CL_MEM_READ_WRITE, size, nullptr, &err);
+    if (err != CL_SUCCESS) {
+        reportError("Buffer::Buffer failed", err);
+        capacity = 0;
+        return false;
+    }
+    capacity = size;
+    return true;
+}
+
+const bool RadixSort::enqueue(Kernel &kernel, const std::size_t &groups, cl::Event *event)
+{
+    return kernel.enqueue(cl::NDRange(groups * localSize), cl::NDRange(localSize), nullptr,
+                          event);
+}
+
+}
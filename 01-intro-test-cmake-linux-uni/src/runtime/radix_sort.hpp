@@ -0,0 +1,77 @@
+#pragma once
+
+// Include project headers
+#include "primitives.hpp"
+#include "runtime.hpp"
+
+// Include stl libraries
+#include <cstddef>
+#include <cstdint>
+
+namespace clrt {
+
+// Type of the keys of a radix sort
+enum class RadixKeyType {
+    UInt32,
+    Int32,
+    UInt64,
+    Int64
+};
+
+// Device wide least significant digit radix sort of key buffers and key-value buffers (the
+// kernels are in "radix_sort.cl" that is linked with "scan_helper.cl" in the kernel directory of
+// the runtime)
+//
+// Every pass of 4 bits counts the digits per work group, scans the counts with the device
+// primitives and scatters the keys stably, so the whole sort stays on the device
+// The keys (and values) are sorted in place with a temporary buffer of the same size (the
+// number of passes is even, so the last pass writes into the original buffer), at most 2^32 - 1
+// keys that fit into one allocation of the device can be sorted
+// The sorts are enqueued into the command queue of the device context without waiting, an
+// instance must not be used by multiple threads at the same time
+class RadixSort
+{
+public:
+    RadixSort(Runtime &runtime, const cl::Device &device,
+              const RadixKeyType &keyType = RadixKeyType::UInt32);
+
+    const bool isValid() const;
+    // Device time of the last sort (from the start of its first to the end of its last command,
+    // only valid after the queue finished it)
+    const uint64_t getLastDurationNs() const;
+    // Maximum key count of a sort (the keys and the temporary buffer must not be bigger than the
+    // max mem alloc size of the device)
+    const std::size_t getMaxCount() const;
+
+    const bool sort(const cl::Buffer &keys, const std::size_t &count);
+    // The cl_uint values are moved with their keys (keys that are equal keep their order)
+    const bool sortPairs(const cl::Buffer &keys, const cl::Buffer &values,
+                         const std::size_t &count);
+
+private:
+    const bool run(const cl::Buffer &keys, const cl::Buffer *values, const std::size_t &count);
+    // Scratch buffer of at least size bytes (grows if it is too small)
+    const bool reserve(cl::Buffer &buffer, std::size_t &capacity, const std::size_t &size);
+    const bool enqueue(Kernel &kernel, const std::size_t &groups, cl::Event *event);
+
+    DeviceContext &deviceContext;
+    Primitives primitives;
+    bool valid = false;
+    std::size_t keySize = sizeof(cl_uint);
+    std::size_t localSize = 0;
+    std::size_t maxGroupCount = 0;
+    std::size_t maxCount = 0;
+    cl::Buffer histograms;
+    std::size_t histogramCapacity = 0;
+    cl::Buffer temporaryKeys;
+    std::size_t temporaryKeyCapacity = 0;
+    cl::Buffer temporaryValues;
+    std::size_t temporaryValueCapacity = 0;
+    cl::Event firstEvent;
+    cl::Event lastEvent;
+    Kernel histogram;
+    Kernel scatter;
+    Kernel scatterPairs;
+};
+
+}
@@ -0,0 +1,276 @@
+#include "reduction.hpp"
+
+// Include project headers
+#include "trace.hpp"
+
+// Include stl libraries
+#include <algorithm>
+#include <string>
+
+namespace {
+
+// Work group size of the reductions (rounded down to a power of two if the kernel allows less)
+constexpr std::size_t maxLocalSize = 256;
+// Enough work groups to fill every compute unit multiple times, every work group accumulates
+// many elements in private memory before it reduces them
+constexpr std::size_t groupsPerComputeUnit = 4;
+
+// Subgroup functions are available with cl_intel_subgroups (OpenCL C 1.2) or cl_khr_subgroups
+// (OpenCL C 2.0 and later)
+const bool supportsSubgroups(const cl::Device &device, bool &needsOpenClC20)
+{
+    const std::string extensions = device.getInfo<CL_DEVICE_EXTENSIONS>();
+    needsOpenClC20 = false;
+    if (extensions.find("cl_intel_subgroups") != std::string::npos) {
+        return true;
+    }
+    const std::string openClCVersion = device.getInfo<CL_DEVICE_OPENCL_C_VERSION>();
+    if (extensions.find("cl_khr_subgroups") != std::string::npos
+        && openClCVersion.compare(0, 11, "OpenCL C 1.") != 0) {
+        needsOpenClC20 = true;
+        return true;
+    }
+    return false;
+}
+
+}
+
+namespace clrt {
+
+Reduction::Reduction(Runtime &runtime, const cl::Device &device)
+    : deviceContext(runtime.getDeviceContext(device))
+{
+    bool needsOpenClC20 = false;
+    subgroups = supportsSubgroups(device, needsOpenClC20);
+    Specialization constants;
+    if (subgroups) {
+        constants.set("USE_SUBGROUPS", true);
+    }
+    Program program;
+    if (!runtime.buildSpecializedProgram(device, { "reduction.cl" }, constants, program,
+                                         needsOpenClC20 ? "-cl-std=CL2.0" : "")
+        || !program.createKernel("reduce_sum_int", sumInt)
+        || !program.createKernel("reduce_sum_long", sumLong)
+        || !program.createKernel("reduce_min_int", minInt)
+        || !program.createKernel("reduce_max_int", maxInt)
+        || !program.createKernel("count_mismatches_int", mismatchesInt)
+        || !program.createKernel("count_index_mismatches_int", indexMismatchesInt)
+        || !program.createKernel("argmin_int", argminInt)
+        || !program.createKernel("argmin_indexed_int", argminIndexedInt)) {
+        return;
+    }
+
+    maxGroupCount = std::max<std::size_t>(1, device.getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>()
+                                          * groupsPerComputeUnit);
+    cl_int err = CL_SUCCESS;
+    partialValues = cl::Buffer(deviceContext.context, CL_MEM_READ_WRITE,
+                               maxGroupCount * sizeof(cl_long), nullptr, &err);
+    if (err == CL_SUCCESS) {
+        partialIndices = cl::Buffer(deviceContext.context, CL_MEM_READ_WRITE,
+                                    maxGroupCount * sizeof(cl_long), nullptr, &err);
+    }
+    if (err == CL_SUCCESS) {
+        results = cl::Buffer(deviceContext.context, CL_MEM_READ_WRITE, sizeof(cl_long), nullptr,
+                             &err);
+    }
+    if (err == CL_SUCCESS) {
+        resultIndex = cl::Buffer(deviceContext.context, CL_MEM_READ_WRITE, sizeof(cl_long),
+                                 nullptr, &err);
+    }
+    if (err != CL_SUCCESS) {
+        reportError("Buffer::Buffer failed", err);
+        return;
+    }
+    valid = true;
+}
+
+const bool Reduction::isValid() const
+{
+    return valid;
+}
+
+const bool Reduction::usesSubgroups() const
+{
+    return subgroups;
+}
+
+const uint64_t Reduction::getLastDurationNs() const
+{
+    return lastDurationNs;
+}
+
+const bool Reduction::sum(const cl::Buffer &input, const std::size_t &count, int64_t &result)
+{
+    cl_long value = 0;
+    if (!valid || !sumInt.setArg(0, input) || !sumInt.setArg(1, static_cast<cl_ulong>(count))
+        || !runStages(sumInt, 2, sumLong, count, sizeof(value), &value)) {
+        return false;
+    }
+    result = value;
+    return true;
+}
+
+const bool Reduction::min(const cl::Buffer &input, const std::size_t &count, int32_t &result)
+{
+    cl_int value = 0;
+    if (!valid || !minInt.setArg(0, input) || !minInt.setArg(1, static_cast<cl_ulong>(count))
+        || !runStages(minInt, 2, minInt, count, sizeof(value), &value)) {
+        return false;
+    }
+    result = value;
+    return true;
+}
+
+const bool Reduction::max(const cl::Buffer &input, const std::size_t &count, int32_t &result)
+{
+    cl_int value = 0;
+    if (!valid || !maxInt.setArg(0, input) || !maxInt.setArg(1, static_cast<cl_ulong>(count))
+        || !runStages(maxInt, 2, maxInt, count, sizeof(value), &value)) {
+        return false;
+    }
+    result = value;
+    return true;
+}
+
+const bool Reduction::countMismatches(const cl::Buffer &input, const cl::Buffer &reference,
+                                      const std::size_t &count, uint64_t &result)
+{
+    cl_long value = 0;
+    if (!valid || !mismatchesInt.setArg(0, input) || !mismatchesInt.setArg(1, reference)
+        || !mismatchesInt.setArg(2, static_cast<cl_ulong>(count))
+        || !runStages(mismatchesInt, 3, sumLong, count, sizeof(value), &value)) {
+        return false;
+    }
+    result = static_cast<uint64_t>(value);
+    return true;
+}
+
+const bool Reduction::countIndexMismatches(const cl::Buffer &input, const std::size_t &count,
+                                           const int32_t &first, uint64_t &result)
+{
+    cl_long value = 0;
+    if (!valid || !indexMismatchesInt.setArg(0, input)
+        || !indexMismatchesInt.setArg(1, static_cast<cl_ulong>(count))
+        || !indexMismatchesInt.setArg(2, static_cast<cl_int>(first))
+        || !runStages(indexMismatchesInt, 3, sumLong, count, sizeof(value), &value)) {
+        return false;
+    }
+    result = static_cast<uint64_t>(value);
+    return true;
+}
+
+const bool Reduction::argmin(const cl::Buffer &input, const std::size_t &count, int32_t &value,
+                             uint64_t &index)
+{
+    std::size_t localSize = 0;
+    std::size_t groupCount = 0;
+    if (!valid || !getLaunchSize(argminInt, argminIndexedInt, count, localSize, groupCount)) {
+        return false;
+    }
+    // The values and the indices of the partial results are in two buffers
+    cl::Event firstEvent;
+    if (!argminInt.setArg(0, input) || !argminInt.setArg(1, static_cast<cl_ulong>(count))
+        || !argminInt.setArg(2, partialValues) || !argminInt.setArg(3, partialIndices)
+        || !argminInt.setArg(4, cl::Local(localSize * sizeof(cl_int)))
+        || !argminInt.setArg(5, cl::Local(localSize * sizeof(cl_long)))
+        || !enqueue(argminInt, groupCount * localSize, localSize, &firstEvent)) {
+        return false;
+    }
+    if (!argminIndexedInt.setArg(0, partialValues) || !argminIndexedInt.setArg(1, partialIndices)
+        || !argminIndexedInt.setArg(2, static_cast<cl_ulong>(groupCount))
+        || !argminIndexedInt.setArg(3, results) || !argminIndexedInt.setArg(4, resultIndex)
+        || !argminIndexedInt.setArg(5, cl::Local(localSize * sizeof(cl_int)))
+        || !argminIndexedInt.setArg(6, cl::Local(localSize * sizeof(cl_long)))
+        || !enqueue(argminIndexedInt, localSize, localSize, nullptr)) {
+        return false;
+    }
+    cl_int resultValue = 0;
+    cl_long resultPosition = 0;
+    cl::Event indexEvent;
+    cl::Event *traceIndexEvent = getTraceEvent(nullptr, indexEvent);
+    const cl_int err = deviceContext.queue.enqueueReadBuffer(resultIndex, CL_FALSE, 0,
+                                                             sizeof(resultPosition),
+                                                             &resultPosition, nullptr,
+                                                             traceIndexEvent);
+    if (err != CL_SUCCESS) {
+        reportError("CommandQueue::enqueueReadBuffer failed", err);
+        return false;
+    }
+    traceCommand("read reduction index", traceIndexEvent);
+    // The blocking read of the value also waits for the read of the index (in order queue)
+    if (!readResult(sizeof(resultValue), &resultValue, firstEvent)) {
+        return false;
+    }
+    value = resultValue;
+    index = static_cast<uint64_t>(resultPosition);
+    return true;
+}
+
+const bool Reduction::getLaunchSize(Kernel &firstStage, Kernel &secondStage,
+                                    const std::size_t &count, std::size_t &localSize,
+                                    std::size_t &groupCount)
+{
+    const cl::Device &device = deviceContext.device;
+    const std::size_t firstLimit =
+        firstStage.get().getWorkGroupInfo<CL_KERNEL_WORK_GROUP_SIZE>(device);
+    const std::size_t secondLimit =
+        secondStage.get().getWorkGroupInfo<CL_KERNEL_WORK_GROUP_SIZE>(device);
+    const std::size_t kernelLimit = std::min(firstLimit, secondLimit);
+    // The tree reduction needs a power of two
+    localSize = 1;
+    while (localSize * 2 <= std::min(maxLocalSize, kernelLimit)) {
+        localSize *= 2;
+    }
+    groupCount = std::max<std::size_t>(1, std::min(maxGroupCount,
+                                                   (count + localSize - 1) / localSize));
+    return true;
+}
+
+const bool Reduction::runStages(Kernel &firstStage, const cl_uint &outputArg, Kernel &secondStage,
+                                const std::size_t &count, const std::size_t &valueSize,
+                                void *result)
+{
+    std::size_t localSize = 0;
+    std::size_t groupCount = 0;
+    if (!getLaunchSize(firstStage, secondStage, count, localSize, groupCount)) {
+        return false;
+    }
+    cl::Event firstEvent;
+    if (!firstStage.setArg(outputArg, partialValues)
+        || !firstStage.setArg(outputArg + 1, cl::Local(localSize * valueSize))
+        || !enqueue(firstStage, groupCount * localSize, localSize, &firstEvent)) {
+        return false;
+    }
+    if (!secondStage.setArg(0, partialValues)
+        || !secondStage.setArg(1, static_cast<cl_ulong>(groupCount))
+        || !secondStage.setArg(2, results)
+        || !secondStage.setArg(3, cl::Local(localSize * valueSize))
+        || !enqueue(secondStage, localSize, localSize, nullptr)) {
+        return false;
+    }
+    return readResult(valueSize, result, firstEvent);
+}
+
+const bool Reduction::enqueue(Kernel &kernel, const std::size_t &global, const std::size_t &local,
+                              cl::Event *event)
+{
+    return kernel.enqueue(cl::NDRange(global), cl::NDRange(local), nullptr, event);
+}
+
+const bool Reduction::readResult(const std::size_t &size, void *result,
+                                 const cl::Event &firstEvent)
+{
+    cl::Event readEvent;
+    const cl_int err = deviceContext.queue.enqueueReadBuffer(results, CL_TRUE, 0, size,
+                                                             result, nullptr, &readEvent);
+    if (err != CL_SUCCESS) {
+        reportError("CommandQueue::enqueueReadBuffer failed", err);
+        return false;
+    }
+    traceCommand("read reduction result", &readEvent);
+    lastDurationNs = readEvent.getProfilingInfo<CL_PROFILING_COMMAND_END>()
+                     - firstEvent.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+    return true;
+}
+
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+// Include project headers
+#include "runtime.hpp"
+
+// Include stl libraries
+#include <cstddef>
+#include <cstdint>
+
+namespace clrt {
+
+// Device side reductions of int buffers (the kernels are in "reduction.cl" in the kernel
+// directory of the runtime): Only the result (a few bytes) is transferred back to the host
+//
+// The reductions are enqueued into the command queue of the device context after all commands
+// that were enqueued before (e.g. the kernel that writes the input buffer) and block until the
+// result was read, an instance must not be used by multiple threads at the same time
+class Reduction
+{
+public:
+    Reduction(Runtime &runtime, const cl::Device &device);
+
+    const bool isValid() const;
+    // True if the work group reductions use subgroup functions instead of local memory trees
+    const bool usesSubgroups() const;
+    // Device time of the last reduction (from the start of the first to the end of the read)
+    const uint64_t getLastDurationNs() const;
+
+    const bool sum(const cl::Buffer &input, const std::size_t &count, int64_t &result);
+    const bool min(const cl::Buffer &input, const std::size_t &count, int32_t &result);
+    const bool max(const cl::Buffer &input, const std::size_t &count, int32_t &result);
+    // Number of elements that are not equal to the element of the reference buffer
+    const bool countMismatches(const cl::Buffer &input, const cl::Buffer &reference,
+                               const std::size_t &count, uint64_t &result);
+    // Number of elements that are not equal to first + index (wraps around like int32)
+    const bool countIndexMismatches(const cl::Buffer &input, const std::size_t &count,
+                                    const int32_t &first, uint64_t &result);
+    // Smallest value and the smallest index that has it
+    const bool argmin(const cl::Buffer &input, const std::size_t &count, int32_t &value,
+                      uint64_t &index);
+
+private:
+    // Launch size of the first stage (the second stage uses one work group)
+    const bool getLaunchSize(Kernel &firstStage, Kernel &secondStage, const std::size_t &count,
+                             std::size_t &localSize, std::size_t &groupCount);
+    // Run a first stage (its input arguments are already set, the partial results and the
+    // scratch memory are the arguments outputArg/outputArg + 1) and a second stage that reduces
+    // the partial results into the result
+    const bool runStages(Kernel &firstStage, const cl_uint &outputArg, Kernel &secondStage,
+                         const std::size_t &count, const std::size_t &valueSize, void *result);
+    const bool enqueue(Kernel &kernel, const std::size_t &global, const std::size_t &local,
+                       cl::Event *event);
+    // Blocking read of the result buffer (sets the duration of the reduction)
+    const bool readResult(const std::size_t &size, void *result, const cl::Event &firstEvent);
+
+    DeviceContext &deviceContext;
+    bool valid = false;
+    bool subgroups = false;
+    uint64_t lastDurationNs = 0;
+    std::size_t maxGroupCount = 0;
+    cl::Buffer partialValues;
+    cl::Buffer partialIndices;
+    cl::Buffer results;
+    cl::Buffer resultIndex;
+    Kernel sumInt;
+    Kernel sumLong;
+    Kernel minInt;
+    Kernel maxInt;
+    Kernel mismatchesInt;
+    Kernel indexMismatchesInt;
+    Kernel argminInt;
+    Kernel argminIndexedInt;
+};
+
+}
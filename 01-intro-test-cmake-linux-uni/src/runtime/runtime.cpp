@@ -0,0 +1,353 @@
+#include "runtime.hpp"
+
+// Include project headers
+#include "trace.hpp"
+
+// Include stl libraries
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+const bool startsWith(const std::string &text, const std::string &prefix)
+{
+    return text.compare(0, prefix.size(), prefix) == 0;
+}
+
+}
+
+namespace clrt {
+
+Kernel::Kernel(const cl::Kernel &kernel, DeviceContext *deviceContext)
+    : kernel(kernel), deviceContext(deviceContext)
+{
+}
+
+const bool Kernel::enqueue(const cl::NDRange &global, const cl::NDRange &local,
+                           const std::vector<cl::Event> *waitEvents, cl::Event *event)
+{
+    cl::Event traceEvent;
+    cl::Event *commandEvent = getTraceEvent(event, traceEvent);
+    const cl_int err = deviceContext->queue.enqueueNDRangeKernel(kernel, cl::NullRange, global,
+                                                                 local, waitEvents, commandEvent);
+    if (err != CL_SUCCESS) {
+        reportError("CommandQueue::enqueueNDRangeKernel failed", err);
+        return false;
+    }
+    if (commandEvent != nullptr && Tracer::getInstance().isEnabled()) {
+        const std::string name = trimInfoString(kernel.getInfo<CL_KERNEL_FUNCTION_NAME>());
+        traceCommand(name.c_str(), commandEvent);
+    }
+    return true;
+}
+
+const bool Kernel::run(const cl::NDRange &global, const cl::NDRange &local, cl::Event *event)
+{
+    if (!enqueue(global, local, nullptr, event)) {
+        return false;
+    }
+    const cl_int err = deviceContext->queue.finish();
+    if (err != CL_SUCCESS) {
+        reportError("CommandQueue::finish failed", err);
+        return false;
+    }
+    return true;
+}
+
+cl::Kernel &Kernel::get()
+{
+    return kernel;
+}
+
+DeviceContext &Kernel::getDeviceContext() const
+{
+    return *deviceContext;
+}
+
+Program::Program(const cl::Program &program, DeviceContext *deviceContext)
+    : program(program), deviceContext(deviceContext)
+{
+}
+
+const bool Program::createKernel(const std::string &kernelName, Kernel &kernel) const
+{
+    cl_int err = CL_SUCCESS;
+    cl::Kernel clKernel(program, kernelName.c_str(), &err);
+    if (err != CL_SUCCESS) {
+        reportError("Kernel::Kernel(\"" + kernelName + "\") failed", err);
+        return false;
+    }
+    kernel = Kernel(clKernel, deviceContext);
+    return true;
+}
+
+const cl::Program &Program::get() const
+{
+    return program;
+}
+
+DeviceContext &Program::getDeviceContext() const
+{
+    return *deviceContext;
+}
+
+Runtime::Runtime(const std::string &kernelDirectory, const std::string &binaryCacheDirectory)
+    : kernelDirectory(kernelDirectory), binaryCache(binaryCacheDirectory)
+{
+}
+
+const std::vector<cl::Platform> &Runtime::getPlatforms()
+{
+    discover();
+    return platforms;
+}
+
+const std::vector<cl::Device> &Runtime::getDevices()
+{
+    discover();
+    return devices;
+}
+
+const bool Runtime::findDevice(const std::string &platformName, const std::string &deviceName,
+                               const cl_device_type &deviceType, cl::Device &device)
+{
+    for (auto const &currentDevice : getDevices()) {
+        const cl::Platform platform(currentDevice.getInfo<CL_DEVICE_PLATFORM>());
+        if ((currentDevice.getInfo<CL_DEVICE_TYPE>() & deviceType)
+            && startsWith(trimInfoString(platform.getInfo<CL_PLATFORM_NAME>()), platformName)
+            && startsWith(trimInfoString(currentDevice.getInfo<CL_DEVICE_NAME>()), deviceName)) {
+            device = currentDevice;
+            return true;
+        }
+    }
+    reportError("No \"" + deviceName + "\" OpenCL device of the platform \"" + platformName
+                + "\" found");
+    return false;
+}
+
+DeviceContext &Runtime::getDeviceContext(const cl::Device &device)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    auto &deviceContext = deviceContexts[device()];
+    if (!deviceContext) {
+        deviceContext.reset(new DeviceContext());
+        deviceContext->platform = cl::Platform(device.getInfo<CL_DEVICE_PLATFORM>());
+        deviceContext->device = device;
+    }
+    // Only a complete context is kept, a failed one is created again by the next call
+    if (!deviceContext->valid) {
+        cl_int err = CL_SUCCESS;
+        const cl::Context context({device}, nullptr, nullptr, nullptr, &err);
+        if (err != CL_SUCCESS) {
+            reportError("Context::Context failed", err);
+            return *deviceContext;
+        }
+        const cl::CommandQueue queue(context, device, CL_QUEUE_PROFILING_ENABLE, &err);
+        if (err != CL_SUCCESS) {
+            reportError("CommandQueue::CommandQueue failed", err);
+            return *deviceContext;
+        }
+        deviceContext->context = context;
+        deviceContext->queue = queue;
+        deviceContext->valid = true;
+    }
+    return *deviceContext;
+}
+
+BufferPool &Runtime::getBufferPool(const cl::Device &device)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    auto &bufferPool = bufferPools[device()];
+    if (!bufferPool) {
+        bufferPool.reset(new BufferPool(getDeviceContext(device)));
+    }
+    return *bufferPool;
+}
+
+void Runtime::setEmbeddedKernelFiles(const EmbeddedKernelFile *files, const std::size_t &count)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    embeddedKernelFiles.clear();
+    for (std::size_t i = 0; i < count; i++) {
+        embeddedKernelFiles[files[i].name] = &files[i];
+    }
+}
+
+const bool Runtime::addGeneratedKernelFile(const std::string &name, const std::string &source)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    const auto generatedFile = generatedKernelFiles.find(name);
+    if (generatedFile != generatedKernelFiles.end() && generatedFile->second != source) {
+        // Programs that were built from the old source would be reused
+        reportError("The generated kernel file \"" + name + "\" already has another source");
+        return false;
+    }
+    generatedKernelFiles[name] = source;
+    return true;
+}
+
+const bool Runtime::loadSources(const std::vector<std::string> &sourceFiles,
+                                std::vector<std::string> &sources) const
+{
+    TraceSpan span("load sources", "build");
+    sources.clear();
+    for (auto const &sourceFile : sourceFiles) {
+        const auto generatedFile = generatedKernelFiles.find(sourceFile);
+        if (generatedFile != generatedKernelFiles.end()) {
+            sources.push_back(generatedFile->second);
+            continue;
+        }
+        const auto embeddedFile = embeddedKernelFiles.find(sourceFile);
+        if (embeddedFile != embeddedKernelFiles.end()) {
+            sources.emplace_back(embeddedFile->second->source, embeddedFile->second->sourceSize);
+            continue;
+        }
+        const std::string sourceFilePath = kernelDirectory + "/" + sourceFile;
+        const std::ifstream file(sourceFilePath);
+        if (!file) {
+            reportError("Kernel source file \"" + sourceFilePath + "\" could not be read");
+            return false;
+        }
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        sources.push_back(buffer.str());
+    }
+    return true;
+}
+
+const bool Runtime::buildProgram(const cl::Device &device,
+                                 const std::vector<std::string> &sourceFiles,
+                                 const std::vector<BuildDefine> &defines, Program &program,
+                                 const std::string &extraBuildOptions)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    DeviceContext &deviceContext = getDeviceContext(device);
+    if (!deviceContext.valid) {
+        return false;
+    }
+    const std::string buildOptions = extraBuildOptions + createBuildOptions(defines);
+
+    // Reuse the program if it was already built in this process
+    std::string programKey = buildOptions;
+    for (auto const &sourceFile : sourceFiles) {
+        programKey += ";" + sourceFile;
+    }
+    const auto builtProgram = programs.find(std::make_tuple(device(), programKey));
+    if (builtProgram != programs.end()) {
+        program = Program(builtProgram->second, &deviceContext);
+        return true;
+    }
+
+    std::vector<std::string> sources;
+    if (!loadSources(sourceFiles, sources)) {
+        return false;
+    }
+    std::string il;
+    if (sourceFiles.size() == 1 && defines.empty()) {
+        const auto embeddedFile = embeddedKernelFiles.find(sourceFiles[0]);
+        if (embeddedFile != embeddedKernelFiles.end() && embeddedFile->second->il != nullptr) {
+            il.assign(embeddedFile->second->il, embeddedFile->second->ilSize);
+        }
+    }
+    cl::Program clProgram;
+    if (!binaryCache.buildProgram(deviceContext.context, device, sources, buildOptions,
+                                  clProgram, il)) {
+        return false;
+    }
+    programs[std::make_tuple(device(), programKey)] = clProgram;
+    program = Program(clProgram, &deviceContext);
+    return true;
+}
+
+const bool Runtime::buildSpecializedProgram(const cl::Device &device,
+                                            const std::vector<std::string> &sourceFiles,
+                                            const Specialization &specialization,
+                                            Program &program, const std::string &extraBuildOptions)
+{
+    return buildProgram(device, sourceFiles, specialization.getDefines(), program,
+                        extraBuildOptions);
+}
+
+ProgramBinaryCache &Runtime::getBinaryCache()
+{
+    return binaryCache;
+}
+
+const bool Runtime::discover()
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if (discovered) {
+        return !platforms.empty();
+    }
+    discovered = true;
+    const cl_int err = cl::Platform::get(&platforms);
+    if (err != CL_SUCCESS || platforms.empty()) {
+        reportError("No supported platforms found", err);
+        return false;
+    }
+    for (auto const &platform : platforms) {
+        std::vector<cl::Device> platformDevices;
+        platform.getDevices(CL_DEVICE_TYPE_GPU | CL_DEVICE_TYPE_CPU, &platformDevices);
+        devices.insert(devices.end(), platformDevices.begin(), platformDevices.end());
+    }
+    return true;
+}
+
+const std::string createBuildOptions(const std::vector<BuildDefine> &defines)
+{
+    std::string buildOptions = "";
+    for (auto const &define : defines) {
+        buildOptions += " -D" + std::get<0>(define) + "=" + std::get<1>(define);
+    }
+    return buildOptions;
+}
+
+const std::string trimInfoString(std::string text)
+{
+    while (!text.empty() && text.back() == '\0') {
+        text.pop_back();
+    }
+    return text;
+}
+
+const std::string escapeJson(const std::string &text)
+{
+    std::ostringstream escaped;
+    for (const char character : text) {
+        switch (character) {
+        case '"':
+            escaped << "\\\"";
+            break;
+        case '\\':
+            escaped << "\\\\";
+            break;
+        default:
+            if (static_cast<unsigned char>(character) < 0x20) {
+                escaped << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+                        << static_cast<int>(character) << std::dec;
+            } else {
+                escaped << character;
+            }
+        }
+    }
+    return escaped.str();
+}
+
+const uint64_t getEventDurationNs(const cl::Event &event)
+{
+    return event.getProfilingInfo<CL_PROFILING_COMMAND_END>()
+           - event.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+}
+
+void reportError(const std::string &message, const cl_int &errorCode)
+{
+    std::cerr << "\033[1;31mError: " << message;
+    if (errorCode != CL_SUCCESS) {
+        std::cerr << " (OpenCL error code " << errorCode << ")";
+    }
+    std::cerr << "\033[0m" << std::endl;
+}
+
+}
@@ -0,0 +1,182 @@
+#pragma once
+
+// TARGET OPENCL 2.0
+#ifndef CL_HPP_TARGET_OPENCL_VERSION
+#define CL_HPP_TARGET_OPENCL_VERSION 200
+#endif
+#include <CL/cl2.hpp>
+
+// Include project headers
+#include "binary_cache.hpp"
+#include "buffer_pool.hpp"
+#include "specialization.hpp"
+
+// Include stl libraries
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace clrt {
+
+// Everything that is needed to run commands on a single device
+struct DeviceContext {
+    cl::Platform platform;
+    cl::Device device;
+    cl::Context context;
+    // In order queue with profiling enabled
+    cl::CommandQueue queue;
+    // False if the context or the queue could not be created
+    bool valid = false;
+};
+
+// Kernel file that is compiled into the executable instead of being read at runtime
+struct EmbeddedKernelFile {
+    // File name relative to the kernel directory
+    const char *name;
+    const char *source;
+    std::size_t sourceSize;
+    // Precompiled SPIR-V of the file (null if it was not compiled offline)
+    const char *il;
+    std::size_t ilSize;
+};
+
+// Handle of a kernel that is bound to the device context it was created for
+class Kernel
+{
+public:
+    Kernel() = default;
+    Kernel(const cl::Kernel &kernel, DeviceContext *deviceContext);
+
+    template <typename T>
+    const bool setArg(const cl_uint &index, const T &value);
+
+    // Enqueue the kernel into the command queue of its device (non blocking)
+    const bool enqueue(const cl::NDRange &global, const cl::NDRange &local = cl::NullRange,
+                       const std::vector<cl::Event> *waitEvents = nullptr,
+                       cl::Event *event = nullptr);
+    // Enqueue the kernel and wait until it is finished
+    const bool run(const cl::NDRange &global, const cl::NDRange &local = cl::NullRange,
+                   cl::Event *event = nullptr);
+
+    cl::Kernel &get();
+    DeviceContext &getDeviceContext() const;
+
+private:
+    cl::Kernel kernel;
+    DeviceContext *deviceContext = nullptr;
+};
+
+// Handle of a built program that is bound to the device context it was built for
+class Program
+{
+public:
+    Program() = default;
+    Program(const cl::Program &program, DeviceContext *deviceContext);
+
+    const bool createKernel(const std::string &kernelName, Kernel &kernel) const;
+
+    const cl::Program &get() const;
+    DeviceContext &getDeviceContext() const;
+
+private:
+    cl::Program program;
+    DeviceContext *deviceContext = nullptr;
+};
+
+// Discovers platforms/devices once and caches contexts, queues and built programs so that
+// repeated kernel launches do not pay the creation costs again
+class Runtime
+{
+public:
+    explicit Runtime(const std::string &kernelDirectory = "kernels",
+                     const std::string &binaryCacheDirectory = "cache");
+
+    const std::vector<cl::Platform> &getPlatforms();
+    // All CPU and GPU devices of all platforms
+    const std::vector<cl::Device> &getDevices();
+    // Find a device by (a prefix of) its platform and device name
+    const bool findDevice(const std::string &platformName, const std::string &deviceName,
+                          const cl_device_type &deviceType, cl::Device &device);
+
+    // Get the (created once) context and command queue of a device, the creation is tried again
+    // as long as it fails (check valid, the reference stays the same)
+    DeviceContext &getDeviceContext(const cl::Device &device);
+    // Get the (created once) buffer pool of the context of a device
+    BufferPool &getBufferPool(const cl::Device &device);
+
+    // Use these files instead of the files in the kernel directory (the array has to stay valid
+    // as long as the runtime)
+    void setEmbeddedKernelFiles(const EmbeddedKernelFile *files, const std::size_t &count);
+    // Add a kernel file whose source is generated at runtime (e.g. fused kernels), it can be
+    // used like the other files (a name can only be used for one source)
+    const bool addGeneratedKernelFile(const std::string &name, const std::string &source);
+    // Read the content of the kernel source files (embedded or relative to the kernel directory)
+    const bool loadSources(const std::vector<std::string> &sourceFiles,
+                           std::vector<std::string> &sources) const;
+    // Build (or load from the binary cache) a program for a device (fails if the device context
+    // is not valid)
+    // Programs that were already built with the same files and options are reused
+    // A single embedded file without defines is created from its SPIR-V if it has one and the
+    // device supports it (defines cannot be applied to precompiled SPIR-V)
+    const bool buildProgram(const cl::Device &device, const std::vector<std::string> &sourceFiles,
+                            const std::vector<BuildDefine> &defines, Program &program,
+                            const std::string &extraBuildOptions = "");
+    // Build a program for a set of compile time constants, every constant set is only built
+    // once per process (independent of the order in which the constants were set)
+    const bool buildSpecializedProgram(const cl::Device &device,
+                                       const std::vector<std::string> &sourceFiles,
+                                       const Specialization &specialization, Program &program,
+                                       const std::string &extraBuildOptions = "");
+
+    ProgramBinaryCache &getBinaryCache();
+
+private:
+    const bool discover();
+
+    std::string kernelDirectory;
+    std::map<std::string, const EmbeddedKernelFile *> embeddedKernelFiles;
+    std::map<std::string, std::string> generatedKernelFiles;
+    ProgramBinaryCache binaryCache;
+    bool discovered = false;
+    std::vector<cl::Platform> platforms;
+    std::vector<cl::Device> devices;
+    std::map<cl_device_id, std::unique_ptr<DeviceContext>> deviceContexts;
+    // Destroyed before the device contexts that they use
+    std::map<cl_device_id, std::unique_ptr<BufferPool>> bufferPools;
+    std::map<std::tuple<cl_device_id, std::string>, cl::Program> programs;
+    std::recursive_mutex mutex;
+};
+
+// Create the build option string ("-DNAME=VALUE ...") of a list of defines
+const std::string createBuildOptions(const std::vector<BuildDefine> &defines);
+
+// Remove the terminating null characters that (older) OpenCL implementations include in
+// info strings
+const std::string trimInfoString(std::string text);
+
+// Escape the quotes, backslashes and control characters of a JSON string value
+const std::string escapeJson(const std::string &text);
+
+// Get the time between the start and the end of a command (needs a profiling queue)
+const uint64_t getEventDurationNs(const cl::Event &event);
+
+// Display an error message and an OpenCL error code if there is one
+void reportError(const std::string &message, const cl_int &errorCode = CL_SUCCESS);
+
+template <typename T>
+const bool Kernel::setArg(const cl_uint &index, const T &value)
+{
+    const cl_int err = kernel.setArg(index, value);
+    if (err != CL_SUCCESS) {
+        reportError("Kernel::setArg(" + std::to_string(index) + ") failed", err);
+        return false;
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,204 @@
+#include "scheduler.hpp"
+
+// Include project headers
+#include "trace.hpp"
+
+// Include stl libraries
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <numeric>
+#include <thread>
+
+namespace {
+
+// Packets are a multiple of this element count and at least minPacketElementCount big so that
+// the launch and transfer overhead of a packet stays small compared to its processing time
+constexpr std::size_t packetGranularity = 4096;
+constexpr std::size_t minPacketElementCount = 64 * 1024;
+// Bigger packets do not improve the transfer rate but make the rebalancing coarser
+constexpr uint64_t maxPacketSize = 64 * 1024 * 1024;
+// Packets that are enqueued per device before the host waits for the oldest one
+constexpr std::size_t packetsInFlight = 2;
+
+const uint64_t getElapsedNs(const std::chrono::steady_clock::time_point &begin)
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>
+                                 (std::chrono::steady_clock::now() - begin).count());
+}
+
+}
+
+namespace clrt {
+
+const bool MultiDeviceScheduler::run(std::vector<Kernel> &kernels, void *data,
+                                     const std::size_t &elementSize,
+                                     const std::size_t &elementCount,
+                                     PartitionStatistics &statistics)
+{
+    statistics = PartitionStatistics();
+    statistics.devices.resize(kernels.size());
+    if (elementCount == 0 || kernels.empty()) {
+        return true;
+    }
+
+    // Prepare the weights and the packet buffers of all devices before the threads start
+    nextElement = 0;
+    this->elementCount = elementCount;
+    failed = false;
+    weights.clear();
+    maxPacketElementCounts.clear();
+    for (std::size_t i = 0; i < kernels.size(); i++) {
+        DeviceContext &deviceContext = kernels[i].getDeviceContext();
+        const cl::Device &device = deviceContext.device;
+        statistics.devices[i].deviceName = trimInfoString(device.getInfo<CL_DEVICE_NAME>());
+        weights.push_back(getThroughput(device));
+
+        uint64_t packetSize = std::min<uint64_t>(device.getInfo<CL_DEVICE_MAX_MEM_ALLOC_SIZE>(),
+                                                 device.getInfo<CL_DEVICE_GLOBAL_MEM_SIZE>() / 4);
+        packetSize = std::min(packetSize, maxPacketSize);
+        const std::size_t maxPacketElementCount = std::max<std::size_t>(
+                    packetGranularity, packetSize / elementSize / packetGranularity * packetGranularity);
+        maxPacketElementCounts.push_back(maxPacketElementCount);
+
+        const std::size_t bufferSize = std::min(maxPacketElementCount, elementCount) * elementSize;
+        if (packetBufferSizes[device()] < bufferSize) {
+            cl_int err = CL_SUCCESS;
+            packetBuffers[device()] = cl::Buffer(deviceContext.context, CL_MEM_READ_WRITE,
+                                                 bufferSize, nullptr, &err);
+            if (err != CL_SUCCESS) {
+                packetBufferSizes.erase(device());
+                reportError("Buffer::Buffer failed", err);
+                return false;
+            }
+            packetBufferSizes[device()] = bufferSize;
+        }
+    }
+
+    // Run all devices at the same time
+    const auto begin = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    std::vector<char> successes(kernels.size(), 0);
+    for (std::size_t i = 0; i < kernels.size(); i++) {
+        threads.emplace_back([&, i]() {
+            successes[i] = runDevice(i, kernels[i], static_cast<unsigned char *>(data),
+                                     elementSize, statistics.devices[i]);
+            statistics.devices[i].busyNs = getElapsedNs(begin);
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    statistics.wallNs = getElapsedNs(begin);
+    if (std::find(successes.begin(), successes.end(), 0) != successes.end()) {
+        return false;
+    }
+
+    // The next runs use the measured throughputs (devices that got no work keep their weight)
+    for (std::size_t i = 0; i < kernels.size(); i++) {
+        DeviceShare &share = statistics.devices[i];
+        if (share.busyNs > 0) {
+            share.elementsPerNs = static_cast<double>(share.elementCount) / share.busyNs;
+        }
+        if (share.elementCount > 0) {
+            throughputs[kernels[i].getDeviceContext().device()] = share.elementsPerNs;
+        }
+    }
+    return true;
+}
+
+const double MultiDeviceScheduler::getThroughput(const cl::Device &device)
+{
+    const auto throughput = throughputs.find(device());
+    if (throughput != throughputs.end()) {
+        return throughput->second;
+    }
+    // Estimate (only the ratio between the devices matters)
+    const double estimate = static_cast<double>(device.getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>())
+                            * device.getInfo<CL_DEVICE_MAX_CLOCK_FREQUENCY>();
+    return std::max(1.0, estimate) * 1e-6;
+}
+
+const bool MultiDeviceScheduler::takePacket(const std::size_t &deviceIndex, std::size_t &offset,
+                                            std::size_t &count)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (failed || nextElement >= elementCount) {
+        return false;
+    }
+    // Take half of the share of the remaining elements (guided scheduling): Fast devices get
+    // big packets at the beginning and the end of the range is split into small packets
+    const std::size_t remaining = elementCount - nextElement;
+    const double share = weights[deviceIndex] / std::accumulate(weights.begin(), weights.end(),
+                                                                0.0);
+    count = static_cast<std::size_t>(remaining * share / 2);
+    count = (count + packetGranularity - 1) / packetGranularity * packetGranularity;
+    count = std::max(minPacketElementCount, std::min(count, maxPacketElementCounts[deviceIndex]));
+    count = std::min(count, remaining);
+    offset = nextElement;
+    nextElement += count;
+    return true;
+}
+
+const bool MultiDeviceScheduler::runDevice(const std::size_t &deviceIndex, Kernel &kernel,
+                                           unsigned char *data, const std::size_t &elementSize,
+                                           DeviceShare &share)
+{
+    DeviceContext &deviceContext = kernel.getDeviceContext();
+    const cl::CommandQueue &queue = deviceContext.queue;
+    const cl::Buffer &buffer = packetBuffers.at(deviceContext.device());
+    bool success = kernel.setArg(0, buffer);
+
+    // The queue is in order so the packets can share the buffer: The write of a packet always
+    // starts after the read of the packet before it
+    std::deque<cl::Event> readEvents;
+    std::size_t offset = 0;
+    std::size_t count = 0;
+    while (success && takePacket(deviceIndex, offset, count)) {
+        unsigned char *packetData = data + offset * elementSize;
+        cl::Event writeEvent;
+        cl::Event kernelEvent;
+        cl::Event *traceWriteEvent = getTraceEvent(nullptr, writeEvent);
+        cl::Event *traceKernelEvent = getTraceEvent(nullptr, kernelEvent);
+        cl_int err = queue.enqueueWriteBuffer(buffer, CL_FALSE, 0, count * elementSize,
+                                              packetData, nullptr, traceWriteEvent);
+        if (err == CL_SUCCESS) {
+            traceCommand("write packet", traceWriteEvent);
+            err = queue.enqueueNDRangeKernel(kernel.get(), cl::NDRange(offset), cl::NDRange(count),
+                                             cl::NullRange, nullptr, traceKernelEvent);
+        }
+        readEvents.emplace_back();
+        if (err == CL_SUCCESS) {
+            traceCommand("process packet", traceKernelEvent);
+            err = queue.enqueueReadBuffer(buffer, CL_FALSE, 0, count * elementSize, packetData,
+                                          nullptr, &readEvents.back());
+        }
+        if (err == CL_SUCCESS) {
+            traceCommand("read packet", &readEvents.back());
+        }
+        if (err != CL_SUCCESS) {
+            reportError("MultiDeviceScheduler failed to process a packet on "
+                        + share.deviceName, err);
+            success = false;
+            break;
+        }
+        queue.flush();
+        share.elementCount += count;
+        share.packetCount++;
+
+        // Take the next packet only when the device is almost idle, otherwise it would take work
+        // away from the other devices
+        if (readEvents.size() >= packetsInFlight) {
+            readEvents.front().wait();
+            readEvents.pop_front();
+        }
+    }
+    queue.finish();
+    if (!success) {
+        std::lock_guard<std::mutex> lock(mutex);
+        failed = true;
+    }
+    return success;
+}
+
+}
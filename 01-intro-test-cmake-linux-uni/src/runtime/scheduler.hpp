@@ -0,0 +1,71 @@
+#pragma once
+
+// Include project headers
+#include "runtime.hpp"
+
+// Include stl libraries
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace clrt {
+
+// Part of a multi device run that one device processed
+struct DeviceShare {
+    std::string deviceName;
+    std::size_t elementCount = 0;
+    std::size_t packetCount = 0;
+    // Time between the start of the run and the moment the device finished its last packet
+    uint64_t busyNs = 0;
+    double elementsPerNs = 0;
+};
+
+struct PartitionStatistics {
+    std::vector<DeviceShare> devices;
+    uint64_t wallNs = 0;
+};
+
+// Splits one 1D range across multiple devices (of any platform) that process it at the same
+// time: Every device is driven by its own host thread and command queue and takes packets from
+// the remaining range whose size is weighted by the throughput that was measured for it in the
+// previous runs, the packets get smaller towards the end so that a device that finishes early
+// takes over the rest of the work (dynamic rebalancing)
+//
+// Every device needs its own kernel that gets the packet buffer as argument 0 and is launched
+// with the global offset of the packet so it has to index its buffer with
+// get_global_id(0) - get_global_offset(0)
+class MultiDeviceScheduler
+{
+public:
+    // Process the elementCount elements of the host data with the kernels (one per device, every
+    // device may only be used once)
+    const bool run(std::vector<Kernel> &kernels, void *data, const std::size_t &elementSize,
+                   const std::size_t &elementCount, PartitionStatistics &statistics);
+
+    // Measured throughput of a device (before the first run: an estimate based on its compute
+    // units and clock frequency)
+    const double getThroughput(const cl::Device &device);
+
+private:
+    const bool takePacket(const std::size_t &deviceIndex, std::size_t &offset,
+                          std::size_t &count);
+    const bool runDevice(const std::size_t &deviceIndex, Kernel &kernel, unsigned char *data,
+                         const std::size_t &elementSize, DeviceShare &share);
+
+    std::map<cl_device_id, double> throughputs;
+    std::map<cl_device_id, cl::Buffer> packetBuffers;
+    std::map<cl_device_id, std::size_t> packetBufferSizes;
+
+    // State of the current run (shared by the device threads)
+    std::mutex mutex;
+    std::size_t nextElement = 0;
+    std::size_t elementCount = 0;
+    std::vector<double> weights;
+    std::vector<std::size_t> maxPacketElementCounts;
+    bool failed = false;
+};
+
+}
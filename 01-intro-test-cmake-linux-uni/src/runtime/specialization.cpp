@@ -0,0 +1,68 @@
+#include "specialization.hpp"
+
+// Include stl libraries
+#include <cmath>
+#include <cstdio>
+#include <limits>
+
+namespace clrt {
+
+const std::vector<BuildDefine> Specialization::getDefines() const
+{
+    std::vector<BuildDefine> defines;
+    for (auto const &constant : constants) {
+        defines.push_back(BuildDefine(constant.first, constant.second));
+    }
+    return defines;
+}
+
+const bool Specialization::empty() const
+{
+    return constants.empty();
+}
+
+Specialization &Specialization::setLiteral(const std::string &name, const std::string &literal)
+{
+    constants[name] = literal;
+    return *this;
+}
+
+const std::string Specialization::formatSigned(const int64_t &value, const bool &isLong)
+{
+    const std::string suffix = isLong ? "L" : "";
+    if (value >= 0) {
+        return std::to_string(value) + suffix;
+    }
+    // The smallest value has no positive literal of the same type
+    if (value == std::numeric_limits<int64_t>::min()) {
+        return "(-9223372036854775807L-1)";
+    }
+    if (!isLong && value == std::numeric_limits<int32_t>::min()) {
+        return "(-2147483647-1)";
+    }
+    return "(" + std::to_string(value) + suffix + ")";
+}
+
+const std::string Specialization::formatUnsigned(const uint64_t &value, const bool &isLong)
+{
+    return std::to_string(value) + (isLong ? "uL" : "u");
+}
+
+const std::string Specialization::formatFloatingPoint(const double &value, const bool &isFloat)
+{
+    // The macros of OpenCL C are float constants (the build options must not contain spaces)
+    if (std::isnan(value)) {
+        return isFloat ? "NAN" : "((double)NAN)";
+    }
+    if (std::isinf(value)) {
+        const std::string infinity = isFloat ? "INFINITY" : "((double)INFINITY)";
+        return value < 0 ? "(-" + infinity + ")" : infinity;
+    }
+    // Hexadecimal literals are exact (decimal ones would be rounded)
+    char literal[64];
+    std::snprintf(literal, sizeof(literal), "%a", value);
+    const std::string text = std::string(literal) + (isFloat ? "f" : "");
+    return value < 0 ? "(" + text + ")" : text;
+}
+
+}
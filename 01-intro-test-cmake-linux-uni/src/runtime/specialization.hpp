@@ -0,0 +1,58 @@
+#pragma once
+
+// Include stl libraries
+#include <cstdint>
+#include <map>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace clrt {
+
+// Build option that is passed as "-D<name>=<value>" to the device compiler
+typedef std::tuple<std::string, std::string> BuildDefine;
+
+// Set of typed host constants that are compiled into a program as defines (e.g. loop counts or
+// sizes that are the same for every work item) so that the device compiler can fold them
+//
+// The values are formatted as OpenCL C literals of the same type (unsigned "u", 64 bit "L",
+// hexadecimal float "f"), double constants need a kernel that enables cl_khr_fp64
+// The defines are sorted by name, so the same constants always result in the same build options
+class Specialization
+{
+public:
+    template <typename T>
+    Specialization &set(const std::string &name, const T &value);
+
+    const std::vector<BuildDefine> getDefines() const;
+    const bool empty() const;
+
+private:
+    Specialization &setLiteral(const std::string &name, const std::string &literal);
+
+    static const std::string formatSigned(const int64_t &value, const bool &isLong);
+    static const std::string formatUnsigned(const uint64_t &value, const bool &isLong);
+    static const std::string formatFloatingPoint(const double &value, const bool &isFloat);
+
+    std::map<std::string, std::string> constants;
+};
+
+template <typename T>
+Specialization &Specialization::set(const std::string &name, const T &value)
+{
+    static_assert(std::is_arithmetic<T>::value, "Only numbers can be compile time constants");
+    if (std::is_same<T, bool>::value) {
+        return setLiteral(name, value ? "1" : "0");
+    }
+    if (std::is_floating_point<T>::value) {
+        return setLiteral(name, formatFloatingPoint(static_cast<double>(value),
+                                                    sizeof(T) == sizeof(float)));
+    }
+    if (std::is_signed<T>::value) {
+        return setLiteral(name, formatSigned(static_cast<int64_t>(value), sizeof(T) > 4));
+    }
+    return setLiteral(name, formatUnsigned(static_cast<uint64_t>(value), sizeof(T) > 4));
+}
+
+}
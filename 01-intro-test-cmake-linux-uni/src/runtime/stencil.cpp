@@ -0,0 +1,158 @@
+#include "stencil.hpp"
+
+// Include project headers
+#include "trace.hpp"
+
+// Include stl libraries
+#include <string>
+
+namespace {
+
+const std::size_t roundUp(const std::size_t &value, const std::size_t &multiple)
+{
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+}
+
+namespace clrt {
+
+Stencil2D::Stencil2D(Runtime &runtime, const cl::Device &device, const unsigned int &radius,
+                     const std::size_t &tileWidth, const std::size_t &tileHeight)
+    : deviceContext(runtime.getDeviceContext(device)), radius(radius), tileWidth(tileWidth),
+      tileHeight(tileHeight)
+{
+    // The work group is one tile and the local memory holds the tile with its halo
+    const std::size_t haloSize = (tileWidth + 2 * radius) * (tileHeight + 2 * radius)
+                                 * sizeof(cl_float);
+    if (tileWidth == 0 || tileHeight == 0
+        || tileWidth * tileHeight > device.getInfo<CL_DEVICE_MAX_WORK_GROUP_SIZE>()
+        || haloSize > device.getInfo<CL_DEVICE_LOCAL_MEM_SIZE>()) {
+        reportError("Stencil2D: The tile " + std::to_string(tileWidth) + "x"
+                    + std::to_string(tileHeight) + " with the radius " + std::to_string(radius)
+                    + " does not fit into a work group of the device");
+        return;
+    }
+    images = device.getInfo<CL_DEVICE_IMAGE_SUPPORT>() == CL_TRUE;
+
+    // The kernels compute signed offsets and halo coordinates, unsigned literals ("1u") would
+    // turn them into unsigned arithmetic (e.g. -STENCIL_RADIUS <= STENCIL_RADIUS is false)
+    const Specialization constants = Specialization()
+                                     .set("STENCIL_RADIUS", static_cast<cl_int>(radius))
+                                     .set("TILE_WIDTH", static_cast<cl_int>(tileWidth))
+                                     .set("TILE_HEIGHT", static_cast<cl_int>(tileHeight));
+    Program program;
+    if (!runtime.buildSpecializedProgram(device, { "stencil.cl" }, constants, program)
+        || !program.createKernel("stencil_naive", naive)
+        || !program.createKernel("stencil_tiled", tiled)
+        || (images && !program.createKernel("stencil_image", imageKernel))) {
+        return;
+    }
+    // The compiler can limit the work group size of the tiled kernel (e.g. register pressure)
+    if (tiled.get().getWorkGroupInfo<CL_KERNEL_WORK_GROUP_SIZE>(device) < tileWidth * tileHeight) {
+        reportError("Stencil2D: The tiled kernel does not support work groups of "
+                    + std::to_string(tileWidth) + "x" + std::to_string(tileHeight));
+        return;
+    }
+    valid = true;
+}
+
+const bool Stencil2D::isValid() const
+{
+    return valid;
+}
+
+const bool Stencil2D::supportsImages() const
+{
+    return images;
+}
+
+const unsigned int Stencil2D::getRadius() const
+{
+    return radius;
+}
+
+const bool Stencil2D::setWeights(const std::vector<float> &weights)
+{
+    const std::size_t size = 2 * radius + 1;
+    if (weights.size() != size * size) {
+        reportError("Stencil2D::setWeights: A filter of the radius " + std::to_string(radius)
+                    + " needs " + std::to_string(size * size) + " weights");
+        return false;
+    }
+    cl_int err = CL_SUCCESS;
+    this->weights = cl::Buffer(deviceContext.context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+                               weights.size() * sizeof(cl_float),
+                               const_cast<float *>(weights.data()), &err);
+    if (err != CL_SUCCESS) {
+        reportError("Buffer::Buffer failed", err);
+        return false;
+    }
+    hasWeights = true;
+    return true;
+}
+
+const bool Stencil2D::runNaive(const cl::Buffer &input, const cl::Buffer &output,
+                               const std::size_t &width, const std::size_t &height,
+                               cl::Event *event)
+{
+    return valid && naive.setArg(0, input)
+           && enqueue(naive, output, width, height, cl::NullRange, event);
+}
+
+const bool Stencil2D::runTiled(const cl::Buffer &input, const cl::Buffer &output,
+                               const std::size_t &width, const std::size_t &height,
+                               cl::Event *event)
+{
+    return valid && tiled.setArg(0, input)
+           && enqueue(tiled, output, width, height, cl::NDRange(tileWidth, tileHeight), event);
+}
+
+const bool Stencil2D::runImage(const cl::Buffer &input, const cl::Buffer &output,
+                               const std::size_t &width, const std::size_t &height,
+                               cl::Event *event)
+{
+    if (!valid || !images) {
+        reportError("Stencil2D::runImage: The device does not support images");
+        return false;
+    }
+    cl_int err = CL_SUCCESS;
+    if (width != imageWidth || height != imageHeight) {
+        image = cl::Image2D(deviceContext.context, CL_MEM_READ_ONLY,
+                            cl::ImageFormat(CL_R, CL_FLOAT), width, height, 0, nullptr, &err);
+        if (err != CL_SUCCESS) {
+            reportError("Image2D::Image2D failed", err);
+            return false;
+        }
+        imageWidth = width;
+        imageHeight = height;
+    }
+    cl::Event copyEvent;
+    err = deviceContext.queue.enqueueCopyBufferToImage(input, image, 0, { 0, 0, 0 },
+                                                       { width, height, 1 }, nullptr, &copyEvent);
+    if (err != CL_SUCCESS) {
+        reportError("CommandQueue::enqueueCopyBufferToImage failed", err);
+        return false;
+    }
+    traceCommand("copy stencil image", &copyEvent);
+    return imageKernel.setArg(0, image)
+           && enqueue(imageKernel, output, width, height, cl::NullRange, event);
+}
+
+const bool Stencil2D::enqueue(Kernel &kernel, const cl::Buffer &output, const std::size_t &width,
+                              const std::size_t &height, const cl::NDRange &local,
+                              cl::Event *event)
+{
+    if (!hasWeights) {
+        reportError("Stencil2D: The weights of the filter were not set");
+        return false;
+    }
+    // Whole tiles so that the tiled kernel gets complete work groups
+    const cl::NDRange global(roundUp(width, tileWidth), roundUp(height, tileHeight));
+    return kernel.setArg(1, output) && kernel.setArg(2, weights)
+           && kernel.setArg(3, static_cast<cl_int>(width))
+           && kernel.setArg(4, static_cast<cl_int>(height))
+           && kernel.enqueue(global, local, nullptr, event);
+}
+
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+// Include project headers
+#include "runtime.hpp"
+
+// Include stl libraries
+#include <cstddef>
+#include <vector>
+
+namespace clrt {
+
+// 2D stencils (convolutions) of single channel float images that are stored row by row in
+// buffers (the kernels are in "stencil.cl" in the kernel directory of the runtime)
+//
+// The filter radius and the tile size are compiled into the kernels, so every combination is a
+// separate program: The tiled version stages every tile with its halo in local memory, the
+// naive version reads everything from global memory and the image version reads through the
+// texture cache (only if the device supports images)
+// The filters are enqueued into the command queue of the device context without waiting, an
+// instance must not be used by multiple threads at the same time
+class Stencil2D
+{
+public:
+    Stencil2D(Runtime &runtime, const cl::Device &device, const unsigned int &radius = 1,
+              const std::size_t &tileWidth = 16, const std::size_t &tileHeight = 16);
+
+    const bool isValid() const;
+    const bool supportsImages() const;
+    const unsigned int getRadius() const;
+
+    // Set the (2 * radius + 1)^2 weights of the filter (row by row)
+    const bool setWeights(const std::vector<float> &weights);
+
+    // Filter the width x height input image into the output buffer (the event is the one of the
+    // kernel)
+    const bool runNaive(const cl::Buffer &input, const cl::Buffer &output,
+                        const std::size_t &width, const std::size_t &height,
+                        cl::Event *event = nullptr);
+    const bool runTiled(const cl::Buffer &input, const cl::Buffer &output,
+                        const std::size_t &width, const std::size_t &height,
+                        cl::Event *event = nullptr);
+    // The input is copied into an image first (the copy is not part of the event)
+    const bool runImage(const cl::Buffer &input, const cl::Buffer &output,
+                        const std::size_t &width, const std::size_t &height,
+                        cl::Event *event = nullptr);
+
+private:
+    const bool enqueue(Kernel &kernel, const cl::Buffer &output, const std::size_t &width,
+                       const std::size_t &height, const cl::NDRange &local, cl::Event *event);
+
+    DeviceContext &deviceContext;
+    bool valid = false;
+    bool images = false;
+    unsigned int radius = 1;
+    std::size_t tileWidth = 16;
+    std::size_t tileHeight = 16;
+    cl::Buffer weights;
+    bool hasWeights = false;
+    // Image of the input of the image version (recreated if the size changes)
+    cl::Image2D image;
+    std::size_t imageWidth = 0;
+    std::size_t imageHeight = 0;
+    Kernel naive;
+    Kernel tiled;
+    Kernel imageKernel;
+};
+
+}
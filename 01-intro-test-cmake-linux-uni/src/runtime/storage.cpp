@@ -0,0 +1,274 @@
+#include "storage.hpp"
+
+// Include stl libraries
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+// Round a float to the nearest half (ties to even) like vstore_half, the values are converted
+// ints so there are no subnormal halves
+uint16_t floatToHalf(const float value)
+{
+    uint32_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const uint32_t sign = (bits >> 16) & 0x8000;
+    const uint32_t magnitude = bits & 0x7FFFFFFF;
+    if (magnitude > 0x7F800000) {
+        return static_cast<uint16_t>(sign | 0x7E00);
+    }
+    // 65520 and above round to infinity
+    if (magnitude >= 0x477FF000) {
+        return static_cast<uint16_t>(sign | 0x7C00);
+    }
+    if (magnitude < 0x38800000) {
+        return static_cast<uint16_t>(sign);
+    }
+    // Rebias the exponent (127 -> 15) and round the mantissa from 23 to 10 bits
+    const uint32_t rebiased = magnitude - ((127 - 15) << 23);
+    return static_cast<uint16_t>(sign | ((rebiased + 0xFFF + ((rebiased >> 13) & 1)) >> 13));
+}
+
+float halfToFloat(const uint16_t half)
+{
+    const uint32_t sign = static_cast<uint32_t>(half & 0x8000) << 16;
+    const uint32_t exponent = (half >> 10) & 0x1F;
+    const uint32_t mantissa = half & 0x3FF;
+    uint32_t bits = sign;
+    if (exponent == 0x1F) {
+        bits |= 0x7F800000 | (mantissa << 13);
+    } else if (exponent > 0) {
+        bits |= ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    } else if (mantissa > 0) {
+        const float value = std::ldexp(static_cast<float>(mantissa), -24);
+        return sign != 0 ? -value : value;
+    }
+    float value = 0;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// convert_int_sat_rte
+int32_t convertSaturated(const float value)
+{
+    if (std::isnan(value)) {
+        return 0;
+    }
+    if (value >= 2147483648.0f) {
+        return std::numeric_limits<int32_t>::max();
+    }
+    if (value < -2147483648.0f) {
+        return std::numeric_limits<int32_t>::min();
+    }
+    return static_cast<int32_t>(std::nearbyint(value));
+}
+
+}
+
+namespace clrt {
+
+constexpr std::size_t StorageCodec::blockSize;
+
+StorageCodec::StorageCodec(const StorageMode &mode, const unsigned int &packBits)
+    : mode(mode), packBits(std::min(31U, std::max(1U, packBits)))
+{
+}
+
+const bool StorageCodec::parse(const std::string &text, StorageCodec &codec)
+{
+    const std::size_t separator = text.find(':');
+    const std::string name = text.substr(0, separator);
+    unsigned int bits = 8;
+    if (separator != std::string::npos) {
+        bits = static_cast<unsigned int>(std::strtoul(text.c_str() + separator + 1, nullptr, 10));
+        if (bits < 1 || bits > 31) {
+            return false;
+        }
+    }
+    if (name == "int32") {
+        codec = StorageCodec(StorageMode::Int32);
+    } else if (name == "int16") {
+        codec = StorageCodec(StorageMode::Int16);
+    } else if (name == "half") {
+        codec = StorageCodec(StorageMode::Half);
+    } else if (name == "packed") {
+        codec = StorageCodec(StorageMode::Packed, bits);
+    } else if (name == "delta") {
+        codec = StorageCodec(StorageMode::Delta, bits);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const StorageMode StorageCodec::getMode() const
+{
+    return mode;
+}
+
+const unsigned int StorageCodec::getPackBits() const
+{
+    return packBits;
+}
+
+const std::string StorageCodec::getName() const
+{
+    switch (mode) {
+    case StorageMode::Int32:
+        return "int32";
+    case StorageMode::Int16:
+        return "int16";
+    case StorageMode::Half:
+        return "half";
+    case StorageMode::Packed:
+        return "packed:" + std::to_string(packBits);
+    default:
+        return "delta:" + std::to_string(packBits);
+    }
+}
+
+const std::size_t StorageCodec::getBlockCount(const std::size_t &count) const
+{
+    return (count + blockSize - 1) / blockSize;
+}
+
+const std::size_t StorageCodec::getStorageSize(const std::size_t &count) const
+{
+    return getBlockCount(count) * getBlockWords() * sizeof(cl_uint);
+}
+
+const double StorageCodec::getBytesPerElement() const
+{
+    return static_cast<double>(getBlockWords() * sizeof(cl_uint)) / blockSize;
+}
+
+void StorageCodec::addConstants(Specialization &constants) const
+{
+    constants.set("STORAGE_MODE", static_cast<cl_uint>(mode))
+    .set("STORAGE_BLOCK", static_cast<cl_uint>(blockSize))
+    .set("PACK_BITS", packBits);
+}
+
+const std::size_t StorageCodec::encode(const int32_t *values, const std::size_t &count,
+                                       std::vector<cl_uint> &words) const
+{
+    const std::size_t blockWords = getBlockWords();
+    words.assign(getBlockCount(count) * blockWords, 0);
+    const uint32_t packMask = (1U << packBits) - 1;
+    std::size_t overflowCount = 0;
+    uint32_t block[blockSize];
+    for (std::size_t first = 0; first < count; first += blockSize) {
+        cl_uint *blockWordsData = words.data() + first / blockSize * blockWords;
+        for (std::size_t i = 0; i < blockSize; i++) {
+            block[i] = static_cast<uint32_t>(values[std::min(first + i, count - 1)]);
+        }
+        switch (mode) {
+        case StorageMode::Int32:
+            std::copy(block, block + blockSize, blockWordsData);
+            break;
+        case StorageMode::Int16:
+        case StorageMode::Half:
+            // Two elements per word (little endian like the devices)
+            for (std::size_t i = 0; i < blockSize; i++) {
+                const float value = static_cast<float>(static_cast<int32_t>(block[i]));
+                const uint16_t bits = mode == StorageMode::Int16 ? static_cast<uint16_t>(block[i])
+                                      : floatToHalf(value);
+                blockWordsData[i / 2] |= static_cast<uint32_t>(bits) << (16 * (i % 2));
+            }
+            break;
+        default: {
+            // The unsigned arithmetic wraps around like the kernel
+            uint32_t offsets[blockSize];
+            uint32_t base = block[0];
+            if (mode == StorageMode::Packed) {
+                for (std::size_t i = 1; i < blockSize; i++) {
+                    base = static_cast<uint32_t>(std::min(static_cast<int32_t>(base),
+                                                          static_cast<int32_t>(block[i])));
+                }
+                for (std::size_t i = 0; i < blockSize; i++) {
+                    offsets[i] = block[i] - base;
+                }
+            } else {
+                offsets[0] = 0;
+                for (std::size_t i = 1; i < blockSize; i++) {
+                    const uint32_t delta = block[i] - block[i - 1];
+                    offsets[i] = (delta << 1) ^ (0U - (delta >> 31));
+                }
+            }
+            bool overflow = false;
+            blockWordsData[0] = base;
+            for (std::size_t i = 0; i < blockSize; i++) {
+                overflow |= offsets[i] > packMask;
+                const uint32_t value = offsets[i] & packMask;
+                const std::size_t bit = i * packBits;
+                blockWordsData[1 + bit / 32] |= value << (bit % 32);
+                if (bit % 32 + packBits > 32) {
+                    blockWordsData[2 + bit / 32] |= value >> (32 - bit % 32);
+                }
+            }
+            overflowCount += overflow ? 1 : 0;
+        }
+        }
+    }
+    return overflowCount;
+}
+
+void StorageCodec::decode(const cl_uint *words, const std::size_t &count, int32_t *values) const
+{
+    const std::size_t blockWords = getBlockWords();
+    const uint32_t packMask = (1U << packBits) - 1;
+    for (std::size_t first = 0; first < count; first += blockSize) {
+        const cl_uint *blockWordsData = words + first / blockSize * blockWords;
+        const std::size_t blockCount = std::min(blockSize, count - first);
+        uint32_t previous = blockWordsData[0];
+        for (std::size_t i = 0; i < blockCount; i++) {
+            // Half word of the 16 bit modes
+            const uint16_t bits = static_cast<uint16_t>(blockWordsData[i / 2] >> (16 * (i % 2)));
+            uint32_t value = 0;
+            switch (mode) {
+            case StorageMode::Int32:
+                value = blockWordsData[i];
+                break;
+            case StorageMode::Int16:
+                value = static_cast<uint32_t>(static_cast<int16_t>(bits));
+                break;
+            case StorageMode::Half:
+                value = static_cast<uint32_t>(convertSaturated(halfToFloat(bits)));
+                break;
+            default: {
+                const std::size_t bit = i * packBits;
+                uint32_t offset = blockWordsData[1 + bit / 32] >> (bit % 32);
+                if (bit % 32 + packBits > 32) {
+                    offset |= blockWordsData[2 + bit / 32] << (32 - bit % 32);
+                }
+                offset &= packMask;
+                if (mode == StorageMode::Packed) {
+                    value = blockWordsData[0] + offset;
+                } else {
+                    previous += i == 0 ? 0 : (offset >> 1) ^ (0U - (offset & 1));
+                    value = previous;
+                }
+            }
+            }
+            values[first + i] = static_cast<int32_t>(value);
+        }
+    }
+}
+
+const std::size_t StorageCodec::getBlockWords() const
+{
+    switch (mode) {
+    case StorageMode::Int32:
+        return blockSize;
+    case StorageMode::Int16:
+    case StorageMode::Half:
+        return blockSize / 2;
+    default:
+        return 1 + blockSize * packBits / 32;
+    }
+}
+
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+// Include project headers
+#include "runtime.hpp"
+
+// Include stl libraries
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace clrt {
+
+// Formats of the compact storage of int arrays (same values as the STORAGE_ modes of "storage.cl"
+// in the kernel directory of the runtime, which also describes the layout of a block)
+enum class StorageMode {
+    // 4 bytes per element
+    Int32 = 0,
+    // 2 bytes per element: The lower 16 bits
+    Int16 = 1,
+    // 2 bytes per element: Half floats (exact up to 2048)
+    Half = 2,
+    // 4 + 4 * bits bytes per block: Smallest value and the offsets to it
+    Packed = 3,
+    // 4 + 4 * bits bytes per block: First value and the zigzag encoded differences
+    Delta = 4
+};
+
+// Host side of the compact storage: Kernels pack and unpack the blocks with storage.cl while the
+// host encodes and decodes the same bytes into a typed int view, so the transfers move 2-5x less
+// bytes per element (lossy for values that do not fit into the format)
+class StorageCodec
+{
+public:
+    // Elements per block
+    static constexpr std::size_t blockSize = 32;
+
+    // The packed bits (1 - 31) are only used by the packed and the delta mode
+    explicit StorageCodec(const StorageMode &mode = StorageMode::Int32,
+                          const unsigned int &packBits = 8);
+    // "int32", "int16", "half", "packed:BITS" or "delta:BITS"
+    static const bool parse(const std::string &text, StorageCodec &codec);
+
+    const StorageMode getMode() const;
+    const unsigned int getPackBits() const;
+    const std::string getName() const;
+    // Whole blocks are stored
+    const std::size_t getBlockCount(const std::size_t &count) const;
+    const std::size_t getStorageSize(const std::size_t &count) const;
+    const double getBytesPerElement() const;
+    // Set the constants of storage.cl (STORAGE_MODE, STORAGE_BLOCK and PACK_BITS)
+    void addConstants(Specialization &constants) const;
+
+    // Encode the values exactly like storage_store_block (the last block repeats the last
+    // value), the result is the number of blocks whose offsets or differences did not fit
+    const std::size_t encode(const int32_t *values, const std::size_t &count,
+                             std::vector<cl_uint> &words) const;
+    // Decode the values exactly like storage_load_block
+    void decode(const cl_uint *words, const std::size_t &count, int32_t *values) const;
+
+private:
+    const std::size_t getBlockWords() const;
+
+    StorageMode mode;
+    unsigned int packBits;
+};
+
+}
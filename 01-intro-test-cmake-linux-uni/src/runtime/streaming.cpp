@@ -0,0 +1,308 @@
+#include "streaming.hpp"
+
+// Include project headers
+#include "host_buffer.hpp"
+#include "trace.hpp"
+
+// Include stl libraries
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+// Bigger chunks do not improve the transfer rate but make filling/draining the pipeline slower
+constexpr std::size_t maxChunkSize = 256 * 1024 * 1024;
+
+const std::size_t getGreatestCommonDivisor(std::size_t a, std::size_t b)
+{
+    while (b != 0) {
+        const std::size_t remainder = a % b;
+        a = b;
+        b = remainder;
+    }
+    return a;
+}
+
+}
+
+namespace clrt {
+
+StreamingPipeline::StreamingPipeline(Runtime &runtime, const cl::Device &device,
+                                     const unsigned int &queueCount)
+    : deviceContext(runtime.getDeviceContext(device)), bufferPool(runtime.getBufferPool(device))
+{
+    for (unsigned int i = 0; i < std::max(2U, queueCount); i++) {
+        cl_int err = CL_SUCCESS;
+        queues.emplace_back(deviceContext.context, device, CL_QUEUE_PROFILING_ENABLE, &err);
+        if (err != CL_SUCCESS) {
+            reportError("CommandQueue::CommandQueue failed", err);
+        }
+    }
+}
+
+const std::size_t StreamingPipeline::getMaxChunkElementCount(const std::size_t &elementSize) const
+{
+    // Leave a quarter of the global memory to other allocations
+    const cl::Device &device = deviceContext.device;
+    const uint64_t globalMemSize = device.getInfo<CL_DEVICE_GLOBAL_MEM_SIZE>();
+    uint64_t chunkSize = std::min<uint64_t>(device.getInfo<CL_DEVICE_MAX_MEM_ALLOC_SIZE>(),
+                                            globalMemSize / 4 * 3 / queues.size());
+    chunkSize = std::min<uint64_t>(chunkSize, maxChunkSize);
+    return std::max<std::size_t>(1, static_cast<std::size_t>(chunkSize / elementSize));
+}
+
+const bool StreamingPipeline::run(Kernel &kernel, void *data, const std::size_t &elementSize,
+                                  const std::size_t &elementCount, std::size_t chunkElementCount,
+                                  StreamingStatistics &statistics)
+{
+    statistics = StreamingStatistics();
+    if (elementCount == 0) {
+        return true;
+    }
+    const std::size_t maxChunkElementCount = getMaxChunkElementCount(elementSize);
+    if (chunkElementCount == 0 || chunkElementCount > maxChunkElementCount) {
+        chunkElementCount = maxChunkElementCount;
+    }
+    chunkElementCount = std::min(chunkElementCount, elementCount);
+    const std::size_t chunkCount = (elementCount + chunkElementCount - 1) / chunkElementCount;
+    statistics.chunkCount = chunkCount;
+    statistics.chunkElementCount = chunkElementCount;
+
+    // Allocate one (ping-pong) buffer per queue (they are given back to the pool after the
+    // queues were finished)
+    std::vector<PooledBuffer> pooledBuffers(std::min(queues.size(), chunkCount));
+    std::vector<cl::Buffer> buffers;
+    for (auto &pooledBuffer : pooledBuffers) {
+        if (!bufferPool.acquire(chunkElementCount * elementSize, pooledBuffer)) {
+            return false;
+        }
+        buffers.push_back(pooledBuffer.get());
+    }
+
+    // Wait for the enqueued commands before the buffers are given back to the pool
+    const auto fail = [this]() {
+        for (auto const &queue : queues) {
+            queue.finish();
+        }
+        return false;
+    };
+
+    std::vector<cl::Event> writeEvents(chunkCount);
+    std::vector<cl::Event> kernelEvents(chunkCount);
+    std::vector<cl::Event> readEvents(chunkCount);
+    unsigned char *bytes = static_cast<unsigned char *>(data);
+    for (std::size_t chunk = 0; chunk < chunkCount; chunk++) {
+        const std::size_t slot = chunk % buffers.size();
+        const cl::CommandQueue &queue = queues[slot];
+        const cl::Buffer &buffer = buffers[slot];
+        const std::size_t offset = chunk * chunkElementCount;
+        const std::size_t count = std::min(chunkElementCount, elementCount - offset);
+        unsigned char *chunkData = bytes + offset * elementSize;
+
+        // The buffer of the slot can be overwritten when the chunk that used it before was read
+        // back (waiting here also limits the number of chunks that are in flight)
+        std::vector<cl::Event> writeWaitEvents;
+        if (chunk >= buffers.size()) {
+            writeWaitEvents.push_back(readEvents[chunk - buffers.size()]);
+            writeWaitEvents.back().wait();
+        }
+        cl_int err = queue.enqueueWriteBuffer(buffer, CL_FALSE, 0, count * elementSize, chunkData,
+                                              writeWaitEvents.empty() ? nullptr : &writeWaitEvents,
+                                              &writeEvents[chunk]);
+        if (err != CL_SUCCESS) {
+            reportError("CommandQueue::enqueueWriteBuffer failed", err);
+            return fail();
+        }
+        traceCommand("write chunk", &writeEvents[chunk]);
+
+        // Process the chunk when it was written
+        if (!kernel.setArg(0, buffer)) {
+            return fail();
+        }
+        const std::vector<cl::Event> kernelWaitEvents = { writeEvents[chunk] };
+        err = queue.enqueueNDRangeKernel(kernel.get(), cl::NDRange(offset), cl::NDRange(count),
+                                         cl::NullRange, &kernelWaitEvents, &kernelEvents[chunk]);
+        if (err != CL_SUCCESS) {
+            reportError("CommandQueue::enqueueNDRangeKernel failed", err);
+            return fail();
+        }
+        traceCommand("process chunk", &kernelEvents[chunk]);
+
+        // Read the chunk back when it was processed
+        const std::vector<cl::Event> readWaitEvents = { kernelEvents[chunk] };
+        err = queue.enqueueReadBuffer(buffer, CL_FALSE, 0, count * elementSize, chunkData,
+                                      &readWaitEvents, &readEvents[chunk]);
+        if (err != CL_SUCCESS) {
+            reportError("CommandQueue::enqueueReadBuffer failed", err);
+            return fail();
+        }
+        traceCommand("read chunk", &readEvents[chunk]);
+        queue.flush();
+    }
+    for (auto const &queue : queues) {
+        queue.finish();
+    }
+
+    addEventTimes(writeEvents, kernelEvents, readEvents, statistics);
+    return true;
+}
+
+const bool StreamingPipeline::runFile(Kernel &kernel, const MappedFile &input,
+                                      const MappedFile &output, const std::size_t &elementSize,
+                                      std::size_t chunkElementCount,
+                                      StreamingStatistics &statistics)
+{
+    statistics = StreamingStatistics();
+    if (!input.isOpen() || !output.isWritable() || output.getSize() < input.getSize()) {
+        reportError("StreamingPipeline::runFile: The output file has to be writable and at least "
+                    "as big as the input file");
+        return false;
+    }
+    const std::size_t elementCount = static_cast<std::size_t>(input.getSize() / elementSize);
+    if (elementCount == 0) {
+        return true;
+    }
+    const std::size_t maxChunkElementCount = getMaxChunkElementCount(elementSize);
+    if (chunkElementCount == 0 || chunkElementCount > maxChunkElementCount) {
+        chunkElementCount = maxChunkElementCount;
+    }
+    // Every chunk has to start at a multiple of the mapping granularity (which also makes the
+    // mapped ranges page aligned for zero copy buffers)
+    const std::size_t granularity = MappedFile::getGranularity();
+    const std::size_t chunkAlignment = granularity / getGreatestCommonDivisor(granularity,
+                                                                              elementSize);
+    chunkElementCount = std::max(chunkAlignment, chunkElementCount / chunkAlignment
+                                 * chunkAlignment);
+    chunkElementCount = std::min(chunkElementCount, elementCount);
+    const std::size_t chunkCount = (elementCount + chunkElementCount - 1) / chunkElementCount;
+    statistics.chunkCount = chunkCount;
+    statistics.chunkElementCount = chunkElementCount;
+    const bool unifiedMemory = deviceContext.device.getInfo<CL_DEVICE_HOST_UNIFIED_MEMORY>();
+
+    // Mapped ranges and buffer of a (ping-pong) slot, they are replaced when the slot is used
+    // for the next chunk after the chunk before was finished
+    struct Slot {
+        MappedRange inputRange;
+        MappedRange outputRange;
+        // Buffer that uses the mapped output range (zero copy) or a buffer of the pool
+        cl::Buffer hostBuffer;
+        PooledBuffer pooledBuffer;
+    };
+    std::vector<Slot> slots(std::min(queues.size(), chunkCount));
+    const auto fail = [this]() {
+        for (auto const &queue : queues) {
+            queue.finish();
+        }
+        return false;
+    };
+
+    std::vector<cl::Event> writeEvents(chunkCount);
+    std::vector<cl::Event> kernelEvents(chunkCount);
+    std::vector<cl::Event> readEvents(chunkCount);
+    for (std::size_t chunk = 0; chunk < chunkCount; chunk++) {
+        const std::size_t slotIndex = chunk % slots.size();
+        Slot &slot = slots[slotIndex];
+        const cl::CommandQueue &queue = queues[slotIndex];
+        const std::size_t offset = chunk * chunkElementCount;
+        const std::size_t count = std::min(chunkElementCount, elementCount - offset);
+        const std::size_t size = count * elementSize;
+
+        // Wait until the chunk before is in the output file, then map the ranges of this chunk
+        // (the previous ranges are unmapped so only the ranges in flight use host memory)
+        if (chunk >= slots.size()) {
+            readEvents[chunk - slots.size()].wait();
+        }
+        slot.hostBuffer = cl::Buffer();
+        const uint64_t fileOffset = static_cast<uint64_t>(offset) * elementSize;
+        if (!input.map(fileOffset, size, slot.inputRange)
+            || !output.map(fileOffset, size, slot.outputRange)) {
+            return fail();
+        }
+        void *outputData = slot.outputRange.getData();
+        cl_int err = CL_SUCCESS;
+        if (unifiedMemory && reinterpret_cast<uintptr_t>(outputData) % hostMemoryAlignment == 0) {
+            slot.hostBuffer = cl::Buffer(deviceContext.context,
+                                         CL_MEM_READ_WRITE | CL_MEM_USE_HOST_PTR, size,
+                                         outputData, &err);
+            if (err != CL_SUCCESS) {
+                slot.hostBuffer = cl::Buffer();
+            }
+        }
+        const bool zeroCopy = slot.hostBuffer() != nullptr;
+        if (!zeroCopy && !slot.pooledBuffer.isValid()
+            && !bufferPool.acquire(chunkElementCount * elementSize, slot.pooledBuffer)) {
+            return fail();
+        }
+        const cl::Buffer &buffer = zeroCopy ? slot.hostBuffer : slot.pooledBuffer.get();
+
+        // Write the chunk directly from the mapped input range
+        err = queue.enqueueWriteBuffer(buffer, CL_FALSE, 0, size, slot.inputRange.getData(),
+                                       nullptr, &writeEvents[chunk]);
+        if (err != CL_SUCCESS) {
+            reportError("CommandQueue::enqueueWriteBuffer failed", err);
+            return fail();
+        }
+        traceCommand("write file chunk", &writeEvents[chunk]);
+
+        if (!kernel.setArg(0, buffer)) {
+            return fail();
+        }
+        const std::vector<cl::Event> kernelWaitEvents = { writeEvents[chunk] };
+        err = queue.enqueueNDRangeKernel(kernel.get(), cl::NDRange(offset), cl::NDRange(count),
+                                         cl::NullRange, &kernelWaitEvents, &kernelEvents[chunk]);
+        if (err != CL_SUCCESS) {
+            reportError("CommandQueue::enqueueNDRangeKernel failed", err);
+            return fail();
+        }
+        traceCommand("process file chunk", &kernelEvents[chunk]);
+
+        // Zero copy: Map and unmap the buffer so the results are visible in the mapped output
+        // range, otherwise read them into it
+        const std::vector<cl::Event> readWaitEvents = { kernelEvents[chunk] };
+        if (zeroCopy) {
+            void *mappedData = queue.enqueueMapBuffer(buffer, CL_FALSE, CL_MAP_READ, 0, size,
+                                                      &readWaitEvents, nullptr, &err);
+            if (err == CL_SUCCESS) {
+                err = queue.enqueueUnmapMemObject(buffer, mappedData, nullptr, &readEvents[chunk]);
+            }
+            statistics.zeroCopyChunkCount++;
+        } else {
+            err = queue.enqueueReadBuffer(buffer, CL_FALSE, 0, size, outputData, &readWaitEvents,
+                                          &readEvents[chunk]);
+        }
+        if (err != CL_SUCCESS) {
+            reportError(zeroCopy ? "CommandQueue::enqueueMapBuffer/enqueueUnmapMemObject failed"
+                        : "CommandQueue::enqueueReadBuffer failed", err);
+            return fail();
+        }
+        traceCommand("read file chunk", &readEvents[chunk]);
+        queue.flush();
+    }
+    for (auto const &queue : queues) {
+        queue.finish();
+    }
+
+    addEventTimes(writeEvents, kernelEvents, readEvents, statistics);
+    return true;
+}
+
+void StreamingPipeline::addEventTimes(const std::vector<cl::Event> &writeEvents,
+                                      const std::vector<cl::Event> &kernelEvents,
+                                      const std::vector<cl::Event> &readEvents,
+                                      StreamingStatistics &statistics) const
+{
+    uint64_t firstStartNs = std::numeric_limits<uint64_t>::max();
+    uint64_t lastEndNs = 0;
+    for (std::size_t chunk = 0; chunk < writeEvents.size(); chunk++) {
+        statistics.writeNs += getEventDurationNs(writeEvents[chunk]);
+        statistics.kernelNs += getEventDurationNs(kernelEvents[chunk]);
+        statistics.readNs += getEventDurationNs(readEvents[chunk]);
+        firstStartNs = std::min<uint64_t>(firstStartNs,
+                                          writeEvents[chunk].getProfilingInfo<CL_PROFILING_COMMAND_START>());
+        lastEndNs = std::max<uint64_t>(lastEndNs,
+                                       readEvents[chunk].getProfilingInfo<CL_PROFILING_COMMAND_END>());
+    }
+    statistics.wallNs = lastEndNs > firstStartNs ? lastEndNs - firstStartNs : 0;
+}
+
+}
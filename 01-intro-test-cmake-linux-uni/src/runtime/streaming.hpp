@@ -0,0 +1,70 @@
+#pragma once
+
+// Include project headers
+#include "mapped_file.hpp"
+#include "runtime.hpp"
+
+// Include stl libraries
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace clrt {
+
+// Profiling results of a streaming run (times are the sums over all chunks)
+struct StreamingStatistics {
+    std::size_t chunkCount = 0;
+    std::size_t chunkElementCount = 0;
+    // Chunks that the kernel processed directly in the mapped output file (CL_MEM_USE_HOST_PTR)
+    std::size_t zeroCopyChunkCount = 0;
+    uint64_t writeNs = 0;
+    uint64_t kernelNs = 0;
+    uint64_t readNs = 0;
+    // Time between the start of the first and the end of the last command on the device
+    uint64_t wallNs = 0;
+};
+
+// Processes arrays of any size (also bigger than CL_DEVICE_MAX_MEM_ALLOC_SIZE) in chunks:
+// Every chunk is written into one of several ping-pong device buffers, processed and read back
+// while the chunks before/after it are transferred on other command queues
+//
+// The kernel gets the chunk buffer as argument 0 and is launched with the global offset of the
+// chunk so it has to index its buffer with get_global_id(0) - get_global_offset(0)
+class StreamingPipeline
+{
+public:
+    // Use at least 2 (ping-pong) queues/buffers, 3 are needed to overlap write/kernel/read
+    StreamingPipeline(Runtime &runtime, const cl::Device &device,
+                      const unsigned int &queueCount = 3);
+
+    // Get the biggest chunk that fits all chunk buffers into the device memory
+    const std::size_t getMaxChunkElementCount(const std::size_t &elementSize) const;
+
+    // Process the elementCount elements of the host data with the kernel
+    // (if the chunk element count is 0 the max chunk element count is used)
+    const bool run(Kernel &kernel, void *data, const std::size_t &elementSize,
+                   const std::size_t &elementCount, std::size_t chunkElementCount,
+                   StreamingStatistics &statistics);
+    // Process the elements of a memory mapped input file and write the results into a memory
+    // mapped output file (that is at least as big) without copying the file into host memory:
+    // Every chunk is written from the mapped input range, on devices that share their memory
+    // with the host the kernel works directly in the mapped output range, otherwise the chunk
+    // is read back into it (chunks start at multiples of the mapping granularity)
+    const bool runFile(Kernel &kernel, const MappedFile &input, const MappedFile &output,
+                       const std::size_t &elementSize, std::size_t chunkElementCount,
+                       StreamingStatistics &statistics);
+
+private:
+    // Sum up the times of the commands of all chunks
+    void addEventTimes(const std::vector<cl::Event> &writeEvents,
+                       const std::vector<cl::Event> &kernelEvents,
+                       const std::vector<cl::Event> &readEvents,
+                       StreamingStatistics &statistics) const;
+
+    DeviceContext &deviceContext;
+    // The chunk buffers of every run are taken from the buffer pool of the context
+    BufferPool &bufferPool;
+    std::vector<cl::CommandQueue> queues;
+};
+
+}
@@ -0,0 +1,221 @@
+#include "task_graph.hpp"
+
+// Include project headers
+#include "trace.hpp"
+
+// Include stl libraries
+#include <algorithm>
+#include <string>
+
+namespace {
+
+constexpr clrt::TaskId noTask = static_cast<clrt::TaskId>(-1);
+
+}
+
+namespace clrt {
+
+TaskGraph::TaskGraph(DeviceContext &deviceContext, const unsigned int &queueCount)
+{
+    cl_int err = CL_SUCCESS;
+    const cl_command_queue_properties queueProperties =
+        deviceContext.device.getInfo<CL_DEVICE_QUEUE_ON_HOST_PROPERTIES>();
+    if (queueProperties & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE) {
+        queues.emplace_back(deviceContext.context, deviceContext.device,
+                            CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE | CL_QUEUE_PROFILING_ENABLE,
+                            &err);
+        outOfOrder = err == CL_SUCCESS;
+        if (outOfOrder) {
+            return;
+        }
+        queues.clear();
+    }
+    for (unsigned int i = 0; i < std::max(1U, queueCount); i++) {
+        queues.emplace_back(deviceContext.context, deviceContext.device, CL_QUEUE_PROFILING_ENABLE,
+                            &err);
+        if (err != CL_SUCCESS) {
+            reportError("CommandQueue::CommandQueue failed", err);
+        }
+    }
+    lastTasks.assign(queues.size(), noTask);
+}
+
+TaskGraph::~TaskGraph()
+{
+    wait();
+}
+
+const bool TaskGraph::isOutOfOrder() const
+{
+    return outOfOrder;
+}
+
+const bool TaskGraph::addWrite(const cl::Buffer &buffer, const void *data, const std::size_t &size,
+                               const std::vector<TaskId> &dependencies, TaskId &task,
+                               const std::size_t &offset)
+{
+    std::vector<cl::Event> waitEvents;
+    std::size_t queueIndex = 0;
+    if (!prepareTask(dependencies, waitEvents, queueIndex)) {
+        return false;
+    }
+    cl::Event event;
+    const cl_int err = queues[queueIndex].enqueueWriteBuffer(buffer, CL_FALSE, offset, size, data,
+                                                             &waitEvents, &event);
+    return finishTask(err, "enqueueWriteBuffer", queueIndex, event, task);
+}
+
+const bool TaskGraph::addRead(const cl::Buffer &buffer, void *data, const std::size_t &size,
+                              const std::vector<TaskId> &dependencies, TaskId &task,
+                              const std::size_t &offset)
+{
+    std::vector<cl::Event> waitEvents;
+    std::size_t queueIndex = 0;
+    if (!prepareTask(dependencies, waitEvents, queueIndex)) {
+        return false;
+    }
+    cl::Event event;
+    const cl_int err = queues[queueIndex].enqueueReadBuffer(buffer, CL_FALSE, offset, size, data,
+                                                            &waitEvents, &event);
+    return finishTask(err, "enqueueReadBuffer", queueIndex, event, task);
+}
+
+const bool TaskGraph::addCopy(const cl::Buffer &source, const cl::Buffer &destination,
+                              const std::size_t &size, const std::vector<TaskId> &dependencies,
+                              TaskId &task)
+{
+    std::vector<cl::Event> waitEvents;
+    std::size_t queueIndex = 0;
+    if (!prepareTask(dependencies, waitEvents, queueIndex)) {
+        return false;
+    }
+    cl::Event event;
+    const cl_int err = queues[queueIndex].enqueueCopyBuffer(source, destination, 0, 0, size,
+                                                            &waitEvents, &event);
+    return finishTask(err, "enqueueCopyBuffer", queueIndex, event, task);
+}
+
+const bool TaskGraph::addKernel(Kernel &kernel, const cl::NDRange &global,
+                                const cl::NDRange &local, const std::vector<TaskId> &dependencies,
+                                TaskId &task, const cl::NDRange &offset)
+{
+    std::vector<cl::Event> waitEvents;
+    std::size_t queueIndex = 0;
+    if (!prepareTask(dependencies, waitEvents, queueIndex)) {
+        return false;
+    }
+    cl::Event event;
+    const cl_int err = queues[queueIndex].enqueueNDRangeKernel(kernel.get(), offset, global, local,
+                                                               &waitEvents, &event);
+    return finishTask(err, "enqueueNDRangeKernel", queueIndex, event, task);
+}
+
+const bool TaskGraph::addMarker(const std::vector<TaskId> &dependencies, TaskId &task)
+{
+    std::vector<cl::Event> waitEvents;
+    std::size_t queueIndex = 0;
+    if (!prepareTask(dependencies, waitEvents, queueIndex)) {
+        return false;
+    }
+    cl::Event event;
+    const cl_int err = queues[queueIndex].enqueueMarkerWithWaitList(&waitEvents, &event);
+    return finishTask(err, "enqueueMarkerWithWaitList", queueIndex, event, task);
+}
+
+std::shared_future<bool> TaskGraph::getFuture(const TaskId &task) const
+{
+    return tasks.at(task)->future;
+}
+
+const cl::Event &TaskGraph::getEvent(const TaskId &task) const
+{
+    return tasks.at(task)->event;
+}
+
+const bool TaskGraph::wait()
+{
+    bool success = true;
+    for (auto const &task : tasks) {
+        success = task->future.get() && success;
+    }
+    return success;
+}
+
+const bool TaskGraph::clear()
+{
+    const bool success = wait();
+    tasks.clear();
+    lastTasks.assign(lastTasks.size(), noTask);
+    return success;
+}
+
+void CL_CALLBACK TaskGraph::onTaskFinished(cl_event, cl_int status, void *userData)
+{
+    // The callback owns a reference to the task so that it stays valid even if the graph does not
+    const std::unique_ptr<std::shared_ptr<Task>> task(static_cast<std::shared_ptr<Task> *>
+                                                      (userData));
+    (*task)->promise.set_value(status == CL_COMPLETE);
+}
+
+const bool TaskGraph::prepareTask(const std::vector<TaskId> &dependencies,
+                                  std::vector<cl::Event> &waitEvents, std::size_t &queueIndex)
+{
+    for (const TaskId dependency : dependencies) {
+        if (dependency >= tasks.size()) {
+            reportError("TaskGraph dependency " + std::to_string(dependency) + " does not exist");
+            return false;
+        }
+        waitEvents.push_back(tasks[dependency]->event);
+    }
+    if (outOfOrder) {
+        queueIndex = 0;
+        return true;
+    }
+
+    // Continue a chain on the queue of its last command (the event wait is free there) and
+    // distribute independent commands across all queues so that they can overlap
+    const auto chainQueue = dependencies.empty() ? lastTasks.end()
+                            : std::find(lastTasks.begin(), lastTasks.end(), dependencies.front());
+    if (chainQueue != lastTasks.end()) {
+        queueIndex = static_cast<std::size_t>(chainQueue - lastTasks.begin());
+    } else {
+        queueIndex = nextQueueIndex;
+        nextQueueIndex = (nextQueueIndex + 1) % queues.size();
+    }
+    return true;
+}
+
+const bool TaskGraph::finishTask(const cl_int &err, const char *command,
+                                 const std::size_t &queueIndex, const cl::Event &event,
+                                 TaskId &task)
+{
+    if (err != CL_SUCCESS) {
+        reportError(std::string("CommandQueue::") + command + " failed", err);
+        return false;
+    }
+    traceCommand(command, &event);
+    const auto newTask = std::make_shared<Task>();
+    newTask->event = event;
+    newTask->future = newTask->promise.get_future().share();
+    std::unique_ptr<std::shared_ptr<Task>> callbackTask(new std::shared_ptr<Task>(newTask));
+    cl_int callbackErr = newTask->event.setCallback(CL_COMPLETE, &TaskGraph::onTaskFinished,
+                                                    callbackTask.get());
+    if (callbackErr == CL_SUCCESS) {
+        callbackTask.release();
+    } else {
+        reportError("Event::setCallback failed", callbackErr);
+        // Fall back to waiting for the command (the callback was not registered)
+        callbackErr = newTask->event.wait();
+        newTask->promise.set_value(callbackErr == CL_SUCCESS);
+    }
+    // Submit the command right away so that the device starts working and the future resolves
+    queues[queueIndex].flush();
+    task = tasks.size();
+    tasks.push_back(newTask);
+    if (!outOfOrder) {
+        lastTasks[queueIndex] = task;
+    }
+    return true;
+}
+
+}
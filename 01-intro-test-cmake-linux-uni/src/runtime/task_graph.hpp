@@ -0,0 +1,88 @@
+#pragma once
+
+// Include project headers
+#include "runtime.hpp"
+
+// Include stl libraries
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <vector>
+
+namespace clrt {
+
+// Identifier of a command of a task graph
+typedef std::size_t TaskId;
+
+// Asynchronous graph of transfers and kernels: Every command is enqueued immediately without
+// blocking the host and starts as soon as the commands it depends on are finished, commands
+// that do not depend on each other can run at the same time
+//
+// The commands are mapped onto one out of order queue if the device supports it and otherwise
+// onto multiple in order queues, in both cases the dependencies are event wait lists
+// The host can wait for single commands with their futures while the device is still running
+class TaskGraph
+{
+public:
+    // The queue count is only used if the device does not support out of order queues
+    explicit TaskGraph(DeviceContext &deviceContext, const unsigned int &queueCount = 3);
+    // Waits for all commands because they report their completion to the graph
+    ~TaskGraph();
+    TaskGraph(const TaskGraph &) = delete;
+    TaskGraph &operator=(const TaskGraph &) = delete;
+
+    const bool isOutOfOrder() const;
+
+    // The host data has to stay valid until the command is finished
+    const bool addWrite(const cl::Buffer &buffer, const void *data, const std::size_t &size,
+                        const std::vector<TaskId> &dependencies, TaskId &task,
+                        const std::size_t &offset = 0);
+    const bool addRead(const cl::Buffer &buffer, void *data, const std::size_t &size,
+                       const std::vector<TaskId> &dependencies, TaskId &task,
+                       const std::size_t &offset = 0);
+    const bool addCopy(const cl::Buffer &source, const cl::Buffer &destination,
+                       const std::size_t &size, const std::vector<TaskId> &dependencies,
+                       TaskId &task);
+    // The kernel arguments are captured when the kernel is added, so the same kernel can be
+    // added multiple times with different arguments
+    const bool addKernel(Kernel &kernel, const cl::NDRange &global, const cl::NDRange &local,
+                         const std::vector<TaskId> &dependencies, TaskId &task,
+                         const cl::NDRange &offset = cl::NullRange);
+    // Command that finishes when all of its dependencies are finished
+    const bool addMarker(const std::vector<TaskId> &dependencies, TaskId &task);
+
+    // Future that is true when the command finished successfully
+    std::shared_future<bool> getFuture(const TaskId &task) const;
+    const cl::Event &getEvent(const TaskId &task) const;
+    // Wait for all commands (returns false if one of them failed)
+    const bool wait();
+    // Wait for all commands and remove them from the graph
+    const bool clear();
+
+private:
+    struct Task {
+        cl::Event event;
+        std::promise<bool> promise;
+        std::shared_future<bool> future;
+    };
+
+    static void CL_CALLBACK onTaskFinished(cl_event event, cl_int status, void *userData);
+    // Select the queue of a command and the events it has to wait for (fails if a dependency
+    // does not exist or could not be enqueued)
+    const bool prepareTask(const std::vector<TaskId> &dependencies,
+                           std::vector<cl::Event> &waitEvents, std::size_t &queueIndex);
+    // Add the enqueued command to the graph
+    const bool finishTask(const cl_int &err, const char *command, const std::size_t &queueIndex,
+                          const cl::Event &event, TaskId &task);
+
+    std::vector<cl::CommandQueue> queues;
+    bool outOfOrder = false;
+    // Shared with the completion callbacks that may run after the graph was cleared
+    std::vector<std::shared_ptr<Task>> tasks;
+    // Last command of every in order queue (chains of commands stay on the same queue)
+    std::vector<TaskId> lastTasks;
+    std::size_t nextQueueIndex = 0;
+};
+
+}
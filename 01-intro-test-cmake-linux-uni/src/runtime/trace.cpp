@@ -0,0 +1,327 @@
+#include "trace.hpp"
+
+// Include project headers
+#include "runtime.hpp"
+
+// Include stl libraries
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+// Sequence of a slot that is being written
+constexpr uint64_t busySequence = std::numeric_limits<uint64_t>::max();
+
+// Small thread numbers instead of the thread ids of the system
+const uint32_t getTraceThreadId()
+{
+    static std::atomic<uint32_t> nextThreadId(0);
+    thread_local const uint32_t threadId = nextThreadId.fetch_add(1);
+    return threadId;
+}
+
+// Finished device command with its timestamps in the device clock
+struct DeviceCommand {
+    uint64_t index;
+    std::string name;
+    std::size_t deviceIndex;
+    std::size_t queueIndex;
+    uint64_t hostEnqueueNs;
+    cl_ulong queuedNs;
+    cl_ulong submitNs;
+    cl_ulong startNs;
+    cl_ulong endNs;
+};
+
+const bool getCommandTimes(const cl::Event &event, DeviceCommand &command)
+{
+    cl_int status = CL_QUEUED;
+    if (event.getInfo(CL_EVENT_COMMAND_EXECUTION_STATUS, &status) != CL_SUCCESS
+        || status != CL_COMPLETE) {
+        return false;
+    }
+    // Fails if the queue does not have profiling enabled
+    return event.getProfilingInfo(CL_PROFILING_COMMAND_QUEUED, &command.queuedNs) == CL_SUCCESS
+           && event.getProfilingInfo(CL_PROFILING_COMMAND_SUBMIT, &command.submitNs) == CL_SUCCESS
+           && event.getProfilingInfo(CL_PROFILING_COMMAND_START, &command.startNs) == CL_SUCCESS
+           && event.getProfilingInfo(CL_PROFILING_COMMAND_END, &command.endNs) == CL_SUCCESS;
+}
+
+// Chrome traces use microseconds
+const std::string toMicroseconds(const int64_t &timeNs)
+{
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(3) << static_cast<double>(timeNs) / 1000.0;
+    return text.str();
+}
+
+}
+
+namespace clrt {
+
+Tracer &Tracer::getInstance()
+{
+    static Tracer tracer;
+    return tracer;
+}
+
+Tracer::Tracer()
+    : enabled(false), nextIndex(0), droppedCount(0), epoch(std::chrono::steady_clock::now())
+{
+}
+
+Tracer::~Tracer()
+{
+    releaseRecords();
+}
+
+void Tracer::enable(const std::size_t &capacity)
+{
+    enabled.store(false);
+    releaseRecords();
+    this->capacity = std::max<std::size_t>(1, capacity);
+    records.reset(new Record[this->capacity]);
+    for (std::size_t i = 0; i < this->capacity; i++) {
+        records[i].sequence.store(0, std::memory_order_relaxed);
+        records[i].event = nullptr;
+    }
+    nextIndex.store(0);
+    droppedCount.store(0);
+    enabled.store(true);
+}
+
+void Tracer::disable()
+{
+    enabled.store(false);
+}
+
+const bool Tracer::isEnabled() const
+{
+    return enabled.load(std::memory_order_relaxed);
+}
+
+const uint64_t Tracer::now() const
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - epoch).count();
+}
+
+void Tracer::recordSpan(const char *name, const char *category, const uint64_t &beginNs,
+                        const uint64_t &endNs)
+{
+    if (!isEnabled()) {
+        return;
+    }
+    uint64_t index = 0;
+    Record *record = beginRecord(index, name);
+    if (record == nullptr) {
+        return;
+    }
+    record->category = category;
+    record->beginNs = beginNs;
+    record->endNs = endNs;
+    record->sequence.store(index + 1, std::memory_order_release);
+}
+
+void Tracer::recordCommand(const char *name, const cl::Event &event)
+{
+    if (!isEnabled() || event() == nullptr) {
+        return;
+    }
+    uint64_t index = 0;
+    Record *record = beginRecord(index, name);
+    if (record == nullptr) {
+        return;
+    }
+    record->category = "device";
+    record->beginNs = now();
+    record->endNs = record->beginNs;
+    record->event = event();
+    clRetainEvent(record->event);
+    record->sequence.store(index + 1, std::memory_order_release);
+}
+
+const uint64_t Tracer::getDroppedCount() const
+{
+    return droppedCount.load();
+}
+
+const bool Tracer::writeChromeTrace(const std::string &fileName) const
+{
+    // Collect the complete records in the order they were recorded
+    std::vector<const Record *> completeRecords;
+    for (std::size_t i = 0; i < capacity; i++) {
+        const uint64_t sequence = records[i].sequence.load(std::memory_order_acquire);
+        if (sequence != 0 && sequence != busySequence) {
+            completeRecords.push_back(&records[i]);
+        }
+    }
+    std::sort(completeRecords.begin(), completeRecords.end(),
+    [](const Record * first, const Record * second) {
+        return first->sequence.load() < second->sequence.load();
+    });
+
+    // Resolve the device commands, every device is a process and every queue a thread of it
+    std::vector<cl::Device> devices;
+    std::vector<std::vector<cl_command_queue>> deviceQueues;
+    std::vector<DeviceCommand> commands;
+    for (const Record *record : completeRecords) {
+        if (record->event == nullptr) {
+            continue;
+        }
+        const cl::Event event(record->event, true);
+        DeviceCommand command;
+        command.index = record->sequence.load();
+        command.name = record->name;
+        command.hostEnqueueNs = record->beginNs;
+        cl::CommandQueue queue;
+        cl::Device device;
+        if (!getCommandTimes(event, command)
+            || event.getInfo(CL_EVENT_COMMAND_QUEUE, &queue) != CL_SUCCESS
+            || queue.getInfo(CL_QUEUE_DEVICE, &device) != CL_SUCCESS) {
+            continue;
+        }
+        command.deviceIndex = std::find_if(devices.begin(), devices.end(),
+        [&](const cl::Device & knownDevice) {
+            return knownDevice() == device();
+        }) - devices.begin();
+        if (command.deviceIndex == devices.size()) {
+            devices.push_back(device);
+            deviceQueues.emplace_back();
+        }
+        std::vector<cl_command_queue> &queues = deviceQueues[command.deviceIndex];
+        command.queueIndex = std::find(queues.begin(), queues.end(), queue()) - queues.begin();
+        if (command.queueIndex == queues.size()) {
+            queues.push_back(queue());
+        }
+        commands.push_back(command);
+    }
+
+    // The device clocks are not the host clock: A command is queued shortly before the enqueue
+    // call returns, so the smallest difference of both times is the best offset of a device
+    std::vector<int64_t> deviceOffsetsNs(devices.size(), std::numeric_limits<int64_t>::max());
+    for (auto const &command : commands) {
+        const int64_t offsetNs = static_cast<int64_t>(command.hostEnqueueNs)
+                                 - static_cast<int64_t>(command.queuedNs);
+        deviceOffsetsNs[command.deviceIndex] = std::min(deviceOffsetsNs[command.deviceIndex],
+                                                        offsetNs);
+    }
+
+    std::ofstream file(fileName, std::ios::out | std::ios::trunc);
+    if (!file) {
+        reportError("Trace file \"" + fileName + "\" could not be written");
+        return false;
+    }
+    file << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n"
+         << "  {\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 0, "
+         << "\"args\": {\"name\": \"Host\"}}";
+    for (std::size_t deviceIndex = 0; deviceIndex < devices.size(); deviceIndex++) {
+        const cl::Device &device = devices[deviceIndex];
+        file << ",\n  {\"name\": \"process_name\", \"ph\": \"M\", \"pid\": " << deviceIndex + 1
+             << ", \"args\": {\"name\": \""
+             << escapeJson(trimInfoString(device.getInfo<CL_DEVICE_NAME>())) << "\"}}";
+        for (std::size_t queueIndex = 0; queueIndex < deviceQueues[deviceIndex].size();
+             queueIndex++) {
+            file << ",\n  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " << deviceIndex + 1
+                 << ", \"tid\": " << queueIndex << ", \"args\": {\"name\": \"Queue " << queueIndex
+                 << "\"}}";
+        }
+    }
+    for (const Record *record : completeRecords) {
+        if (record->event != nullptr) {
+            continue;
+        }
+        file << ",\n  {\"name\": \"" << escapeJson(record->name) << "\", \"cat\": \""
+             << escapeJson(record->category) << "\", \"ph\": \"X\", \"pid\": 0, \"tid\": "
+             << record->threadId << ", \"ts\": " << toMicroseconds(record->beginNs)
+             << ", \"dur\": " << toMicroseconds(record->endNs - record->beginNs) << "}";
+    }
+    for (auto const &command : commands) {
+        const int64_t offsetNs = deviceOffsetsNs[command.deviceIndex];
+        file << ",\n  {\"name\": \"" << escapeJson(command.name)
+             << "\", \"cat\": \"device\", \"ph\": \"X\", \"pid\": " << command.deviceIndex + 1
+             << ", \"tid\": " << command.queueIndex
+             << ", \"ts\": " << toMicroseconds(static_cast<int64_t>(command.startNs) + offsetNs)
+             << ", \"dur\": " << toMicroseconds(command.endNs - command.startNs)
+             << ", \"args\": {\"queued\": "
+             << toMicroseconds(static_cast<int64_t>(command.queuedNs) + offsetNs)
+             << ", \"queuedToSubmitUs\": " << toMicroseconds(command.submitNs - command.queuedNs)
+             << ", \"submitToStartUs\": " << toMicroseconds(command.startNs - command.submitNs)
+             << "}}";
+    }
+    file << "\n]}\n";
+    return static_cast<bool>(file);
+}
+
+Tracer::Record *Tracer::beginRecord(uint64_t &index, const char *name)
+{
+    index = nextIndex.fetch_add(1, std::memory_order_relaxed);
+    Record &record = records[index % capacity];
+    // Only one thread can own a slot: The record is skipped if the slot is written by another
+    // thread (only happens when the ring buffer wraps around) or already holds a newer record
+    uint64_t sequence = record.sequence.load(std::memory_order_relaxed);
+    if (sequence == busySequence || sequence > index
+        || !record.sequence.compare_exchange_strong(sequence, busySequence,
+                                                    std::memory_order_acquire)) {
+        droppedCount.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    // The oldest record is overwritten
+    if (sequence != 0) {
+        droppedCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (record.event != nullptr) {
+        clReleaseEvent(record.event);
+        record.event = nullptr;
+    }
+    std::strncpy(record.name, name, traceNameLength - 1);
+    record.name[traceNameLength - 1] = '\0';
+    record.threadId = getTraceThreadId();
+    return &record;
+}
+
+void Tracer::releaseRecords()
+{
+    for (std::size_t i = 0; i < capacity; i++) {
+        if (records[i].event != nullptr) {
+            clReleaseEvent(records[i].event);
+            records[i].event = nullptr;
+        }
+    }
+}
+
+TraceSpan::TraceSpan(const char *name, const char *category)
+    : name(name), category(category), active(Tracer::getInstance().isEnabled()),
+      beginNs(active ? Tracer::getInstance().now() : 0)
+{
+}
+
+TraceSpan::~TraceSpan()
+{
+    if (active) {
+        Tracer &tracer = Tracer::getInstance();
+        tracer.recordSpan(name, category, beginNs, tracer.now());
+    }
+}
+
+cl::Event *getTraceEvent(cl::Event *event, cl::Event &localEvent)
+{
+    if (event != nullptr) {
+        return event;
+    }
+    return Tracer::getInstance().isEnabled() ? &localEvent : nullptr;
+}
+
+void traceCommand(const char *name, const cl::Event *event)
+{
+    if (event != nullptr) {
+        Tracer::getInstance().recordCommand(name, *event);
+    }
+}
+
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+// TARGET OPENCL 2.0
+#ifndef CL_HPP_TARGET_OPENCL_VERSION
+#define CL_HPP_TARGET_OPENCL_VERSION 200
+#endif
+#include <CL/cl2.hpp>
+
+// Include stl libraries
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace clrt {
+
+// Longer names of records are truncated
+constexpr std::size_t traceNameLength = 48;
+
+// Timeline of host spans and device commands that can be exported as Chrome trace JSON (open it
+// with chrome://tracing or https://ui.perfetto.dev) to see queue gaps, overlapping transfers and
+// kernels and host stalls
+//
+// The records are written into a fixed size ring buffer without locks (an atomic counter
+// reserves the slots, the oldest records are overwritten when it is full)
+// Device commands only keep their event: Their profiling timestamps (QUEUED, SUBMIT, START, END)
+// are queried on export so recording never waits for the device
+// Tracing is disabled by default and then costs one atomic load per command
+class Tracer
+{
+public:
+    // Tracer of the process that is used by the runtime library
+    static Tracer &getInstance();
+
+    // Allocate the ring buffer and start recording (removes all previous records), call it
+    // before other threads record
+    void enable(const std::size_t &capacity = 65536);
+    void disable();
+    const bool isEnabled() const;
+
+    // Host time since the creation of the tracer
+    const uint64_t now() const;
+    // The category has to stay valid as long as the tracer (e.g. a string literal)
+    void recordSpan(const char *name, const char *category, const uint64_t &beginNs,
+                    const uint64_t &endNs);
+    // The command has to be enqueued into a queue with profiling enabled
+    void recordCommand(const char *name, const cl::Event &event);
+
+    // Number of records that were overwritten or skipped because the ring buffer was full
+    const uint64_t getDroppedCount() const;
+    // Write all records of finished commands and spans, other threads must not record meanwhile
+    const bool writeChromeTrace(const std::string &fileName) const;
+
+private:
+    struct Record {
+        // Index of the record + 1 when it is complete (0 = empty, maximum = being written)
+        std::atomic<uint64_t> sequence;
+        char name[traceNameLength];
+        const char *category;
+        uint32_t threadId;
+        // Host spans: begin and end, device commands: host time when the command was enqueued
+        uint64_t beginNs;
+        uint64_t endNs;
+        // Retained event of a device command (null for host spans)
+        cl_event event;
+    };
+
+    Tracer();
+    ~Tracer();
+    Tracer(const Tracer &) = delete;
+    Tracer &operator=(const Tracer &) = delete;
+
+    // Reserve the next slot and mark it as being written (null if the record is skipped)
+    Record *beginRecord(uint64_t &index, const char *name);
+    void releaseRecords();
+
+    std::atomic<bool> enabled;
+    std::atomic<uint64_t> nextIndex;
+    std::atomic<uint64_t> droppedCount;
+    std::unique_ptr<Record[]> records;
+    std::size_t capacity = 0;
+    const std::chrono::steady_clock::time_point epoch;
+};
+
+// Records the lifetime of a scope as a host span (if tracing is enabled)
+class TraceSpan
+{
+public:
+    explicit TraceSpan(const char *name, const char *category = "host");
+    ~TraceSpan();
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+
+private:
+    const char *name;
+    const char *category;
+    const bool active;
+    const uint64_t beginNs;
+};
+
+// Event pointer for an enqueue call: The event of the caller, a local event if the caller did not
+// request one but tracing is enabled, otherwise none
+cl::Event *getTraceEvent(cl::Event *event, cl::Event &localEvent);
+// Record a command if tracing is enabled (does nothing without an event)
+void traceCommand(const char *name, const cl::Event *event);
+
+}
@@ -0,0 +1,256 @@
+#include "tuner.hpp"
+
+// Include stl libraries
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <set>
+#include <sstream>
+
+namespace {
+
+const cl::NDRange createRange(const unsigned int &dimensions, const std::size_t *sizes)
+{
+    switch (dimensions) {
+    case 1:
+        return cl::NDRange(sizes[0]);
+    case 2:
+        return cl::NDRange(sizes[0], sizes[1]);
+    case 3:
+        return cl::NDRange(sizes[0], sizes[1], sizes[2]);
+    default:
+        return cl::NullRange;
+    }
+}
+
+const bool isSameRange(const cl::NDRange &a, const cl::NDRange &b)
+{
+    if (a.dimensions() != b.dimensions()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < a.dimensions(); i++) {
+        if (a.get()[i] != b.get()[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+namespace clrt {
+
+WorkGroupTuner::WorkGroupTuner(const std::string &databaseDirectory)
+    : databasePath(databaseDirectory + "/work_group_sizes.txt")
+{
+    createDirectory(databaseDirectory);
+    load();
+}
+
+const bool WorkGroupTuner::lookup(Kernel &kernel, const std::string &kernelName,
+                                  const cl::NDRange &global, cl::NDRange &local)
+{
+    cl::NDRange storedLocal;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto entry = entries.find(getKey(kernel.getDeviceContext().device, kernelName,
+                                               global));
+        if (entry == entries.end()) {
+            return false;
+        }
+        storedLocal = createRange(entry->second.dimensions, entry->second.sizes);
+    }
+    for (const auto &candidate : getCandidates(kernel, global)) {
+        if (isSameRange(candidate, storedLocal)) {
+            local = storedLocal;
+            return true;
+        }
+    }
+    return false;
+}
+
+const bool WorkGroupTuner::tune(Kernel &kernel, const std::string &kernelName,
+                                const cl::NDRange &global, cl::NDRange &local,
+                                const unsigned int &repetitions)
+{
+    DeviceContext &deviceContext = kernel.getDeviceContext();
+    bool found = false;
+    uint64_t bestKernelNs = std::numeric_limits<uint64_t>::max();
+    for (const auto &candidate : getCandidates(kernel, global)) {
+        // The first run is a warm up, the fastest of the following runs counts
+        uint64_t candidateNs = std::numeric_limits<uint64_t>::max();
+        cl_int err = CL_SUCCESS;
+        for (unsigned int i = 0; i <= repetitions && err == CL_SUCCESS; i++) {
+            cl::Event event;
+            err = deviceContext.queue.enqueueNDRangeKernel(kernel.get(), cl::NullRange, global,
+                                                           candidate, nullptr, &event);
+            if (err == CL_SUCCESS) {
+                err = event.wait();
+            }
+            if (err == CL_SUCCESS && i > 0) {
+                candidateNs = std::min(candidateNs, getEventDurationNs(event));
+            }
+        }
+        // Candidates that the device rejects (e.g. not enough resources) are skipped
+        if (err == CL_SUCCESS && candidateNs < bestKernelNs) {
+            bestKernelNs = candidateNs;
+            local = candidate;
+            found = true;
+        }
+    }
+    if (!found) {
+        reportError("WorkGroupTuner::tune failed for the kernel " + kernelName);
+        return false;
+    }
+
+    TuningEntry entry;
+    entry.dimensions = static_cast<unsigned int>(local.dimensions());
+    for (unsigned int i = 0; i < entry.dimensions; i++) {
+        entry.sizes[i] = local.get()[i];
+    }
+    entry.kernelNs = bestKernelNs;
+    std::lock_guard<std::mutex> lock(mutex);
+    entries[getKey(deviceContext.device, kernelName, global)] = entry;
+    return save();
+}
+
+const bool WorkGroupTuner::lookupKernelTime(const cl::Device &device,
+                                            const std::string &kernelName,
+                                            const cl::NDRange &global, uint64_t &kernelNs)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto entry = entries.find(getKey(device, kernelName, global));
+    if (entry == entries.end()) {
+        return false;
+    }
+    kernelNs = entry->second.kernelNs;
+    return true;
+}
+
+const bool WorkGroupTuner::getLocalRange(Kernel &kernel, const std::string &kernelName,
+                                         const cl::NDRange &global, cl::NDRange &local)
+{
+    return lookup(kernel, kernelName, global, local)
+           || tune(kernel, kernelName, global, local);
+}
+
+const std::vector<cl::NDRange> WorkGroupTuner::getCandidates(Kernel &kernel,
+                                                             const cl::NDRange &global)
+{
+    const cl::Device &device = kernel.getDeviceContext().device;
+    const cl::Kernel &clKernel = kernel.get();
+    const std::size_t workGroupSize = clKernel.getWorkGroupInfo<CL_KERNEL_WORK_GROUP_SIZE>(device);
+    const std::size_t preferredMultiple = std::max<std::size_t>(
+            1, clKernel.getWorkGroupInfo<CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE>(device));
+    const auto maxItemSizes = device.getInfo<CL_DEVICE_MAX_WORK_ITEM_SIZES>();
+    const unsigned int dimensions = static_cast<unsigned int>(global.dimensions());
+
+    // The driver choice is always a candidate
+    std::vector<cl::NDRange> candidates = { cl::NullRange };
+    if (dimensions == 0 || dimensions > 3 || maxItemSizes.size() < dimensions) {
+        return candidates;
+    }
+
+    // Sizes per dimension: Powers of two and power of two multiples of the preferred multiple
+    std::vector<std::set<std::size_t>> sizes(3, std::set<std::size_t> { 1 });
+    for (unsigned int d = 0; d < dimensions; d++) {
+        const std::size_t maxSize = std::min(workGroupSize, maxItemSizes[d]);
+        for (std::size_t size = 1; size <= maxSize; size *= 2) {
+            if (global.get()[d] % size == 0) {
+                sizes[d].insert(size);
+            }
+        }
+        for (std::size_t size = preferredMultiple; size <= maxSize; size *= 2) {
+            if (global.get()[d] % size == 0) {
+                sizes[d].insert(size);
+            }
+        }
+    }
+
+    // Work groups that are smaller than the preferred multiple leave hardware lanes idle so they
+    // are only used if the global range does not allow bigger work groups
+    const auto addCandidates = [&](const std::size_t &minWorkGroupSize) {
+        for (const std::size_t x : sizes[0]) {
+            for (const std::size_t y : sizes[1]) {
+                for (const std::size_t z : sizes[2]) {
+                    const std::size_t total = x * y * z;
+                    if (total <= workGroupSize && total >= minWorkGroupSize) {
+                        const std::size_t candidate[3] = { x, y, z };
+                        candidates.push_back(createRange(dimensions, candidate));
+                    }
+                }
+            }
+        }
+    };
+    addCandidates(std::min(preferredMultiple, workGroupSize));
+    if (candidates.size() == 1) {
+        addCandidates(1);
+    }
+    return candidates;
+}
+
+const std::string WorkGroupTuner::getKey(const cl::Device &device, const std::string &kernelName,
+                                         const cl::NDRange &global) const
+{
+    return trimInfoString(device.getInfo<CL_DEVICE_NAME>()) + "|"
+           + trimInfoString(device.getInfo<CL_DRIVER_VERSION>()) + "|" + kernelName + "|"
+           + displayRange(global);
+}
+
+void WorkGroupTuner::load()
+{
+    // Format: One entry per line "key<TAB>dimensions<TAB>x<TAB>y<TAB>z<TAB>kernelNs"
+    std::ifstream file(databasePath);
+    std::string line;
+    while (std::getline(file, line)) {
+        const std::size_t separator = line.find('\t');
+        if (separator == std::string::npos) {
+            continue;
+        }
+        TuningEntry entry;
+        std::istringstream values(line.substr(separator + 1));
+        if (values >> entry.dimensions >> entry.sizes[0] >> entry.sizes[1] >> entry.sizes[2]
+            >> entry.kernelNs && entry.dimensions <= 3) {
+            entries[line.substr(0, separator)] = entry;
+        }
+    }
+}
+
+const bool WorkGroupTuner::save() const
+{
+    // Write a temporary file first so that a crash never leaves a partially written database
+    const std::string temporaryPath = databasePath + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::trunc);
+        for (const auto &entry : entries) {
+            file << entry.first << '\t' << entry.second.dimensions << '\t'
+                 << entry.second.sizes[0] << '\t' << entry.second.sizes[1] << '\t'
+                 << entry.second.sizes[2] << '\t' << entry.second.kernelNs << '\n';
+        }
+        if (!file) {
+            reportError("Work group size database could not be written: " + temporaryPath);
+            return false;
+        }
+    }
+    std::remove(databasePath.c_str());
+    if (std::rename(temporaryPath.c_str(), databasePath.c_str()) != 0) {
+        reportError("Work group size database could not be written: " + databasePath);
+        return false;
+    }
+    return true;
+}
+
+const std::string displayRange(const cl::NDRange &range)
+{
+    if (range.dimensions() == 0) {
+        return "NullRange";
+    }
+    std::string text;
+    for (std::size_t i = 0; i < range.dimensions(); i++) {
+        text += (i > 0 ? "x" : "") + std::to_string(range.get()[i]);
+    }
+    return text;
+}
+
+}
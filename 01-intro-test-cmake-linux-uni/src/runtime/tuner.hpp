@@ -0,0 +1,64 @@
+#pragma once
+
+// Include project headers
+#include "runtime.hpp"
+
+// Include stl libraries
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace clrt {
+
+// Local range that was measured to be the fastest for a kernel
+struct TuningEntry {
+    // Dimensions of the local range (0 = cl::NullRange, the driver chooses the local range)
+    unsigned int dimensions = 0;
+    std::size_t sizes[3] = { 1, 1, 1 };
+    uint64_t kernelNs = 0;
+};
+
+// Finds the fastest local range (work group size and 1D/2D shape) of a kernel by running it
+// with all valid candidates and stores the result per device, driver, kernel and global range
+// in a database file so that later launches can use it without tuning again
+class WorkGroupTuner
+{
+public:
+    explicit WorkGroupTuner(const std::string &databaseDirectory = "cache");
+
+    // Get the stored local range (returns false if the kernel was not tuned yet on its device or
+    // if the stored range is not valid anymore, e.g. because the kernel was changed)
+    const bool lookup(Kernel &kernel, const std::string &kernelName, const cl::NDRange &global,
+                      cl::NDRange &local);
+    // Time all local range candidates (the kernel arguments have to be set already) and store
+    // the fastest one in the database
+    const bool tune(Kernel &kernel, const std::string &kernelName, const cl::NDRange &global,
+                    cl::NDRange &local, const unsigned int &repetitions = 3);
+    // Get the kernel time of the stored local range (e.g. to compare variants of a kernel)
+    const bool lookupKernelTime(const cl::Device &device, const std::string &kernelName,
+                                const cl::NDRange &global, uint64_t &kernelNs);
+    // Get the stored local range or tune the kernel if there is none
+    const bool getLocalRange(Kernel &kernel, const std::string &kernelName,
+                             const cl::NDRange &global, cl::NDRange &local);
+
+    // Get all local ranges that are valid for the kernel on its device
+    static const std::vector<cl::NDRange> getCandidates(Kernel &kernel,
+                                                        const cl::NDRange &global);
+
+private:
+    const std::string getKey(const cl::Device &device, const std::string &kernelName,
+                             const cl::NDRange &global) const;
+    void load();
+    const bool save() const;
+
+    std::string databasePath;
+    std::map<std::string, TuningEntry> entries;
+    std::mutex mutex;
+};
+
+// Display a range as "XxYxZ" (or "NullRange")
+const std::string displayRange(const cl::NDRange &range);
+
+}
@@ -1,19 +1,47 @@
-int compute_factorial(int n)
+// The factorial is a compile time constant (-DFACTORIAL=...) so the device compiler folds the
+// loop and every work item only adds a constant
+int compute_factorial(const unsigned int n)
 {
-	int factorial = 1;
+	// Unsigned multiplications wrap around like the host code instead of overflowing
+	unsigned int factorial = 1;
 
-	for (int i = 1; i <= n; i++)
+	for (unsigned int i = 1; i <= n; i++)
 	{
 		factorial *= i;
 	}
-	return factorial;
+	return (int)factorial;
 }
 
-__kernel void kernelSimple (__global int* device_output, const unsigned int factorial) {
+__kernel void kernelSimple (__global int* device_output) {
 	const unsigned int x = get_global_id(0);
 	const unsigned int y = get_global_id(1);
 	const unsigned int x_size = get_global_size(0);
 	const unsigned int y_size = get_global_size(1);
 	const unsigned int currentPixel = x + y * x_size;
-	device_output[currentPixel] = currentPixel + compute_factorial(factorial);
-}
\ No newline at end of file
+	device_output[currentPixel] = currentPixel + compute_factorial(FACTORIAL);
+}
+
+// Same values as kernelSimple for a 1D range where every work item writes VECTOR_WIDTH (4, 8 or 16)
+// elements with one vector store, the last work item writes the rest one by one
+#if defined(VECTOR_WIDTH) && VECTOR_WIDTH > 1
+#define CONCAT_NAME(a, b) a ## b
+#define VECTOR_NAME(a, b) CONCAT_NAME(a, b)
+#if VECTOR_WIDTH == 4
+#define VECTOR_LANES (int4)(0, 1, 2, 3)
+#elif VECTOR_WIDTH == 8
+#define VECTOR_LANES (int8)(0, 1, 2, 3, 4, 5, 6, 7)
+#else
+#define VECTOR_LANES (int16)(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15)
+#endif
+__kernel void kernelSimpleVector (__global int* device_output, const unsigned int count) {
+	const unsigned int first = get_global_id(0) * VECTOR_WIDTH;
+	const int factorial = compute_factorial(FACTORIAL);
+	if (first + VECTOR_WIDTH <= count) {
+		VECTOR_NAME(vstore, VECTOR_WIDTH)(VECTOR_LANES + (int)first + factorial, get_global_id(0), device_output);
+	} else {
+		for (unsigned int i = first; i < count; i++) {
+			device_output[i] = i + factorial;
+		}
+	}
+}
+#endif
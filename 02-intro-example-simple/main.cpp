@@ -1,44 +1,38 @@
 // For CMake
 #pragma GCC diagnostic ignored "-Wignored-attributes"
 
-#define USE_OPENCL_1_2
-
-#ifndef USE_OPENCL_1_2
-// TARGET OPENCL 2.0
-#include <CL/cl2.hpp>
-#else
-// TARGET OPENCL 1.2
-#define CL_USE_DEPRECATED_OPENCL_1_2_APIS
-#include <CL/cl.hpp>
-#endif
+// Include the OpenCL runtime library (platform/device discovery, contexts, queues and programs)
+#include "benchmark.hpp"
+#include "device_registry.hpp"
+#include "host_engine.hpp"
+#include "runtime.hpp"
+#include "tuner.hpp"
 
 #include <cmath>
 #include <vector>
 #include <iostream>
 #include <string>
 #include <limits>
-#include <fstream>
 #include <random>
 #include <chrono>
 
-int compute_factorial(const int& n)
+int compute_factorial(const unsigned int& n)
 {
-	int factorial = 1;
+	// Unsigned multiplications wrap around (like the kernel) instead of overflowing
+	unsigned int factorial = 1;
 
-	for (int i = 1; i <= n; i++)
+	for (unsigned int i = 1; i <= n; i++)
 	{
 		factorial *= i;
 	}
-	return factorial;
+	return static_cast<int>(factorial);
 }
 
 
-void calculateHost(std::vector<int>& host_output, const unsigned int& factorial)
+void calculateHost(clrt::HostEngine& hostEngine, std::vector<int>& host_output, const unsigned int& factorial)
 {
-	for (std::size_t i = 0; i < host_output.size(); i++) {
-		host_output[i] = static_cast<int>(i) + compute_factorial(factorial);
-	}
-
+	// The factorial is the same for every element so calculate it only once
+	hostEngine.fillIndices(host_output, compute_factorial(factorial));
 }
 
 int main()
@@ -63,152 +57,123 @@ int main()
 	// | CPU / HOST      |
 	// -------------------
 
-	// Run the host code
-	std::cout << "Run the host code" << std::endl;
-	const std::chrono::steady_clock::time_point cpu_calculation_begin = std::chrono::steady_clock::now();
-	calculateHost(host_output, factorial);
-	const std::chrono::steady_clock::time_point cpu_calculation_end = std::chrono::steady_clock::now();
+	// Every time is the median of 10 repetitions after 2 untimed warm up runs (the first runs
+	// include the driver/JIT initialization, page faults of the first memory access and cold caches)
+	clrt::Benchmark benchmark(2, 10);
+
+	// Run the host code (multithreaded and vectorized to get a realistic CPU baseline)
+	clrt::HostEngine hostEngine;
+	std::cout << "Run the host code (" << hostEngine.getThreadCount() << " threads, " << clrt::HostEngine::getSimdName() << ")" << std::endl;
+	clrt::BenchmarkStatistics cpu_calculation;
+	benchmark.run({ "host calculation", size, count }, [&](uint64_t& timeNs) {
+		const std::chrono::steady_clock::time_point cpu_calculation_begin = std::chrono::steady_clock::now();
+		calculateHost(hostEngine, host_output, factorial);
+		const std::chrono::steady_clock::time_point cpu_calculation_end = std::chrono::steady_clock::now();
+		timeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(cpu_calculation_end - cpu_calculation_begin).count();
+		return true;
+	}, cpu_calculation);
 
 	// Calculate duration
-	const auto cpu_calculation_time_nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(cpu_calculation_end - cpu_calculation_begin).count();
-	std::cout << "CPU time:\n\tCalculation: " << cpu_calculation_time_nanoseconds << "ns" << std::endl;
-	const auto cpu_time_nanoseconds = cpu_calculation_time_nanoseconds;
+	std::cout << "CPU time:\n\tCalculation: " << clrt::displayStatistics(cpu_calculation) << std::endl;
+	const auto cpu_time_nanoseconds = cpu_calculation.medianNs;
 
 	// -------------------
 	// | GPU / DEVICE    |
 	// -------------------
 
-	const char* platformName = "Intel(R) OpenCL";
-	const char* deviceName = "Intel(R) Iris(TM) Graphics 550";
-
-	// Get all platforms
-	std::vector<cl::Platform> platforms;
-	cl::Platform::get(&platforms);
-	// Check if there is a platform
-	if (platforms.size() == 0) {
-		std::cerr << "No OpenCL platforms found" << std::endl;
+	// Select the fastest GPU that can hold the output (or any other device if there is none) by its
+	// capabilities instead of its name, the capabilities are stored in a snapshot file so later runs
+	// do not have to query them again (the kernel file is read from the current directory)
+	clrt::Runtime runtime(".", "cache");
+	clrt::DeviceRegistry registry(runtime, "cache");
+	if (!registry.discover()) {
 		return EXIT_FAILURE;
 	}
-	// Find the correct platform index
-	std::size_t platformId = -1;
-	for (std::size_t i = 0; i < platforms.size(); i++) {
-		std::string currentPlatform = platforms[i].getInfo<CL_PLATFORM_NAME>();
-		currentPlatform = currentPlatform.substr(0, currentPlatform.size() - 1);
-		if (currentPlatform == platformName) {
-			platformId = i;
-			break;
+	std::cout << "Device discovery: " << registry.getDevices().size() << " device(s) in " << registry.getDiscoveryNs() << "ns (" << registry.getSnapshotHitCount() << " from the snapshot file)" << std::endl;
+	clrt::DeviceQuery query;
+	query.type = CL_DEVICE_TYPE_GPU;
+	query.minGlobalMemorySize = size;
+	cl::Device device;
+	if (!registry.select(query, device)) {
+		query.type = CL_DEVICE_TYPE_ALL;
+		if (!registry.select(query, device)) {
+			return EXIT_FAILURE;
 		}
 	}
-	if (platformId < 0) {
-		std::cerr << "No \"" << platformName << "\" OpenCL platform found" << std::endl;
-		return EXIT_FAILURE;
-	}
-	const cl::Platform platform = platforms[platformId];
+	const cl::Platform platform(device.getInfo<CL_DEVICE_PLATFORM>());
 	std::cout << "Using platform " << platform.getInfo<CL_PLATFORM_NAME>()
 		<< " from " << platform.getInfo<CL_PLATFORM_VENDOR>()
 		<< " with OpenCL version: " << platform.getInfo<CL_PLATFORM_VERSION>() << std::endl;
-
-	// Get all GPU devices of the platform
-	std::vector<cl::Device> devices;
-	platforms[platformId].getDevices(CL_DEVICE_TYPE_GPU, &devices);
-	// Check if there is a device
-	if (devices.size() == 0) {
-		std::cerr << "No OpenCL devices found" << std::endl;
-		return EXIT_FAILURE;
-	}
-	// Find the iGPU
-	std::size_t deviceId = -1;
-	for (std::size_t i = 0; i < devices.size(); i++) {
-		std::string currentDevice = devices[i].getInfo<CL_DEVICE_NAME>();
-		currentDevice = currentDevice.substr(0, currentDevice.size() - 1);
-		if (currentDevice == deviceName) {
-			deviceId = i;
-			break;
-		}
-	}
-	if (deviceId < 0) {
-		std::cerr << "No \"" << deviceName << "\"  OpenCL device found" << std::endl;
-		return EXIT_FAILURE;
-	}
-	const cl::Device device = devices[deviceId];
 	std::cout << "Using device " << device.getInfo<CL_DEVICE_NAME>()
 		<< "from " << device.getInfo<CL_DEVICE_VENDOR>()
 		<< "with OpenCL version: " << device.getInfo<CL_DEVICE_VERSION>()
-		<< "and the maximum work group size is " << device.getInfo<CL_DEVICE_MAX_WORK_GROUP_SIZE>()
-		<< " (currently using wgSizeX=" << wgSizeX << "x" <<wgSizeY <<"=wgSizeY = " << (wgSizeX * wgSizeY) << " workgroups)" << std::endl;
-
-	// Create a context
-	cl_int err;
-	cl::Context context({ device }, nullptr, nullptr, nullptr, &err);
-	if (err != CL_SUCCESS) {
-		std::cerr << "Context::Context failed" << std::endl;
-		std::cin.get();
-		return EXIT_FAILURE;
-	}
-	// Read in the kernel from the kernel file
-	std::ifstream kerneFile("kernel.cl");
-	std::string kernelContent((std::istreambuf_iterator<char>(kerneFile)), (std::istreambuf_iterator<char>()));
-	cl::Program::Sources sources;
-	sources.push_back({ kernelContent.c_str(), kernelContent.length() });
-	// Build it
-	cl::Program program(context, sources, &err);
-	if (err != CL_SUCCESS) {
-		std::cerr << "Program::Program failed" << std::endl;
-		std::cin.get();
-		return EXIT_FAILURE;
-	}
-	auto programBuildError = program.build("-cl-std=CL1.2");
-	// Check if building the kerne was successful
-	if (programBuildError != CL_SUCCESS) {
-		std::cerr << "Program build error" << std::endl;
-		std::cin.get();
+		<< "and the maximum work group size is " << device.getInfo<CL_DEVICE_MAX_WORK_GROUP_SIZE>() << std::endl;
+
+	// Write 4, 8 or 16 elements per work item with vector stores if the device prefers int vectors
+	// (CPU devices with SIMD units), otherwise one element per work item of a 2D range
+	const cl_uint preferredWidth = device.getInfo<CL_DEVICE_PREFERRED_VECTOR_WIDTH_INT>();
+	const unsigned int vectorWidth = preferredWidth >= 16 ? 16 : preferredWidth >= 8 ? 8 : preferredWidth >= 4 ? 4 : 1;
+	const char* kernelName = vectorWidth > 1 ? "kernelSimpleVector" : "kernelSimple";
+	std::cout << "Using the kernel " << kernelName << " with the vector width " << vectorWidth << std::endl;
+
+	// Get the context and command queue of the device and build the kernel file specialized for the
+	// factorial (it is a define instead of a kernel argument so the compiler can fold the loop)
+	clrt::DeviceContext& deviceContext = runtime.getDeviceContext(device);
+	clrt::Program program;
+	if (!runtime.buildSpecializedProgram(device, { "kernel.cl" }, clrt::Specialization().set("FACTORIAL", factorial).set("VECTOR_WIDTH", vectorWidth), program, "-cl-std=CL1.2")) {
 		return EXIT_FAILURE;
 	}
 
-	// Create buffer for output
-	cl::Buffer device_output_buffer(context, CL_MEM_READ_WRITE, size);
-
-	// Create a command queue
-	cl::CommandQueue queue(context, device, CL_QUEUE_PROFILING_ENABLE, &err);
-	if (err != CL_SUCCESS) {
-		std::cerr << "CommandQueue error" << std::endl;
-		std::cin.get();
+	// Get a buffer for the output from the buffer pool of the device
+	clrt::PooledBuffer device_output_buffer;
+	if (!runtime.getBufferPool(device).acquire(size, device_output_buffer)) {
 		return EXIT_FAILURE;
 	}
 
-	// Create kernel
-	cl::Kernel kernel(program, "kernelSimple", &err);
-	if (err != CL_SUCCESS) {
-		std::cerr << "Kernel::Kernel failed" << std::endl;
-		std::cin.get();
+	// Create kernel and set the arguments for the kernel
+	clrt::Kernel kernel;
+	if (!program.createKernel(kernelName, kernel)
+		|| !kernel.setArg<cl::Buffer>(0, device_output_buffer.get())
+		|| (vectorWidth > 1 && !kernel.setArg(1, static_cast<cl_uint>(count)))) {
 		return EXIT_FAILURE;
 	}
-	// Set the arguments for the kernel
-	kernel.setArg<cl::Buffer>(0, device_output_buffer);
-	kernel.setArg<cl_uint>(1, factorial);
-
-	// Launch the kernel
-	cl::Event eventGpuCalculation;
-	err = queue.enqueueNDRangeKernel(kernel, 0, cl::NDRange(countX, countY), cl::NDRange(wgSizeX, wgSizeY), NULL, &eventGpuCalculation);
-	if (err != CL_SUCCESS) {
-		std::cerr << "queue::enqueueNDRangeKernel failed" << std::endl;
-		std::cin.get();
+
+	// Use the fastest work group size (1D/2D shape) for this device, it is searched on the first run
+	// and then loaded from the tuning database
+	const cl::NDRange global = vectorWidth > 1 ? cl::NDRange((count + vectorWidth - 1) / vectorWidth) : cl::NDRange(countX, countY);
+	cl::NDRange local;
+	clrt::WorkGroupTuner tuner("cache");
+	if (!tuner.getLocalRange(kernel, kernelName, global, local)) {
 		return EXIT_FAILURE;
 	}
-	const auto gpu_calculation_time_nanoseconds = eventGpuCalculation.getProfilingInfo<CL_PROFILING_COMMAND_END>() - eventGpuCalculation.getProfilingInfo<CL_PROFILING_COMMAND_START>();
-
-	// Read out what the device wrote in memory
-	cl::Event eventGpuWriteBack;
-	err = queue.enqueueReadBuffer(device_output_buffer, true, 0, size, device_output.data(), NULL, &eventGpuWriteBack);
-	if (err != CL_SUCCESS) {
-		std::cerr << "queue::enqueueReadBuffer failed" << std::endl;
-		std::cin.get();
+	std::cout << "Using the work group size " << clrt::displayRange(local) << std::endl;
+
+	// Launch the kernel and read out what the device wrote in memory
+	benchmark.setDevice(device);
+	std::vector<clrt::BenchmarkStatistics> gpu_statistics;
+	const bool success = benchmark.run({ { "device calculation", size, count }, { "device write back", size, 0 } }, [&](std::vector<uint64_t>& phaseNs) {
+		cl::Event eventGpuCalculation;
+		if (!kernel.enqueue(global, local, NULL, &eventGpuCalculation)) {
+			return false;
+		}
+		cl::Event eventGpuWriteBack;
+		const cl_int err = deviceContext.queue.enqueueReadBuffer(device_output_buffer.get(), true, 0, size, device_output.data(), NULL, &eventGpuWriteBack);
+		if (err != CL_SUCCESS) {
+			clrt::reportError("queue::enqueueReadBuffer failed", err);
+			return false;
+		}
+		phaseNs[0] = clrt::getEventDurationNs(eventGpuCalculation);
+		phaseNs[1] = clrt::getEventDurationNs(eventGpuWriteBack);
+		return true;
+	}, gpu_statistics);
+	if (!success) {
 		return EXIT_FAILURE;
 	}
-	const auto gpu_write_back_time_nanoseconds = eventGpuWriteBack.getProfilingInfo<CL_PROFILING_COMMAND_END>() - eventGpuWriteBack.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+	const auto gpu_calculation_time_nanoseconds = gpu_statistics[0].medianNs;
+	const auto gpu_write_back_time_nanoseconds = gpu_statistics[1].medianNs;
 	const auto opencl_time_nanoseconds = gpu_calculation_time_nanoseconds + gpu_write_back_time_nanoseconds;
 
-	std::cout << "GPU time:\n\tCalculation: " << gpu_calculation_time_nanoseconds << "ns\n\tWrite back: " << gpu_write_back_time_nanoseconds << "ns" << std::endl;
+	std::cout << "GPU time:\n\tCalculation: " << clrt::displayStatistics(gpu_statistics[0]) << "\n\tWrite back: " << clrt::displayStatistics(gpu_statistics[1]) << std::endl;
 
 	// Check results
 	unsigned int errors = 0;
@@ -228,7 +193,6 @@ int main()
 	if (errors == 0) {
 		std::cout << "Success, all values are correct" << std::endl;
 		// TODO: There is currently no speed up, check this later on a PC with a real GPU?
-		// TODO: Kernel event time is in Visual Studio 0 and in CMake executable really big
 		std::cout << "Speed comparison: CPU=" << cpu_time_nanoseconds
 			<< "ns vs GPU=" << opencl_time_nanoseconds
 			<< "ns (=> Speedup: " << ((double)cpu_time_nanoseconds / opencl_time_nanoseconds) << ")" << std::endl;
@@ -239,4 +203,3 @@ int main()
 		return EXIT_FAILURE;
 	}
 }
-